@@ -0,0 +1,175 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./miniJSON.h"
+#include "./thread_pool.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  Shared state of a parse_batch() call. The inputs are split into chunks
+  that the calling thread and the tasks on the executor take in turn, so the
+  batch completes even if the executor runs no task before the call returns
+  (e.g. when parse_batch() is called from a worker of a busy thread pool).
+*/
+template <typename JSONNode>
+struct batch_state {
+  batch_state(const std::vector<std::string> &inputs,
+              std::vector<JSONNode> *results,
+              std::vector<parse_result> *errors, const parse_options &options,
+              size_t chunk_size)
+      : inputs(inputs),
+        results(results),
+        errors(errors),
+        options(options),
+        chunk_size(chunk_size),
+        chunks((inputs.size() + chunk_size - 1) / chunk_size) {}
+
+  /*
+    Parse chunks until none is left. The parser state is the thread local
+    parser of each thread, so it is reused between chunks and batches.
+  */
+  void run() {
+    size_t done = 0;
+    for (size_t chunk = next.fetch_add(1); chunk < chunks;
+         chunk = next.fetch_add(1)) {
+      size_t end = std::min(inputs.size(), (chunk + 1) * chunk_size);
+      for (size_t i = chunk * chunk_size; i < end; i++) {
+        (*errors)[i] = parse(inputs[i], &(*results)[i], options);
+      }
+      done++;
+    }
+    if (done == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    finished += done;
+    if (finished == chunks) {
+      finished_cv.notify_all();
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished_cv.wait(lock, [this] { return finished == chunks; });
+  }
+
+  const std::vector<std::string> &inputs;
+  std::vector<JSONNode> *results;
+  std::vector<parse_result> *errors;
+  parse_options options;
+  size_t chunk_size;
+  size_t chunks;
+  std::atomic<size_t> next{0};  // the next chunk to parse
+  size_t finished = 0;          // parsed chunks, guarded by mutex
+  std::mutex mutex;
+  std::condition_variable finished_cv;
+};
+
+/*
+  Keep T out of template argument deduction, so that lambdas convert to
+  std::function parameters
+*/
+template <typename T>
+struct non_deduced {
+  using type = T;
+};
+}  // namespace detail
+
+/*
+  Parse independent JSON strings in parallel. results[i] is assigned the
+  JSON node of inputs[i] if it is valid and the returned parse_result at
+  index i holds its error otherwise, as with parse(s, &json). Tasks are
+  submitted to the executor and the calling thread parses too, until the
+  whole batch is parsed. Every thread reuses its thread local parser.
+*/
+template <typename JSONNode = json_node>
+inline std::vector<parse_result> parse_batch(
+    const std::vector<std::string> &inputs, std::vector<JSONNode> *results,
+    const executor &exec, const parse_options &options = parse_options(),
+    size_t tasks = std::thread::hardware_concurrency()) {
+  std::vector<parse_result> errors(inputs.size());
+  results->clear();
+  results->resize(inputs.size());
+  if (inputs.empty()) {
+    return errors;
+  }
+  tasks = std::max<size_t>(tasks, 1);
+  // a few chunks per task balance uneven documents without contention
+  size_t chunk_size = std::max<size_t>(inputs.size() / (tasks * 4), 1);
+  auto state = std::make_shared<detail::batch_state<JSONNode>>(
+      inputs, results, &errors, options, chunk_size);
+  for (size_t i = 1; i < std::min(tasks, state->chunks); i++) {
+    exec([state] { state->run(); });
+  }
+  state->run();
+  state->wait();
+  return errors;
+}
+
+/*
+  Parse independent JSON strings in parallel on the thread pool
+*/
+template <typename JSONNode = json_node>
+inline std::vector<parse_result> parse_batch(
+    const std::vector<std::string> &inputs, std::vector<JSONNode> *results,
+    thread_pool &pool, const parse_options &options = parse_options()) {
+  return parse_batch(inputs, results, pool.get_executor(), options,
+                     pool.size() + 1);
+}
+
+/*
+  Parse a JSON string on the executor and invoke the callback with the parse
+  result and the JSON node, which is null if parsing failed, on the thread
+  that parsed it.
+*/
+template <typename JSONNode = json_node>
+inline void parse_async(
+    std::string s, const executor &exec,
+    typename detail::non_deduced<
+        std::function<void(const parse_result &, JSONNode &&)>>::type callback,
+    const parse_options &options = parse_options()) {
+  auto input = std::make_shared<std::string>(std::move(s));
+  exec([input, callback, options] {
+    JSONNode json;
+    parse_result result = parse(*input, &json, options);
+    callback(result, std::move(json));
+  });
+}
+
+/*
+  Parse a JSON string on the executor. The future holds the JSON node, or
+  json_parse_error if the JSON string format is invalid.
+*/
+template <typename JSONNode = json_node>
+inline std::future<JSONNode> parse_async(
+    std::string s, const executor &exec,
+    const parse_options &options = parse_options()) {
+  auto promise = std::make_shared<std::promise<JSONNode>>();
+  std::future<JSONNode> future = promise->get_future();
+  parse_async<JSONNode>(
+      std::move(s), exec,
+      [promise](const parse_result &result, JSONNode &&json) {
+        if (result) {
+          promise->set_value(std::move(json));
+        } else {
+          promise->set_exception(
+              std::make_exception_ptr(json_parse_error(result)));
+        }
+      },
+      options);
+  return future;
+}
+}  // namespace miniJSON
@@ -0,0 +1,353 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "../errors.h"
+#include "../json_types.h"
+#include "./simd.h"
+#include "./small_stack.h"
+#include "./utf8.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  Write a double number the way ECMAScript's Number.prototype.toString does,
+  as RFC 8785 requires: the shortest digits that round trip, in plain
+  notation for exponents in [-6, 21) and in exponent notation otherwise. The
+  output does not depend on the locale. Returns the number of characters
+  written to buf, which must hold at least 32 characters.
+*/
+inline size_t write_canonical_double(double d, char *buf) {
+  if (d == 0) {
+    buf[0] = '0';  // -0 too
+    return 1;
+  }
+  char *out = buf;
+  if (d < 0) {
+    *out++ = '-';
+    d = -d;
+  }
+  // find the shortest digits that round trip; the decimal point of %e may
+  // depend on the locale, so only the digits and the exponent are used
+  char text[32];
+  for (int precision = 1; precision <= 17; precision++) {
+    snprintf(text, sizeof(text), "%.*e", precision - 1, d);
+    if (strtod(text, nullptr) == d) {
+      break;
+    }
+  }
+  char digits[18];
+  int k = 0;
+  const char *p = text;
+  for (; *p != 'e'; p++) {
+    if (*p >= '0' && *p <= '9') {
+      digits[k++] = *p;
+    }
+  }
+  while (k > 1 && digits[k - 1] == '0') {
+    k--;
+  }
+  int n = atoi(p + 1) + 1;  // d = 0.digits * 10^n
+  if (k <= n && n <= 21) {
+    memcpy(out, digits, k);
+    out += k;
+    for (int i = k; i < n; i++) {
+      *out++ = '0';
+    }
+  } else if (0 < n && n <= 21) {
+    memcpy(out, digits, n);
+    out += n;
+    *out++ = '.';
+    memcpy(out, digits + n, k - n);
+    out += k - n;
+  } else if (-6 < n && n <= 0) {
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = n; i < 0; i++) {
+      *out++ = '0';
+    }
+    memcpy(out, digits, k);
+    out += k;
+  } else {
+    *out++ = digits[0];
+    if (k > 1) {
+      *out++ = '.';
+      memcpy(out, digits + 1, k - 1);
+      out += k - 1;
+    }
+    out += snprintf(out, 8, "e%c%d", n - 1 < 0 ? '-' : '+', std::abs(n - 1));
+  }
+  return static_cast<size_t>(out - buf);
+}
+
+/*
+  Get the code point of the UTF-8 sequence at p and its length in *length.
+  A byte that does not start a well-formed sequence is read as U+FFFD.
+*/
+inline uint32_t next_code_point(const char *p, const char *end,
+                                size_t *length) {
+  if (static_cast<unsigned char>(*p) < 0x80) {
+    *length = 1;
+    return static_cast<unsigned char>(*p);
+  }
+  *length = utf8_sequence_length(p, end);
+  if (*length == 0) {
+    *length = 1;
+    return 0xfffd;
+  }
+  return decode_utf8(p, *length);
+}
+
+/*
+  Compare two UTF-8 strings by their UTF-16 code units, the order of object
+  members in RFC 8785. It differs from the order of code points only where
+  characters beyond the BMP meet characters in [U+E000, U+FFFF].
+*/
+inline bool utf16_less(const char *a, size_t a_size, const char *b,
+                       size_t b_size) {
+  const char *a_end = a + a_size;
+  const char *b_end = b + b_size;
+  while (a < a_end && b < b_end) {
+    size_t a_length, b_length;
+    uint32_t x = next_code_point(a, a_end, &a_length);
+    uint32_t y = next_code_point(b, b_end, &b_length);
+    if (x != y) {
+      // the first code unit of a surrogate pair is in [0xd800, 0xdbff]
+      uint32_t x_unit = x >= 0x10000 ? 0xd800 + ((x - 0x10000) >> 10) : x;
+      uint32_t y_unit = y >= 0x10000 ? 0xd800 + ((y - 0x10000) >> 10) : y;
+      return x_unit != y_unit ? x_unit < y_unit : x < y;
+    }
+    a += a_length;
+    b += b_length;
+  }
+  return a == a_end && b != b_end;
+}
+
+template <typename JSONNode, typename Sink>
+/*
+  Canonical serializer writes JSON nodes in the JSON Canonicalization Scheme
+  (RFC 8785): no whitespace, object members sorted by the UTF-16 code units
+  of their keys, numbers written as ECMAScript doubles and strings with the
+  minimal escaping. Equal documents are written as the same bytes regardless
+  of member order, number type or locale. The output is written to the sink
+  in chunks through a fixed buffer, never as a whole.
+*/
+class canonical_serializer {
+ public:
+  explicit canonical_serializer(Sink *sink) : m_sink(sink) {}
+
+ public:
+  void serialize(const JSONNode &node) {
+    write(node);
+    flush();
+  }
+
+ private:
+  /*
+    A member of an object being written, which is sorted by its key
+  */
+  struct member {
+    const char *key;
+    size_t size;
+    const JSONNode *value;
+  };
+
+  /*
+    An array/object being written: the elements of an array are taken from
+    the node, the members of an object were sorted when it was opened
+  */
+  struct frame {
+    const JSONNode *node;
+    size_t index;
+    std::vector<member> members;
+  };
+
+  /*
+    Write the node and its descendants with an explicit stack of the
+    arrays/objects being written instead of recursion
+  */
+  void write(const JSONNode &root) {
+    const JSONNode *node = &root;
+    while (node != nullptr) {
+      write_value(*node);
+      node = nullptr;
+      while (node == nullptr && !m_frames.empty()) {
+        frame &f = m_frames.back();
+        bool array = f.node->m_type == json_value_type::array;
+        size_t size = array ? f.node->m_value.array->size() : f.members.size();
+        if (f.index == size) {
+          m_frames.pop_back();
+          put(array ? ']' : '}');
+          continue;
+        }
+        if (f.index != 0) {
+          put(',');
+        }
+        if (array) {
+          node = (*f.node->m_value.array)[f.index++];
+        } else {
+          const member &m = f.members[f.index++];
+          write_string(m.key, m.size);
+          put(':');
+          node = m.value;
+        }
+      }
+    }
+  }
+
+  /*
+    Write a scalar, or open an array/object
+  */
+  void write_value(const JSONNode &node) {
+    switch (node.m_type) {
+      case json_value_type::boolean:
+        node.m_value.boolean ? put("true", 4) : put("false", 5);
+        break;
+      case json_value_type::null:
+        put("null", 4);
+        break;
+      case json_value_type::string:
+        write_string(node.m_value.str->data(), node.m_value.str->size());
+        break;
+      case json_value_type::number_int:
+        write_number(static_cast<double>(node.number_int()));
+        break;
+      case json_value_type::number_double:
+        write_number(static_cast<double>(node.number_double()));
+        break;
+      case json_value_type::array:
+        put('[');
+        m_frames.push_back(frame{&node, 0, {}});
+        break;
+      case json_value_type::object: {
+        auto &object = *node.m_value.object;
+        std::vector<member> members;
+        members.reserve(object.size());
+        for (auto it = object.values_begin(); it != object.values_end();
+             it++) {
+          members.push_back(member{it.key().data(), it.key().size(), *it});
+        }
+        std::sort(members.begin(), members.end(),
+                  [](const member &a, const member &b) {
+                    return utf16_less(a.key, a.size, b.key, b.size);
+                  });
+        put('{');
+        m_frames.push_back(frame{&node, 0, std::move(members)});
+        break;
+      }
+      case json_value_type::indeterminate:
+        MINIJSON_THROW(json_type_error(
+            "JSON node has an indeterminate child. Access of the previously "
+            "non-existent element of object or array creates indeterminate "
+            "node."));
+      default:
+        MINIJSON_THROW(json_type_error("invalid type"));
+    }
+  }
+
+  void write_number(double d) {
+    if (std::isnan(d) || std::isinf(d)) {
+      MINIJSON_THROW(
+          json_type_error("NaN and Infinity have no canonical JSON form"));
+    }
+    char buf[32];
+    put(buf, write_canonical_double(d, buf));
+  }
+
+  /*
+    Write a string with only quotation marks, reverse solidi and control
+    characters escaped. Other characters are written as UTF-8; bytes that
+    are not well-formed UTF-8 are written as U+FFFD.
+  */
+  void write_string(const char *p, size_t size) {
+    static const char hex[] = "0123456789abcdef";
+    const char *end = p + size;
+    put('"');
+    while (p < end) {
+      const char *special = find_escape<true>(p, end);
+      put(p, static_cast<size_t>(special - p));
+      if (special == end) {
+        break;
+      }
+      p = special;
+      unsigned char c = static_cast<unsigned char>(*p);
+      if (c >= 0x80) {
+        size_t length = utf8_sequence_length(p, end);
+        length == 0 ? put("\xef\xbf\xbd", 3) : put(p, length);
+        p += length == 0 ? 1 : length;
+        continue;
+      }
+      switch (c) {
+        case '"':
+          put("\\\"", 2);
+          break;
+        case '\\':
+          put("\\\\", 2);
+          break;
+        case '\b':
+          put("\\b", 2);
+          break;
+        case '\f':
+          put("\\f", 2);
+          break;
+        case '\n':
+          put("\\n", 2);
+          break;
+        case '\r':
+          put("\\r", 2);
+          break;
+        case '\t':
+          put("\\t", 2);
+          break;
+        default: {
+          char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+          put(escape, sizeof(escape));
+          break;
+        }
+      }
+      p++;
+    }
+    put('"');
+  }
+
+  void put(char c) {
+    if (m_size == sizeof(m_buffer)) {
+      flush();
+    }
+    m_buffer[m_size++] = c;
+  }
+
+  void put(const char *data, size_t size) {
+    if (m_size + size > sizeof(m_buffer)) {
+      flush();
+      if (size >= sizeof(m_buffer)) {
+        (*m_sink)(data, size);
+        return;
+      }
+    }
+    memcpy(m_buffer + m_size, data, size);
+    m_size += size;
+  }
+
+  void flush() {
+    if (m_size != 0) {
+      (*m_sink)(m_buffer, m_size);
+      m_size = 0;
+    }
+  }
+
+ private:
+  Sink *m_sink;
+  small_stack<frame> m_frames;  // arrays/objects being written, innermost last
+  char m_buffer[4096];
+  size_t m_size = 0;  // bytes of m_buffer that are filled
+};
+}  // namespace detail
+}  // namespace miniJSON
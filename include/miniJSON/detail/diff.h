@@ -0,0 +1,185 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "../json_types.h"
+#include "./pointer.h"
+
+namespace miniJSON {
+namespace detail {
+template <typename JSONNode>
+/*
+  Differ is responsible for computing the JSON Patch (RFC 6902) that turns one
+  JSON node into another. Subtrees sharing the same value or having the same
+  structural hash are treated as identical and skipped without being compared
+  recursively, unless verify is set: equal hashes are then confirmed by
+  comparing the subtrees, which guards against hash collisions.
+*/
+class differ {
+ public:
+  differ(JSONNode *patch, bool verify) : m_patch(patch), m_verify(verify) {}
+
+ public:
+  /*
+    Append the operations turning source into target to the patch
+  */
+  void diff(const JSONNode &source, const JSONNode &target) {
+    string_t path;
+    diff(source, target, &path);
+  }
+
+ private:
+  using string_t = typename JSONNode::json_string_t;
+
+  void diff(const JSONNode &source, const JSONNode &target,
+            string_t *path) {
+    if (identical(source, target)) {
+      return;
+    }
+    if (source.m_type == json_value_type::object &&
+        target.m_type == json_value_type::object) {
+      diff_object(source, target, path);
+    } else if (source.m_type == json_value_type::array &&
+               target.m_type == json_value_type::array) {
+      diff_array(source, target, path);
+    } else {
+      emit("replace", *path, &target);
+    }
+  }
+
+  void diff_object(const JSONNode &source, const JSONNode &target,
+                   string_t *path) {
+    size_t length = path->size();
+    auto &source_object = *source.m_value.object;
+    auto &target_object = *target.m_value.object;
+    for (auto it = source_object.values_begin();
+         it != source_object.values_end(); it++) {
+      append_key(path, it.key());
+      auto child = target_object.find(it.key());
+      if (child == nullptr) {
+        emit("remove", *path, nullptr);
+      } else {
+        diff(**it, **child, path);
+      }
+      path->resize(length);
+    }
+    for (auto it = target_object.values_begin();
+         it != target_object.values_end(); it++) {
+      if (source_object.count(it.key()) == 0) {
+        append_key(path, it.key());
+        emit("add", *path, *it);
+        path->resize(length);
+      }
+    }
+  }
+
+  /*
+    Common leading and trailing elements are skipped, the remaining elements
+    are compared pairwise and the surplus is removed or added.
+  */
+  void diff_array(const JSONNode &source, const JSONNode &target,
+                  string_t *path) {
+    size_t length = path->size();
+    auto &source_array = *source.m_value.array;
+    auto &target_array = *target.m_value.array;
+    size_t begin = 0;
+    size_t source_end = source_array.size();
+    size_t target_end = target_array.size();
+    while (begin < source_end && begin < target_end &&
+           identical(*source_array[begin], *target_array[begin])) {
+      begin++;
+    }
+    while (source_end > begin && target_end > begin &&
+           identical(*source_array[source_end - 1],
+                     *target_array[target_end - 1])) {
+      source_end--;
+      target_end--;
+    }
+    size_t source_count = source_end - begin;
+    size_t target_count = target_end - begin;
+    for (size_t i = 0; i < std::min(source_count, target_count); i++) {
+      append_index(path, begin + i);
+      diff(*source_array[begin + i], *target_array[begin + i], path);
+      path->resize(length);
+    }
+    for (size_t i = target_count; i < source_count; i++) {
+      append_index(path, begin + target_count);
+      emit("remove", *path, nullptr);
+      path->resize(length);
+    }
+    for (size_t i = source_count; i < target_count; i++) {
+      append_index(path, begin + i);
+      emit("add", *path, target_array[begin + i]);
+      path->resize(length);
+    }
+  }
+
+  /*
+    Append an operation to the patch. The value is shared with the target
+    instead of being copied.
+  */
+  void emit(const char *op, const string_t &path, const JSONNode *value) {
+    JSONNode &operation = m_patch->emplace_back(json_value_type::object);
+    operation.insert("op", op);
+    operation.insert("path", path);
+    if (value != nullptr) {
+      operation.insert("value", value->share());
+    }
+  }
+
+  /*
+    Check if two values are equal by their structural hashes, or by sharing
+    the same value
+  */
+  bool identical(const JSONNode &a, const JSONNode &b) const {
+    if (a.m_type == b.m_type) {
+      if (a.m_type == json_value_type::object) {
+        if (a.m_value.object == b.m_value.object) {
+          return true;
+        }
+        if (a.m_value.object->size() != b.m_value.object->size()) {
+          return false;
+        }
+      } else if (a.m_type == json_value_type::array) {
+        if (a.m_value.array == b.m_value.array) {
+          return true;
+        }
+        if (a.m_value.array->size() != b.m_value.array->size()) {
+          return false;
+        }
+      } else if (a.m_type == json_value_type::string &&
+                 a.m_value.str == b.m_value.str) {
+        return true;
+      }
+    }
+    if (a.structural_hash() != b.structural_hash()) {
+      return false;
+    }
+    return !m_verify || a == b;
+  }
+
+  /*
+    Append an array index to the JSON pointer (RFC 6901) path
+  */
+  static void append_index(string_t *path, size_t index) {
+    std::string s = std::to_string(index);
+    *path += '/';
+    path->append(s.data(), s.size());
+  }
+
+  /*
+    Append an object key to the JSON pointer (RFC 6901) path
+  */
+  static void append_key(string_t *path, const string_t &key) {
+    append_pointer_token(path, key);
+  }
+
+ private:
+  JSONNode *m_patch;
+  bool m_verify;  // confirm equal hashes by comparing the values
+};
+}  // namespace detail
+}  // namespace miniJSON
@@ -0,0 +1,69 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+namespace miniJSON {
+namespace detail {
+/*
+  Helper functions to compute structural hashes of JSON nodes
+*/
+
+/*
+  Scramble the bits of x (finalizer of splitmix64)
+*/
+inline uint64_t hash_mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/*
+  Combine hash value h into seed in an order dependent way
+*/
+inline uint64_t hash_combine(uint64_t seed, uint64_t h) {
+  return hash_mix(seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+                          (seed >> 2)));
+}
+
+/*
+  Hash a double number. Integral values hash the same as the equal integer
+  so that 1 and 1.0 have the same hash.
+*/
+inline uint64_t hash_number(double d) {
+  if (d >= -9223372036854775808.0 && d < 9223372036854775808.0 &&
+      static_cast<double>(static_cast<int64_t>(d)) == d) {
+    return hash_mix(static_cast<uint64_t>(static_cast<int64_t>(d)));
+  }
+  uint64_t bits = 0;
+  std::memcpy(&bits, &d, sizeof(bits));
+  return hash_mix(bits);
+}
+
+/*
+  Hash a string of any allocator: with std::hash where it is enabled for the
+  string type, or else with FNV-1a over its characters
+*/
+template <typename String,
+          bool = std::is_default_constructible<std::hash<String>>::value>
+struct string_hash {
+  size_t operator()(const String &s) const { return std::hash<String>()(s); }
+};
+template <typename String>
+struct string_hash<String, false> {
+  size_t operator()(const String &s) const {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < s.size(); i++) {
+      h = (h ^ static_cast<unsigned char>(s[i])) * 0x100000001b3ULL;
+    }
+    return static_cast<size_t>(hash_mix(h));
+  }
+};
+}  // namespace detail
+}  // namespace miniJSON
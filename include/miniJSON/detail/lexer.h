@@ -0,0 +1,456 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../errors.h"
+#include "./simd.h"
+#include "./utf8.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  Helper functions to scan the tokens of a JSON string. They are shared by
+  the parser and by the code that skips or validates JSON without building
+  JSON nodes. Each of them returns the position after the token, or the
+  position of the error along with its kind.
+*/
+
+/*
+  A string that discards everything appended to it, used to validate strings
+  without decoding them
+*/
+struct discard_string {
+  void append(const char *, const char *) {}
+  discard_string &operator+=(char) { return *this; }
+};
+
+inline bool is_whitespace(char c) {
+  return isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+inline const char *skip_whitespace(const char *p, const char *end) {
+  while (p < end && is_whitespace(*p)) {
+    p++;
+  }
+  return p;
+}
+
+/*
+  Parse 4 hexadecimal digits of a \uXXXX escape sequence
+*/
+inline bool parse_hex4(const char *p, const char *end, uint32_t *code_unit) {
+  if (end - p < 4) {
+    return false;
+  }
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; i++) {
+    char c = p[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      value |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      value |= c - 'A' + 10;
+    } else {
+      return false;
+    }
+  }
+  *code_unit = value;
+  return true;
+}
+
+/*
+  Decode the escape sequence after a reverse solidus at p and append it to
+  out. A surrogate pair written as two \uXXXX escapes is decoded into a
+  single code point; unpaired surrogates are rejected. On error the position
+  of the escape character is returned.
+*/
+template <typename String>
+inline const char *scan_escape(const char *p, const char *end, String *out,
+                               parse_error_code *error) {
+  if (p == end) {
+    *error = parse_error_code::invalid_escape;
+    return p;
+  }
+  char c = *p++;
+  switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      *out += c;
+      return p;
+    case 'b':
+      *out += '\b';
+      return p;
+    case 'f':
+      *out += '\f';
+      return p;
+    case 'n':
+      *out += '\n';
+      return p;
+    case 'r':
+      *out += '\r';
+      return p;
+    case 't':
+      *out += '\t';
+      return p;
+    case 'u':
+      break;
+    default:
+      *error = parse_error_code::invalid_escape;
+      return p - 1;
+  }
+  const char *start = p - 1;
+  uint32_t code_point = 0;
+  bool valid = parse_hex4(p, end, &code_point);
+  p += valid ? 4 : 0;
+  if (valid && code_point >= 0xd800 && code_point <= 0xdbff) {
+    uint32_t low = 0;
+    valid = end - p >= 2 && p[0] == '\\' && p[1] == 'u';
+    p += valid ? 2 : 0;
+    valid = valid && parse_hex4(p, end, &low) && low >= 0xdc00 &&
+            low <= 0xdfff;
+    p += valid ? 4 : 0;
+    code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+  } else if (valid && code_point >= 0xdc00 && code_point <= 0xdfff) {
+    valid = false;
+  }
+  if (!valid) {
+    *error = parse_error_code::invalid_escape;
+    return start;
+  }
+  append_utf8(code_point, out);
+  return p;
+}
+
+/*
+  Scan the rest of a string after the opening quote and append the decoded
+  string to out. Runs of characters without escapes are found with SIMD,
+  validated as UTF-8 and copied in bulk.
+*/
+template <typename String>
+inline const char *scan_string(const char *p, const char *end, String *out,
+                               parse_error_code *error) {
+  *error = parse_error_code::none;
+  for (;;) {
+    const char *special = find_escape(p, end);
+    const char *invalid = find_invalid_utf8(p, special);
+    if (invalid != special) {
+      *error = parse_error_code::invalid_utf8;
+      return invalid;
+    }
+    out->append(p, special);
+    if (special == end) {
+      *error = parse_error_code::unterminated_string;
+      return end;
+    }
+    if (*special == '"') {
+      return special + 1;
+    }
+    if (*special != '\\') {
+      *error = parse_error_code::control_character;
+      return special;
+    }
+    p = scan_escape(special + 1, end, out, error);
+    if (*error != parse_error_code::none) {
+      return p;
+    }
+  }
+}
+
+/*
+  Scan a number and convert it to double. The characters that can appear in
+  a number are taken and the whole run has to be accepted by strtod.
+*/
+inline const char *scan_number(const char *p, const char *end, double *value,
+                               parse_error_code *error) {
+  *error = parse_error_code::none;
+  const char *q = p;
+  while (q < end && (isdigit(static_cast<unsigned char>(*q)) || *q == '-' ||
+                     *q == '+' || *q == 'e' || *q == 'E' || *q == '.')) {
+    q++;
+  }
+  size_t length = static_cast<size_t>(q - p);
+  // strtod needs a null-terminated copy; short numbers stay on the stack
+  char buffer[64];
+  std::string long_number;
+  const char *number_s = buffer;
+  if (length < sizeof(buffer)) {
+    memcpy(buffer, p, length);
+    buffer[length] = '\0';
+  } else {
+    long_number.assign(p, q);
+    number_s = long_number.c_str();
+  }
+
+  // check if number is valid
+  char *end_ptr = nullptr;
+  double d = strtod(number_s, &end_ptr);
+  if (length == 0 || *end_ptr != '\0') {
+    *error = parse_error_code::invalid_number;
+    return p + (end_ptr - number_s);
+  }
+  // number cannot end with a dot
+  if (q[-1] == '.') {
+    *error = parse_error_code::invalid_number;
+    return q;
+  }
+  *value = d;
+  return q;
+}
+
+/*
+  Scan a number without converting it. It accepts the same numbers as
+  scan_number, whose strtod takes an optional minus sign, digits with an
+  optional fraction and an optional exponent, and fails at the same
+  positions. is_integer is set if there is neither a fraction nor an
+  exponent.
+*/
+inline const char *scan_number_text(const char *p, const char *end,
+                                    bool *is_integer, parse_error_code *error) {
+  *error = parse_error_code::none;
+  const char *q = p;
+  while (q < end && (isdigit(static_cast<unsigned char>(*q)) || *q == '-' ||
+                     *q == '+' || *q == 'e' || *q == 'E' || *q == '.')) {
+    q++;
+  }
+  const char *s = p < q && *p == '-' ? p + 1 : p;
+  size_t digits = 0;
+  bool integer = true;
+  for (; s < q && isdigit(static_cast<unsigned char>(*s)); s++) {
+    digits++;
+  }
+  if (s < q && *s == '.') {
+    integer = false;
+    for (s++; s < q && isdigit(static_cast<unsigned char>(*s)); s++) {
+      digits++;
+    }
+  }
+  if (digits == 0) {
+    *error = parse_error_code::invalid_number;
+    return p;
+  }
+  if (s < q && (*s == 'e' || *s == 'E')) {
+    const char *e = s + 1;
+    e += e < q && (*e == '+' || *e == '-') ? 1 : 0;
+    if (e < q && isdigit(static_cast<unsigned char>(*e))) {
+      integer = false;
+      s = e;
+      while (s < q && isdigit(static_cast<unsigned char>(*s))) {
+        s++;
+      }
+    }
+  }
+  if (s != q || q[-1] == '.') {
+    *error = parse_error_code::invalid_number;
+    return s;
+  }
+  *is_integer = integer;
+  return q;
+}
+
+/*
+  Check if the text of a number checked by scan_number has neither a
+  fraction nor an exponent
+*/
+inline bool is_integer_text(const char *p, const char *end) {
+  for (; p < end; p++) {
+    if (*p == '.' || *p == 'e' || *p == 'E') {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  Check if the text of an integer checked by scan_number_text is in the
+  range of Int. The digits are accumulated until the next one would
+  overflow.
+*/
+template <typename Int>
+inline bool fits_integer(const char *p, const char *end) {
+  using uint_t = typename std::make_unsigned<Int>::type;
+  bool negative = p < end && *p == '-';
+  uint_t limit = static_cast<uint_t>(std::numeric_limits<Int>::max()) +
+                 (negative ? 1 : 0);
+  uint_t res = 0;
+  for (p += negative ? 1 : 0; p < end; p++) {
+    uint_t digit = static_cast<uint_t>(*p - '0');
+    if (res > (limit - digit) / 10) {
+      return false;
+    }
+    res = res * 10 + digit;
+  }
+  return true;
+}
+
+/*
+  Convert the text of an integer checked by scan_number_text and
+  fits_integer
+*/
+template <typename Int>
+inline Int convert_integer(const char *p, const char *end) {
+  using uint_t = typename std::make_unsigned<Int>::type;
+  bool negative = p < end && *p == '-';
+  uint_t res = 0;
+  for (p += negative ? 1 : 0; p < end; p++) {
+    res = res * 10 + static_cast<uint_t>(*p - '0');
+  }
+  if (negative && res != 0) {
+    return -static_cast<Int>(res - 1) - 1;  // the minimum does not overflow
+  }
+  return static_cast<Int>(res);
+}
+
+/*
+  Check if the literal (true, false or null) starts at p
+*/
+inline bool match_literal(const char *p, const char *end, const char *literal,
+                          size_t n) {
+  return static_cast<size_t>(end - p) >= n && memcmp(p, literal, n) == 0;
+}
+
+/*
+  Stack of the kinds of the nested arrays/objects being scanned, one bit per
+  level. Nesting up to 1024 levels needs no heap allocation.
+*/
+class container_stack {
+ public:
+  void push(bool is_object) {
+    size_t word = m_size / 64;
+    uint64_t bit = uint64_t(1) << (m_size % 64);
+    if (word >= inline_words && word - inline_words >= m_heap.size()) {
+      m_heap.push_back(0);
+    }
+    uint64_t &w = word_at(word);
+    w = is_object ? (w | bit) : (w & ~bit);
+    m_size++;
+  }
+  void pop() { m_size--; }
+  bool top_is_object() {
+    size_t i = m_size - 1;
+    return (word_at(i / 64) >> (i % 64)) & 1;
+  }
+  bool empty() const { return m_size == 0; }
+  size_t size() const { return m_size; }
+
+ private:
+  static const size_t inline_words = 16;
+
+  uint64_t &word_at(size_t word) {
+    return word < inline_words ? m_inline[word]
+                               : m_heap[word - inline_words];
+  }
+
+ private:
+  uint64_t m_inline[inline_words];
+  std::vector<uint64_t> m_heap;
+  size_t m_size = 0;
+};
+
+/*
+  Skip the value starting at p (after any whitespace) while checking it
+  against the same grammar as the parser, without decoding or storing
+  anything. The whitespace after the value is skipped too.
+*/
+inline const char *skip_value(const char *p, const char *end,
+                              size_t max_depth, parse_error_code *error) {
+  container_stack stack;
+  *error = parse_error_code::none;
+  double number = 0;
+  discard_string discard;
+  bool expect_key = false;
+  for (;;) {
+    p = skip_whitespace(p, end);
+    if (p == end) {
+      *error = parse_error_code::unexpected_end;
+      return p;
+    }
+    if (expect_key) {
+      // an object key and the colon after it
+      if (*p != '"') {
+        *error = parse_error_code::expected_key;
+        return p;
+      }
+      p = scan_string(p + 1, end, &discard, error);
+      if (*error != parse_error_code::none) {
+        return p;
+      }
+      p = skip_whitespace(p, end);
+      if (p == end || *p != ':') {
+        *error = p == end ? parse_error_code::unexpected_end
+                          : parse_error_code::expected_colon;
+        return p;
+      }
+      p = skip_whitespace(p + 1, end);
+      if (p == end) {
+        *error = parse_error_code::unexpected_end;
+        return p;
+      }
+      expect_key = false;
+    }
+    char c = *p;
+    if (c == '[' || c == '{') {
+      if (stack.size() >= max_depth) {
+        *error = parse_error_code::depth_exceeded;
+        return p;
+      }
+      p = skip_whitespace(p + 1, end);
+      if (p < end && *p == (c == '[' ? ']' : '}')) {
+        p++;
+      } else {
+        stack.push(c == '{');
+        expect_key = c == '{';
+        continue;
+      }
+    } else if (c == '"') {
+      p = scan_string(p + 1, end, &discard, error);
+    } else if (c == 't' || c == 'f' || c == 'n') {
+      const char *literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+      size_t n = strlen(literal);
+      if (!match_literal(p, end, literal, n)) {
+        *error = parse_error_code::invalid_literal;
+        return p;
+      }
+      p += n;
+    } else if (isdigit(static_cast<unsigned char>(c)) || c == '-') {
+      p = scan_number(p, end, &number, error);
+    } else {
+      *error = parse_error_code::unexpected_character;
+    }
+    if (*error != parse_error_code::none) {
+      return p;
+    }
+    // the comma or the closing brackets after the value
+    for (;;) {
+      p = skip_whitespace(p, end);
+      if (stack.empty()) {
+        return p;
+      }
+      bool is_object = stack.top_is_object();
+      if (p < end && *p == ',') {
+        p++;
+        expect_key = is_object;
+        break;
+      }
+      if (p < end && *p == (is_object ? '}' : ']')) {
+        p++;
+        stack.pop();
+        continue;
+      }
+      *error = p == end ? parse_error_code::unexpected_end
+                        : parse_error_code::expected_comma_or_end;
+      return p;
+    }
+  }
+}
+}  // namespace detail
+}  // namespace miniJSON
@@ -0,0 +1,118 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <string>
+#include <utility>
+
+#include "../errors.h"
+#include "../json_types.h"
+#include "../options.h"
+#include "./pointer.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  Merger is responsible for deep merging a JSON node into another one. The
+  members and elements that end up in the target are moved out of the source:
+  only the nodes that hold them are allocated, their descendants are taken
+  over as they are.
+*/
+template <typename JSONNode>
+class merger {
+ public:
+  explicit merger(const merge_options &options) : m_options(options) {}
+
+  /*
+    Merge source into target. With merge_conflict_policy::error, the first
+    conflict is looked for before anything is modified.
+  */
+  void merge(JSONNode *target, JSONNode *source) {
+    std::string path;
+    if (m_options.conflicts == merge_conflict_policy::error &&
+        find_conflict(*target, *source, &path)) {
+      MINIJSON_THROW(
+          json_merge_error("conflicting values at \"" + path + "\""));
+    }
+    merge_value(target, source);
+  }
+
+ private:
+  /*
+    Objects are merged member by member and arrays are appended with
+    merge_array_policy::concat. A null target is replaced as if it were
+    absent; anything else is a conflict.
+  */
+  void merge_value(JSONNode *target, JSONNode *source) {
+    if (target->m_type == json_value_type::object &&
+        source->m_type == json_value_type::object) {
+      target->detach();
+      source->detach();
+      auto &object = *source->m_value.object;
+      for (auto it = object.values_begin(); it != object.values_end(); it++) {
+        auto res = target->m_value.object->emplace(it.key(), nullptr);
+        if (res.second) {
+          *res.first = target->create_node(std::move(**it));
+        } else {
+          merge_value(*res.first, *it);
+        }
+      }
+      return;
+    }
+    if (target->m_type == json_value_type::array &&
+        source->m_type == json_value_type::array &&
+        m_options.arrays == merge_array_policy::concat) {
+      target->detach();
+      source->detach();
+      auto &array = *target->m_value.array;
+      array.reserve(array.size() + source->m_value.array->size());
+      for (auto j : *source->m_value.array) {
+        array.push_back(target->create_node(std::move(*j)));
+      }
+      return;
+    }
+    if (is_absent(*target) ||
+        m_options.conflicts != merge_conflict_policy::keep) {
+      *target = std::move(*source);
+    }
+  }
+
+  /*
+    Find the first value that merge_value() would resolve as a conflict and
+    differs between target and source, and get its JSON pointer
+  */
+  bool find_conflict(const JSONNode &target, const JSONNode &source,
+                     std::string *path) const {
+    if (target.m_type == json_value_type::object &&
+        source.m_type == json_value_type::object) {
+      size_t length = path->size();
+      auto &object = *source.m_value.object;
+      for (auto it = object.values_begin(); it != object.values_end(); it++) {
+        auto child = target.m_value.object->find(it.key());
+        if (child == nullptr) {
+          continue;
+        }
+        append_pointer_token(path, it.key());
+        if (find_conflict(**child, **it, path)) {
+          return true;
+        }
+        path->resize(length);
+      }
+      return false;
+    }
+    if (target.m_type == json_value_type::array &&
+        source.m_type == json_value_type::array &&
+        m_options.arrays == merge_array_policy::concat) {
+      return false;
+    }
+    return !is_absent(target) && target != source;
+  }
+
+  static bool is_absent(const JSONNode &j) {
+    return j.m_type == json_value_type::null ||
+           j.m_type == json_value_type::indeterminate;
+  }
+
+ private:
+  merge_options m_options;
+};
+}  // namespace detail
+}  // namespace miniJSON
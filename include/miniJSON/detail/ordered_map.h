@@ -2,25 +2,89 @@
 #pragma once
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <memory>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "./hash.h"
+
 /*
-  A simple hashmap that maintains insertion order.
+  A simple hashmap that maintains insertion order. The table and the keys are
+  allocated with Allocator; a map constructed with a stateful allocator also
+  copies the keys it stores with that allocator.
 */
-template <typename Key, typename Value>
+template <typename Key, typename Value,
+          typename Allocator = std::allocator<std::pair<const Key, Value>>>
 class ordered_map {
+  using map_type = std::unordered_map<Key, Value,
+                                      miniJSON::detail::string_hash<Key>,
+                                      std::equal_to<Key>, Allocator>;
+  using key_allocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Key>;
+  using order_type = std::vector<Key, key_allocator>;
+
  public:
+  using allocator_type = Allocator;
+
   ordered_map() { test_invariant(); }
+  explicit ordered_map(const Allocator &allocator)
+      : m_map(0, typename map_type::hasher(), std::equal_to<Key>(), allocator),
+        m_insertion_order(typename order_type::allocator_type(allocator)) {
+    test_invariant();
+  }
   Value &operator[](const Key &key) {
     test_invariant();
-    if (m_map.count(key) == 0) {
-      m_insertion_order.push_back(key);
+    auto it = m_map.find(key);
+    if (it == m_map.end()) {
+      it = m_map.emplace(copy_key(key), Value()).first;
+      m_insertion_order.push_back(copy_key(key));
     }
-    auto &res = m_map[key];
+    auto &res = it->second;
     test_invariant();
     return res;
   }
+  /*
+    Insert key-value pair if key does not exist yet. Returns the stored value
+    and whether the insertion took place. The key is only hashed once.
+  */
+  std::pair<Value *, bool> emplace(const Key &key, Value value) {
+    test_invariant();
+    auto res = m_map.emplace(copy_key(key), std::move(value));
+    if (res.second) {
+      m_insertion_order.push_back(copy_key(key));
+    }
+    test_invariant();
+    return {&res.first->second, res.second};
+  }
+  /*
+    Find the value associated with key without modifying the map. Returns
+    nullptr if the key does not exist.
+  */
+  const Value *find(const Key &key) const {
+    auto it = m_map.find(key);
+    return it == m_map.end() ? nullptr : &it->second;
+  }
+  /*
+    Insert key-value pair at the given position of the insertion order. The
+    key must not exist yet.
+  */
+  void insert_at(size_t pos, const Key &key, Value value) {
+    test_invariant();
+    assert(m_map.count(key) == 0);
+    m_map.emplace(copy_key(key), std::move(value));
+    m_insertion_order.insert(m_insertion_order.begin() + pos, copy_key(key));
+    test_invariant();
+  }
+  /*
+    Get the position of key in the insertion order
+  */
+  size_t index_of(const Key &key) const {
+    return std::find(m_insertion_order.begin(), m_insertion_order.end(), key) -
+           m_insertion_order.begin();
+  }
   size_t count(const Key &key) const { return m_map.count(key); }
   size_t erase(const Key &key) {
     test_invariant();
@@ -31,7 +95,20 @@ class ordered_map {
     test_invariant();
     return res;
   }
-  size_t size() { return m_map.size(); }
+  size_t size() const { return m_map.size(); }
+  /*
+    Call f on every value in unspecified order without looking up the keys
+  */
+  template <typename F>
+  void for_each_value(F f) {
+    for (auto &entry : m_map) {
+      f(entry.second);
+    }
+  }
+  void reserve(size_t n) {
+    m_map.reserve(n);
+    m_insertion_order.reserve(n);
+  }
 
  public:
   struct keys_iterator {
@@ -41,7 +118,7 @@ class ordered_map {
     using pointer = Key *;
     using reference = Key &;
     keys_iterator() {}
-    keys_iterator(typename std::vector<Key>::iterator it) : m_it(it) {}
+    keys_iterator(typename order_type::iterator it) : m_it(it) {}
     value_type operator*() const { return *m_it; }
     pointer operator->() { return &(*m_it); }
 
@@ -64,7 +141,7 @@ class ordered_map {
     }
 
    private:
-    typename std::vector<Key>::iterator m_it;
+    typename order_type::iterator m_it;
   };
 
   struct values_iterator {
@@ -74,8 +151,7 @@ class ordered_map {
     using pointer = Value *;
     using reference = Value &;
     values_iterator() {}
-    values_iterator(typename std::unordered_map<Key, Value> *map,
-                    typename std::vector<Key>::iterator it)
+    values_iterator(map_type *map, typename order_type::iterator it)
         : m_map(map), m_it(it) {}
     value_type operator*() const { return (*m_map)[*m_it]; }
     pointer operator->() { return &((*m_map)[*m_it]); }
@@ -99,12 +175,12 @@ class ordered_map {
     }
 
    public:
-    Key key() { return *m_it; }
+    const Key &key() const { return *m_it; }
     Value value() { return (*m_map)[*m_it]; }
 
    private:
-    typename std::unordered_map<Key, Value> *m_map = nullptr;
-    typename std::vector<Key>::iterator m_it;
+    map_type *m_map = nullptr;
+    typename order_type::iterator m_it;
   };
 
  public:
@@ -119,11 +195,26 @@ class ordered_map {
   keys_iterator end() { return keys_iterator(m_insertion_order.end()); }
 
  private:
+  /*
+    Copy a key to be stored. The copy takes the allocator of the map if the
+    allocator is stateful and the key type accepts it; otherwise the copy
+    constructor picks the allocator.
+  */
+  Key copy_key(const Key &key) const {
+    return copy_key(key, std::integral_constant<
+                             bool, std::uses_allocator<Key, Allocator>::value &&
+                                       !std::is_empty<Allocator>::value>());
+  }
+  Key copy_key(const Key &key, std::true_type) const {
+    return Key(key, m_map.get_allocator());
+  }
+  Key copy_key(const Key &key, std::false_type) const { return key; }
+
   void test_invariant() const {
     assert(m_map.size() == m_insertion_order.size());
   }
 
  private:
-  std::unordered_map<Key, Value> m_map;
-  std::vector<Key> m_insertion_order;
+  map_type m_map;
+  order_type m_insertion_order;
 };
@@ -1,306 +1,528 @@
 // Copyright (c) 2024 Zhichen (Joshua) Wen
 #pragma once
+#include <algorithm>
 #include <cctype>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "../errors.h"
+#include "../field_mask.h"
+#include "../json_types.h"
+#include "../options.h"
+#include "../stats.h"
+#include "./lexer.h"
+#include "./schema.h"
 
 namespace miniJSON {
 namespace detail {
 template <typename JSONNode>
 /*
   Parser is responsible for parsing the JSON string and constructing the JSON
-  nodes (tree).
+  nodes (tree). Parsing is iterative: the arrays and objects being parsed are
+  kept on an explicit stack instead of the call stack, so the nesting depth is
+  only limited by parse_options::max_depth. A parser can be reused: the stack
+  and the scratch buffers keep their capacity between calls.
 */
 class parser {
  public:
-  parser(JSONNode *result, const std::string &s)
-      : m_result(result), m_json_s(s) {}
+  /*
+    Parse JSON string into result. It returns the kind and the offset of the
+    error if the JSON string format is invalid.
+  */
+  parse_result parse(const std::string &s, JSONNode *result,
+                     const parse_options &options) {
+    size_t end = 0;
+    parse_result res = parse_prefix(s, 0, result, options, &end);
+    if (res && end != s.size()) {
+      res.code = parse_error_code::trailing_characters;
+      res.offset = end;
+    }
+    return res;
+  }
 
- public:
   /*
-    Parse JSON string. It will throw error if the JSON string format is invalid.
+    Parse JSON string into result, building only the fields selected by the
+    mask. The rest of the input is checked against the same grammar but
+    skipped without creating JSON nodes.
   */
-  void parse() {
-    auto type = parse_value(m_result);
-    if (type != json_parse_type::json_value || remaining_parse_length() > 0) {
-      throw json_parse_error("invalid JSON string format");
+  parse_result parse(const std::string &s, const field_mask &mask,
+                     JSONNode *result, const parse_options &options) {
+    m_mask = &mask;
+    parse_result res = parse(s, result, options);
+    m_mask = nullptr;
+    return res;
+  }
+
+  /*
+    Parse JSON string into result and validate it against the schema on the
+    way. A scalar is checked as soon as it is parsed, an array or object when
+    it is closed, a value of the wrong type and a member that the schema does
+    not allow before they are parsed. The first violation stops parsing with
+    parse_error_code::schema_violation at the offset of the rejected value or
+    member.
+  */
+  parse_result parse(const std::string &s,
+                     const schema_program<JSONNode> &schema, JSONNode *result,
+                     const parse_options &options) {
+    m_schema = &schema;
+    parse_result res = parse(s, result, options);
+    m_schema = nullptr;
+    return res;
+  }
+
+  /*
+    Parse the value starting at offset begin of the JSON string into result
+    and leave the characters after it alone. end receives the offset after the
+    value and the whitespace following it.
+  */
+  parse_result parse_prefix(const std::string &s, size_t begin,
+                            JSONNode *result, const parse_options &options,
+                            size_t *end) {
+    MINIJSON_STATS(stats_scope scope(stats_scope::operation::parse));
+    m_json_s = &s;
+    m_options = options;
+    m_parse_index = begin;
+    m_error = parse_result();
+    m_stack.clear();
+    m_masks.clear();
+    m_value_mask = m_mask == nullptr ? field_mask::all : m_mask->root();
+    m_schemas.clear();
+    m_value_schema = m_schema == nullptr ? schema_program<JSONNode>::any
+                                         : m_schema->root();
+    JSONNode *node = result;
+    parse_state state = parse_state::value;
+    while (state != parse_state::error) {
+      switch (state) {
+        case parse_state::value:
+          state = parse_value(&node);
+          break;
+        case parse_state::key:
+          state = parse_key(&node);
+          break;
+        case parse_state::separator:
+          if (m_stack.empty()) {
+            MINIJSON_STATS(stats().bytes_parsed += m_parse_index - begin);
+            *end = m_parse_index;
+            return m_error;
+          }
+          state = parse_separator(&node);
+          break;
+        default:
+          break;
+      }
     }
+    MINIJSON_STATS(stats().bytes_parsed += m_parse_index - begin);
+    return m_error;
   }
 
  private:
-  enum class json_parse_type {
-    error,
-    json_value,
-    whitespace,
-    reach_array_end,
-    reach_array_separator
-  };
+  /*
+    What the parser expects next: a value, an object key, or a comma or the
+    end of the innermost array/object
+  */
+  enum class parse_state { value, key, separator, error };
 
-  json_parse_type parse_array_item(JSONNode *array) {
+  /*
+    Parse a value into node. Scalars are parsed completely, an array or object
+    is pushed onto the stack and the parser continues with its first element.
+  */
+  parse_state parse_value(JSONNode **node_ptr) {
+    JSONNode *node = *node_ptr;
     parse_whitespace();
-    JSONNode *value = new JSONNode();
-    if (parse_value(value) != json_parse_type::json_value) {
-      delete value;
-      return json_parse_type::error;
+    if (remaining_parse_length() == 0) {
+      return fail(parse_error_code::unexpected_end);
     }
-    array->m_value.array->push_back(value);
-    parse_whitespace();
-    if (!parse_comma(true)) {
-      return json_parse_type::error;
+    size_t start = m_parse_index;
+    if (m_schema != nullptr &&
+        !m_schema->accepts(m_value_schema, current_character())) {
+      return fail(parse_error_code::schema_violation);
     }
-    return json_parse_type::json_value;
-  }
-
-  json_parse_type parse_array(JSONNode *result) {
-    result->set_array();
-    while (remaining_parse_length() > 0) {
-      if (current_character() == ']') {
+    switch (current_character()) {
+      case '[':
+        m_parse_index++;
+        node->set_array();
+        MINIJSON_STATS(record_node(json_value_type::array));
+        return open_container(node_ptr, ']', parse_state::value);
+      case '{':
+        m_parse_index++;
+        node->set_object();
+        MINIJSON_STATS(record_node(json_value_type::object));
+        return open_container(node_ptr, '}', parse_state::key);
+      case '"':
         m_parse_index++;
+        node->set_string();
+        if (!parse_string(node->m_value.str)) {
+          return parse_state::error;
+        }
         break;
+      case 't':
+        if (!parse_literal("true")) {
+          return parse_state::error;
+        }
+        node->set_boolean(true);
+        break;
+      case 'f':
+        if (!parse_literal("false")) {
+          return parse_state::error;
+        }
+        node->set_boolean(false);
+        break;
+      case 'n':
+        if (!parse_literal("null")) {
+          return parse_state::error;
+        }
+        break;
+      default:
+        if (!isdigit(current_character()) && current_character() != '-') {
+          return fail(parse_error_code::unexpected_character);
+        }
+        if (!parse_number(node)) {
+          return parse_state::error;
+        }
+        break;
+    }
+    if (m_schema != nullptr && !check_schema(*node, m_value_schema, start)) {
+      return parse_state::error;
+    }
+    MINIJSON_STATS(record_node(node->m_type));
+    parse_whitespace();
+    return parse_state::separator;
+  }
+
+  /*
+    Push the array or object just opened onto the stack. Empty ones are closed
+    immediately.
+  */
+  parse_state open_container(JSONNode **node, char close,
+                             parse_state next) {
+    size_t start = m_parse_index - 1;
+    if (m_stack.size() >= m_options.max_depth) {
+      m_parse_index--;
+      return fail(parse_error_code::depth_exceeded);
+    }
+    parse_whitespace();
+    if (remaining_parse_length() > 0 && current_character() == close) {
+      m_parse_index++;
+      if (m_schema != nullptr && !check_schema(**node, m_value_schema, start)) {
+        return parse_state::error;
       }
-      if (parse_array_item(result) != json_parse_type::json_value) {
-        return json_parse_type::error;
-      }
+      parse_whitespace();
+      return parse_state::separator;
+    }
+    m_stack.push_back(*node);
+    if (m_mask != nullptr) {
+      m_masks.push_back(m_value_mask);
+    }
+    if (m_schema != nullptr) {
+      m_schemas.emplace_back(m_value_schema, start);
     }
-    return json_parse_type::json_value;
+    MINIJSON_STATS(stats().max_depth =
+                       std::max(stats().max_depth, m_stack.size()));
+    if (next == parse_state::value) {
+      return next_array_item(node, *node);
+    }
+    return next;
   }
 
-  json_parse_type parse_object_item(JSONNode *object) {
+  /*
+    Parse an object key and the colon after it, then add the member whose
+    value is parsed next. A duplicate key replaces the previous member.
+  */
+  parse_state parse_key(JSONNode **node) {
     parse_whitespace();
+    if (remaining_parse_length() == 0) {
+      return fail(parse_error_code::unexpected_end);
+    }
     if (current_character() != '\"') {
-      return json_parse_type::error;
+      return fail(parse_error_code::expected_key);
     }
+    size_t key_start = m_parse_index;
     m_parse_index++;
-
-    JSONNode *key = new JSONNode();
-    if (parse_string(key) != json_parse_type::json_value) {
-      delete key;
-      return json_parse_type::error;
+    m_key.clear();
+    if (!parse_string(&m_key)) {
+      return parse_state::error;
     }
-
     parse_whitespace();
-    if (current_character() != ':') {
-      delete key;
-      return json_parse_type::error;
+    if (remaining_parse_length() == 0 || current_character() != ':') {
+      return fail(remaining_parse_length() > 0
+                      ? parse_error_code::expected_colon
+                      : parse_error_code::unexpected_end);
     }
     m_parse_index++;
-    parse_whitespace();
 
-    JSONNode *value = new JSONNode();
-    if (parse_value(value) != json_parse_type::json_value) {
-      delete key;
-      delete value;
-      return json_parse_type::error;
+    parse_state state;
+    if (m_mask != nullptr) {
+      m_value_mask = m_mask->child(m_masks.back(), m_key.data(), m_key.size());
+      if (skip_unselected(&state)) {
+        return state;
+      }
     }
-
-    (*object->m_value.object)[*key->m_value.str] = value;
-    delete key;  // object key string will be copied so this dynamically
-                 // allocated string json_node can be deleted
-    parse_whitespace();
-
-    if (!parse_comma()) {
-      return json_parse_type::error;
+    if (m_schema != nullptr) {
+      m_value_schema = m_schema->member(m_schemas.back().first, m_key);
+      if (m_value_schema == schema_program<JSONNode>::nothing) {
+        return fail(parse_error_code::schema_violation, key_start);
+      }
+    }
+    JSONNode *value = m_stack.back()->create_node();
+    auto res = m_stack.back()->m_value.object->emplace(m_key, value);
+    if (!res.second) {
+      JSONNode::destroy_node(*res.first);
+      *res.first = value;
     }
-    return json_parse_type::json_value;
+    *node = value;
+    return parse_state::value;
   }
 
-  json_parse_type parse_object(JSONNode *result) {
-    result->set_object();
-    while (remaining_parse_length() > 0) {
-      if (current_character() == '}') {
-        m_parse_index++;
-        break;
+  /*
+    Parse the comma or the closing bracket after an element of the innermost
+    array/object
+  */
+  parse_state parse_separator(JSONNode **node) {
+    JSONNode *container = m_stack.back();
+    bool is_array = container->m_type == json_value_type::array;
+    if (remaining_parse_length() > 0 && current_character() == ',') {
+      m_parse_index++;
+      if (is_array) {
+        return next_array_item(node, container);
+      }
+      return parse_state::key;
+    }
+    if (remaining_parse_length() > 0 &&
+        current_character() == (is_array ? ']' : '}')) {
+      m_parse_index++;
+      if (m_schema != nullptr) {
+        if (!check_schema(*container, m_schemas.back().first,
+                          m_schemas.back().second)) {
+          return parse_state::error;
+        }
+        m_schemas.pop_back();
       }
-      if (parse_object_item(result) != json_parse_type::json_value) {
-        return json_parse_type::error;
+      m_stack.pop_back();
+      if (m_mask != nullptr) {
+        m_masks.pop_back();
       }
+      parse_whitespace();
+      return parse_state::separator;
     }
-    return json_parse_type::json_value;
+    return fail(remaining_parse_length() > 0
+                    ? parse_error_code::expected_comma_or_end
+                    : parse_error_code::unexpected_end);
   }
 
-  bool parse_escape_sequence(JSONNode *result) {
-    if (remaining_parse_length() == 0) {
+  /*
+    Add the next element of the array unless the mask skips it
+  */
+  parse_state next_array_item(JSONNode **node, JSONNode *array) {
+    parse_state state;
+    if (m_mask != nullptr) {
+      m_value_mask = m_masks.back();
+      if (skip_unselected(&state)) {
+        return state;
+      }
+    }
+    if (m_schema != nullptr) {
+      m_value_schema = m_schema->items(m_schemas.back().first);
+    }
+    *node = add_array_item(array);
+    return parse_state::value;
+  }
+
+  /*
+    Skip the value parsed next if the mask does not select it: members that
+    are not in the mask, and scalars where the mask selects members inside
+    them. Skipped values are validated without being built.
+  */
+  bool skip_unselected(parse_state *state) {
+    if (m_value_mask == field_mask::all) {
       return false;
     }
-    bool valid_sequence = true;
-    switch (current_character()) {
-      case '"':
-        *result->m_value.str += R"(\")";
-        break;
-      case '\\':
-        *result->m_value.str += R"(\\)";
-        break;
-      case '/':
-        *result->m_value.str += R"(/)";
-        break;
-      case 'b':
-        *result->m_value.str += R"(\b)";
-        break;
-      case 'f':
-        *result->m_value.str += R"(\f)";
-        break;
-      case 'n':
-        *result->m_value.str += R"(\n)";
-        break;
-      case 'r':
-        *result->m_value.str += R"(\r)";
-        break;
-      case 't':
-        *result->m_value.str += R"(\t)";
-        break;
-      default:
-        valid_sequence = false;
-        break;
+    parse_whitespace();
+    if (m_value_mask != field_mask::none && remaining_parse_length() > 0 &&
+        (current_character() == '{' || current_character() == '[')) {
+      return false;
     }
-    if (valid_sequence) {
-      m_parse_index++;
+    const char *begin = m_json_s->data();
+    parse_error_code error;
+    const char *p =
+        skip_value(begin + m_parse_index, begin + m_json_s->size(),
+                   m_options.max_depth - m_stack.size(), &error);
+    m_parse_index = p - begin;
+    *state = error == parse_error_code::none ? parse_state::separator
+                                             : fail(error);
+    return true;
+  }
+
+  /*
+    Check a complete value against its schema, and fail at the offset where
+    the value begins if it is rejected
+  */
+  bool check_schema(const JSONNode &node, size_t schema, size_t offset) {
+    if (m_schema->check(node, schema, &m_schema_message)) {
+      return true;
     }
-    return valid_sequence;
+    fail(parse_error_code::schema_violation, offset);
+    return false;
   }
 
-  json_parse_type parse_string(JSONNode *result) {
-    result->set_string();
-    bool string_closed = false;
-    while (remaining_parse_length() > 0) {
-      if (parse_and_compare('\"')) {
-        m_parse_index++;
-        string_closed = true;
-        break;
-      }
-      if (parse_and_compare('\\')) {
-        m_parse_index++;
-        if (parse_escape_sequence(result)) {
-          continue;
-        }
-        return json_parse_type::error;
-      }
-      *result->m_value.str += current_character();
-      m_parse_index++;
+  /*
+    Append a null element to the array; it is owned by the array right away
+    so that it is released with the partially parsed tree on error
+  */
+  JSONNode *add_array_item(JSONNode *array) {
+    JSONNode *value = array->create_node();
+    array->m_value.array->push_back(value);
+    return value;
+  }
+
+  /*
+    Parse the rest of a string after the opening quote and append the decoded
+    string to out
+  */
+  template <typename String>
+  bool parse_string(String *out) {
+    MINIJSON_STATS(stats_timer timer(&stats().string_parse_ns));
+    const char *begin = m_json_s->data();
+    parse_error_code error;
+    const char *p = scan_string(begin + m_parse_index,
+                                begin + m_json_s->size(), out, &error);
+    m_parse_index = p - begin;
+    if (error != parse_error_code::none) {
+      fail(error);
+      return false;
     }
-    return string_closed ? json_parse_type::json_value : json_parse_type::error;
+    return true;
   }
 
   void parse_whitespace() {
-    while (remaining_parse_length() >= 1 && isspace(current_character())) {
+    while (remaining_parse_length() >= 1 &&
+           is_whitespace(current_character())) {
       m_parse_index++;
     }
   }
 
-  bool parse_comma(bool is_array = false) {
-    if (current_character() == ',') {
-      m_parse_index++;
-      return true;
+  bool parse_number(JSONNode *result) {
+    MINIJSON_STATS(stats_timer timer(&stats().number_parse_ns));
+    const char *begin = m_json_s->data();
+    if (m_options.lazy_numbers) {
+      return parse_number_text(result);
     }
-    int idx = m_parse_index;
-    if (!is_array && m_json_s[idx] == '}') {
-      return true;
+    double d = 0;
+    parse_error_code error;
+    const char *start = begin + m_parse_index;
+    const char *p = scan_number(start, begin + m_json_s->size(), &d, &error);
+    m_parse_index = p - begin;
+    if (error != parse_error_code::none) {
+      fail(error);
+      return false;
     }
-    if (is_array && m_json_s[idx] == ']') {
+    using int_t = typename JSONNode::json_int_t;
+    using double_t = typename JSONNode::json_double_t;
+    // integers in the range of json_int_t are converted exactly
+    if (is_integer_text(start, p) && fits_integer<int_t>(start, p)) {
+      result->set_number_int(convert_integer<int_t>(start, p));
       return true;
     }
-    return false;
-  }
-
-  json_parse_type parse_number(JSONNode *result) {
-    std::string number_s;
-    while (remaining_parse_length() > 0) {
-      if (isdigit(current_character()) || current_character() == '-' ||
-          current_character() == '+' || current_character() == 'e' ||
-          current_character() == 'E' || current_character() == '.') {
-        number_s += current_character();
-        m_parse_index++;
-      } else {
-        break;
-      }
-    }
 
-    // check if number is valid
-    char *end_ptr = nullptr;
-    double d = strtod(number_s.c_str(), &end_ptr);
-    if (strlen(end_ptr) > 0) {
-      return json_parse_type::error;
-    }
-    // number cannot end with a dot
-    if (number_s[number_s.length() - 1] == '.') {
-      return json_parse_type::error;
-    }
     // check the number is a double or integer
     double integral_part;
     bool isDouble = (modf(d, &integral_part) != 0.0);
 
-    if (d > std::numeric_limits<int64_t>::max() ||
-        d < std::numeric_limits<int64_t>::min()) {
-      result->set_number_double(d);
+    if (d > std::numeric_limits<int_t>::max() ||
+        d < std::numeric_limits<int_t>::min()) {
+      result->set_number_double(static_cast<double_t>(d));
     } else if (isDouble) {
-      result->set_number_double(d);
+      result->set_number_double(static_cast<double_t>(d));
     } else {
-      result->set_number_int(static_cast<int64_t>(d));
+      result->set_number_int(static_cast<int_t>(d));
     }
 
-    return json_parse_type::json_value;
+    return true;
   }
 
   /*
-    Main parsing logic
+    Parse a number without converting it, keeping its text in the node.
+    Integers that do not fit json_int_t are kept as doubles.
   */
-  json_parse_type parse_value(JSONNode *result) {
-    parse_whitespace();
-    json_parse_type type = json_parse_type::error;
-    if (remaining_parse_length() >= 4 && parse_n_and_compare(4, "true")) {
-      result->set_boolean(true);
-      m_parse_index += 4;
-      type = json_parse_type::json_value;
-    } else if (remaining_parse_length() >= 5 &&
-               parse_n_and_compare(5, "false")) {
-      result->set_boolean(false);
-      m_parse_index += 5;
-      type = json_parse_type::json_value;
-    } else if (remaining_parse_length() >= 4 &&
-               parse_n_and_compare(4, "null")) {
-      m_parse_index += 4;
-      type = json_parse_type::json_value;
-    } else if (remaining_parse_length() > 1 && parse_and_compare('[')) {
-      m_parse_index++;
-      type = parse_array(result);
-    } else if (remaining_parse_length() > 1 && parse_and_compare('{')) {
-      m_parse_index++;
-      type = parse_object(result);
-    } else if (remaining_parse_length() > 0 && parse_and_compare(']')) {
-      m_parse_index++;
-      type = json_parse_type::reach_array_end;
-    } else if (remaining_parse_length() > 0 && parse_and_compare(',')) {
-      m_parse_index++;
-      type = json_parse_type::reach_array_separator;
-    } else if (remaining_parse_length() > 1 && parse_and_compare('\"')) {
-      m_parse_index++;
-      type = parse_string(result);
-    } else if (remaining_parse_length() > 0 &&
-               (isdigit(current_character()) || current_character() == '-')) {
-      type = parse_number(result);
+  bool parse_number_text(JSONNode *result) {
+    const char *begin = m_json_s->data() + m_parse_index;
+    bool is_integer = false;
+    parse_error_code error;
+    const char *p = scan_number_text(begin, m_json_s->data() + m_json_s->size(),
+                                     &is_integer, &error);
+    m_parse_index += p - begin;
+    if (error != parse_error_code::none) {
+      fail(error);
+      return false;
     }
-    parse_whitespace();
-    return type;
+    if (is_integer &&
+        !fits_integer<typename JSONNode::json_int_t>(begin, p)) {
+      is_integer = false;
+    }
+    result->set_number_text(begin, p, is_integer);
+    return true;
+  }
+
+  /*
+    Parse one of the literals true, false and null
+  */
+  bool parse_literal(const char *literal) {
+    size_t n = strlen(literal);
+    const char *begin = m_json_s->data();
+    if (!match_literal(begin + m_parse_index, begin + m_json_s->size(),
+                       literal, n)) {
+      fail(parse_error_code::invalid_literal);
+      return false;
+    }
+    m_parse_index += n;
+    return true;
+  }
+
+  static void record_node(json_value_type type) {
+    stats().nodes[static_cast<size_t>(type)]++;
+  }
+
+  /*
+    Record the first parsing error at the current position, or at offset
+  */
+  parse_state fail(parse_error_code code) {
+    return fail(code, m_parse_index);
+  }
+  parse_state fail(parse_error_code code, size_t offset) {
+    if (m_error.code == parse_error_code::none) {
+      m_error.code = code;
+      m_error.offset = offset;
+    }
+    return parse_state::error;
   }
 
  private:
-  size_t remaining_parse_length() { return m_json_s.length() - m_parse_index; }
-  bool parse_n_and_compare(size_t n, const char *s) {
-    return strcmp(m_json_s.substr(m_parse_index, n).c_str(), s) == 0;
+  size_t remaining_parse_length() {
+    return m_json_s->length() - m_parse_index;
   }
   bool parse_and_compare(const char ch) { return current_character() == ch; }
-  const char current_character() { return m_json_s[m_parse_index]; }
+  const char current_character() { return (*m_json_s)[m_parse_index]; }
 
  private:
-  JSONNode *m_result;
-  const std::string &m_json_s;
-  unsigned int m_parse_index = 0;
+  const std::string *m_json_s = nullptr;
+  parse_options m_options;
+  size_t m_parse_index = 0;
+  parse_result m_error;
+  std::vector<JSONNode *> m_stack;         // arrays and objects being parsed
+  typename JSONNode::json_string_t m_key;  // object key being parsed
+  const field_mask *m_mask = nullptr;      // fields to build, if any
+  std::vector<size_t> m_masks;  // mask nodes of the arrays/objects on m_stack
+  size_t m_value_mask = field_mask::all;  // mask node of the next value
+  const schema_program<JSONNode> *m_schema = nullptr;  // schema, if any
+  // schemas and start offsets of the arrays/objects on m_stack
+  std::vector<std::pair<size_t, size_t>> m_schemas;
+  size_t m_value_schema = schema_program<JSONNode>::any;  // of the next value
+  std::string m_schema_message;  // reason of the last violation
 };
 }  // namespace detail
 }  // namespace miniJSON
@@ -0,0 +1,452 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../errors.h"
+#include "../json_types.h"
+#include "./pointer.h"
+
+namespace miniJSON {
+namespace detail {
+template <typename JSONNode>
+/*
+  Patcher is responsible for applying JSON Patch (RFC 6902) and JSON Merge
+  Patch (RFC 7396) documents to a JSON node in place.
+*/
+class patcher {
+ public:
+  explicit patcher(JSONNode *target) : m_target(target) {}
+
+ public:
+  /*
+    Apply JSON Patch document. Values are moved out of the patch document
+    instead of being copied. It will throw error if one of the operations
+    cannot be applied, in which case the previously applied operations are
+    rolled back and the target is left unchanged.
+  */
+  void apply_patch(JSONNode *patch) {
+    if (patch->m_type != json_value_type::array) {
+      MINIJSON_THROW(json_patch_error("patch document must be an array"));
+    }
+    patch->detach();
+    auto &operations = *patch->m_value.array;
+    for (size_t i = 0; i < operations.size(); i++) {
+      const char *error = apply_operation(operations[i]);
+      if (error != nullptr) {
+        rollback();
+        MINIJSON_THROW(json_patch_error("operation " + std::to_string(i) +
+                                        ": " + error));
+      }
+    }
+    commit();
+  }
+
+  /*
+    Apply JSON Merge Patch document. Values are moved out of the patch document
+    instead of being copied.
+  */
+  void apply_merge_patch(JSONNode *patch) { merge_patch(m_target, patch); }
+
+ private:
+  using string_t = typename JSONNode::json_string_t;
+
+  enum class undo_type {
+    object_added,
+    object_removed,
+    object_replaced,
+    array_added,
+    array_removed,
+    array_replaced,
+    root_replaced
+  };
+
+  /*
+    Record of a single modification made to the target, used to roll back the
+    patch if one of its operations fails.
+    - node: removed or replaced node kept alive until the patch is committed
+    - source: the emptied node whose value was moved to the root
+    - transferred: the node is taken over by a move operation, so it must not
+      be deleted when the record is committed or rolled back
+  */
+  struct undo_record {
+    undo_type type;
+    JSONNode *parent;
+    string_t key;
+    size_t index;
+    JSONNode *node;
+    JSONNode *source;
+    bool transferred;
+  };
+
+  const char *apply_operation(JSONNode *operation) {
+    if (operation->m_type != json_value_type::object) {
+      return "operation must be an object";
+    }
+    operation->detach();
+    JSONNode *op = member(operation, "op");
+    JSONNode *path = member(operation, "path");
+    if (op == nullptr || op->m_type != json_value_type::string) {
+      return "missing \"op\" member";
+    }
+    if (path == nullptr || path->m_type != json_value_type::string) {
+      return "missing \"path\" member";
+    }
+    std::vector<string_t> tokens;
+    if (!parse_pointer(*path->m_value.str, &tokens)) {
+      return "invalid JSON pointer in \"path\" member";
+    }
+
+    const string_t &name = *op->m_value.str;
+    if (name == "add" || name == "replace" || name == "test") {
+      JSONNode *value = member(operation, "value");
+      if (value == nullptr) {
+        return "missing \"value\" member";
+      }
+      if (name == "test") {
+        const JSONNode *target = find(tokens, tokens.size(), false);
+        if (target == nullptr) {
+          return "path does not exist";
+        }
+        return *target == *value ? nullptr : "test failed";
+      }
+      JSONNode *node = m_target->create_node(std::move(*value));
+      return name == "add" ? add(tokens, node, false)
+                           : replace(tokens, node);
+    }
+    if (name == "remove") {
+      return remove(tokens, nullptr);
+    }
+    if (name == "move" || name == "copy") {
+      JSONNode *from = member(operation, "from");
+      if (from == nullptr || from->m_type != json_value_type::string) {
+        return "missing \"from\" member";
+      }
+      std::vector<string_t> from_tokens;
+      if (!parse_pointer(*from->m_value.str, &from_tokens)) {
+        return "invalid JSON pointer in \"from\" member";
+      }
+      if (name == "copy") {
+        const JSONNode *source = find(from_tokens, from_tokens.size(), false);
+        if (source == nullptr) {
+          return "from path does not exist";
+        }
+        return add(tokens, m_target->create_node(*source), false);
+      }
+      if (from_tokens == tokens) {
+        return nullptr;
+      }
+      if (is_proper_prefix(from_tokens, tokens)) {
+        return "cannot move a value into one of its children";
+      }
+      JSONNode *node = nullptr;
+      const char *error = remove(from_tokens, &node);
+      if (error != nullptr) {
+        return error;
+      }
+      return add(tokens, node, true);
+    }
+    return "unknown operation";
+  }
+
+  /*
+    Add node (ownership is taken) at the location referenced by tokens
+  */
+  const char *add(const std::vector<string_t> &tokens, JSONNode *node,
+                  bool transferred) {
+    if (tokens.empty()) {
+      replace_root(node, transferred);
+      return nullptr;
+    }
+    JSONNode *parent = find(tokens, tokens.size() - 1, true);
+    const string_t &key = tokens.back();
+    if (parent != nullptr && parent->m_type == json_value_type::object) {
+      auto res = parent->m_value.object->emplace(key, node);
+      if (res.second) {
+        log(undo_type::object_added, parent, key, 0, nullptr, transferred);
+      } else {
+        log(undo_type::object_replaced, parent, key, 0, *res.first,
+            transferred);
+        *res.first = node;
+      }
+      return nullptr;
+    }
+    if (parent != nullptr && parent->m_type == json_value_type::array) {
+      auto &array = *parent->m_value.array;
+      size_t index = array.size();
+      if ((key == "-" || parse_index(key, &index)) && index <= array.size()) {
+        array.insert(array.begin() + index, node);
+        log(undo_type::array_added, parent, "", index, nullptr, transferred);
+        return nullptr;
+      }
+    }
+    if (!transferred) {
+      JSONNode::destroy_node(node);
+    }
+    return "path cannot be added to";
+  }
+
+  /*
+    Remove the node at the location referenced by tokens. If removed is not
+    null, the node is handed over to the caller instead of being deleted.
+  */
+  const char *remove(const std::vector<string_t> &tokens,
+                     JSONNode **removed) {
+    if (tokens.empty()) {
+      return "root cannot be removed";
+    }
+    JSONNode *parent = find(tokens, tokens.size() - 1, true);
+    const string_t &key = tokens.back();
+    JSONNode *node = nullptr;
+    if (parent != nullptr && parent->m_type == json_value_type::object) {
+      auto child = parent->m_value.object->find(key);
+      if (child != nullptr) {
+        node = *child;
+        size_t pos = parent->m_value.object->index_of(key);
+        parent->m_value.object->erase(key);
+        log(undo_type::object_removed, parent, key, pos, node,
+            removed != nullptr);
+      }
+    } else if (parent != nullptr && parent->m_type == json_value_type::array) {
+      auto &array = *parent->m_value.array;
+      size_t index = 0;
+      if (parse_index(key, &index) && index < array.size()) {
+        node = array[index];
+        array.erase(array.begin() + index);
+        log(undo_type::array_removed, parent, "", index, node,
+            removed != nullptr);
+      }
+    }
+    if (node == nullptr) {
+      return "path does not exist";
+    }
+    if (removed != nullptr) {
+      *removed = node;
+    }
+    return nullptr;
+  }
+
+  /*
+    Replace the node at the location referenced by tokens with node (ownership
+    is taken)
+  */
+  const char *replace(const std::vector<string_t> &tokens, JSONNode *node) {
+    if (tokens.empty()) {
+      replace_root(node, false);
+      return nullptr;
+    }
+    JSONNode *parent = find(tokens, tokens.size() - 1, true);
+    const string_t &key = tokens.back();
+    if (parent != nullptr && parent->m_type == json_value_type::object) {
+      auto child = parent->m_value.object->find(key);
+      if (child != nullptr) {
+        log(undo_type::object_replaced, parent, key, 0, *child, false);
+        (*parent->m_value.object)[key] = node;
+        return nullptr;
+      }
+    } else if (parent != nullptr && parent->m_type == json_value_type::array) {
+      auto &array = *parent->m_value.array;
+      size_t index = 0;
+      if (parse_index(key, &index) && index < array.size()) {
+        log(undo_type::array_replaced, parent, "", index, array[index], false);
+        array[index] = node;
+        return nullptr;
+      }
+    }
+    JSONNode::destroy_node(node);
+    return "path does not exist";
+  }
+
+  void replace_root(JSONNode *node, bool transferred) {
+    JSONNode *root = m_target->create_node(std::move(*m_target));
+    *m_target = std::move(*node);
+    m_undo_log.push_back({undo_type::root_replaced, nullptr, "", 0, root,
+                          transferred ? node : nullptr, transferred});
+    if (!transferred) {
+      JSONNode::destroy_node(node);
+    }
+  }
+
+  void log(undo_type type, JSONNode *parent, const string_t &key,
+           size_t index, JSONNode *node, bool transferred) {
+    m_undo_log.push_back(
+        {type, parent, key, index, node, nullptr, transferred});
+  }
+
+  /*
+    Free the nodes removed or replaced by the patch
+  */
+  void commit() {
+    for (auto &record : m_undo_log) {
+      switch (record.type) {
+        case undo_type::object_removed:
+        case undo_type::array_removed:
+          if (!record.transferred) {
+            JSONNode::destroy_node(record.node);
+          }
+          break;
+        case undo_type::object_replaced:
+        case undo_type::array_replaced:
+          JSONNode::destroy_node(record.node);
+          break;
+        case undo_type::root_replaced:
+          JSONNode::destroy_node(record.node);
+          JSONNode::destroy_node(record.source);
+          break;
+        default:
+          break;
+      }
+    }
+    m_undo_log.clear();
+  }
+
+  /*
+    Undo the modifications made by the patch in reverse order
+  */
+  void rollback() {
+    for (auto it = m_undo_log.rbegin(); it != m_undo_log.rend(); it++) {
+      JSONNode *parent = it->parent;
+      JSONNode *current = nullptr;
+      switch (it->type) {
+        case undo_type::object_added:
+          current = (*parent->m_value.object)[it->key];
+          parent->m_value.object->erase(it->key);
+          break;
+        case undo_type::object_removed:
+          parent->m_value.object->insert_at(it->index, it->key, it->node);
+          break;
+        case undo_type::object_replaced:
+          current = (*parent->m_value.object)[it->key];
+          (*parent->m_value.object)[it->key] = it->node;
+          break;
+        case undo_type::array_added:
+          current = (*parent->m_value.array)[it->index];
+          parent->m_value.array->erase(parent->m_value.array->begin() +
+                                       it->index);
+          break;
+        case undo_type::array_removed:
+          parent->m_value.array->insert(
+              parent->m_value.array->begin() + it->index, it->node);
+          break;
+        case undo_type::array_replaced:
+          current = (*parent->m_value.array)[it->index];
+          (*parent->m_value.array)[it->index] = it->node;
+          break;
+        case undo_type::root_replaced:
+          if (it->source != nullptr) {
+            *it->source = std::move(*m_target);
+          }
+          *m_target = std::move(*it->node);
+          JSONNode::destroy_node(it->node);
+          break;
+        default:
+          break;
+      }
+      if (!it->transferred) {
+        JSONNode::destroy_node(current);
+      }
+    }
+    m_undo_log.clear();
+  }
+
+  void merge_patch(JSONNode *target, JSONNode *patch) {
+    if (patch->m_type != json_value_type::object) {
+      *target = std::move(*patch);
+      return;
+    }
+    if (target->m_type != json_value_type::object) {
+      *target = JSONNode(json_value_type::object);
+    }
+    target->detach();
+    patch->detach();
+    for (auto &key : *patch->m_value.object) {
+      JSONNode *value = (*patch->m_value.object)[key];
+      if (value->m_type == json_value_type::null) {
+        target->erase(key);
+        continue;
+      }
+      auto res = target->m_value.object->emplace(key, nullptr);
+      if (res.second) {
+        *res.first = target->create_node();
+      }
+      merge_patch(*res.first, value);
+    }
+  }
+
+ private:
+  /*
+    Find the node referenced by the first n tokens. When write is true, every
+    node on the way is detached from other shared copies as it is about to be
+    modified.
+  */
+  JSONNode *find(const std::vector<string_t> &tokens, size_t n,
+                 bool write) {
+    JSONNode *node = m_target;
+    for (size_t i = 0; i <= n; i++) {
+      if (write) {
+        node->detach();
+      }
+      if (i == n) {
+        break;
+      }
+      if (node->m_type == json_value_type::object) {
+        auto child = node->m_value.object->find(tokens[i]);
+        if (child == nullptr) {
+          return nullptr;
+        }
+        node = *child;
+      } else if (node->m_type == json_value_type::array) {
+        size_t index = 0;
+        if (!parse_index(tokens[i], &index) ||
+            index >= node->m_value.array->size()) {
+          return nullptr;
+        }
+        node = (*node->m_value.array)[index];
+      } else {
+        return nullptr;
+      }
+    }
+    return node;
+  }
+
+  static JSONNode *member(JSONNode *object, const string_t &key) {
+    auto child = object->m_value.object->find(key);
+    return child == nullptr ? nullptr : *child;
+  }
+
+  static bool parse_index(const string_t &token, size_t *index) {
+    if (token.empty() || (token.size() > 1 && token[0] == '0')) {
+      return false;
+    }
+    const size_t max = std::numeric_limits<size_t>::max();
+    size_t res = 0;
+    for (char c : token) {
+      if (c < '0' || c > '9') {
+        return false;
+      }
+      size_t digit = static_cast<size_t>(c - '0');
+      if (res > (max - digit) / 10) {
+        return false;  // the index would overflow
+      }
+      res = res * 10 + digit;
+    }
+    *index = res;
+    return true;
+  }
+
+  static bool is_proper_prefix(const std::vector<string_t> &prefix,
+                               const std::vector<string_t> &tokens) {
+    return prefix.size() < tokens.size() &&
+           std::equal(prefix.begin(), prefix.end(), tokens.begin());
+  }
+
+ private:
+  JSONNode *m_target;
+  std::vector<undo_record> m_undo_log;
+};
+}  // namespace detail
+}  // namespace miniJSON
@@ -0,0 +1,916 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../errors.h"
+#include "../json_types.h"
+#include "../options.h"
+#include "./lexer.h"
+#include "./parser.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  A step of a compiled JSONPath expression
+  - name: the member with the name
+  - index: the element at the index
+  - wildcard: all members/elements
+  - descendant: the node itself and all its descendants (..)
+  - filter: the members/elements for which the filter is true
+*/
+struct path_step {
+  enum class kind { name, index, wildcard, descendant, filter };
+  kind type;
+  std::string name;
+  size_t index = 0;
+  size_t filter = 0;  // root of the filter expression in path_plan::filters
+};
+
+/*
+  Operand of a filter comparison: a path relative to the current node (@)
+  made of name and index steps, or a literal
+*/
+struct path_operand {
+  bool relative = false;
+  std::vector<path_step> path;
+  json_value_type type = json_value_type::null;  // type of the literal
+  int64_t integer = 0;
+  double number = 0;
+  bool boolean = false;
+  std::string str;
+};
+
+/*
+  Node of a filter expression. Logical operators refer to their operands by
+  their index in path_plan::filters; exists tests if lhs is present.
+*/
+struct path_filter {
+  enum class kind {
+    logical_or,
+    logical_and,
+    exists,
+    equal,
+    not_equal,
+    less,
+    less_equal,
+    greater,
+    greater_equal
+  };
+  kind type;
+  size_t left = 0;
+  size_t right = 0;
+  path_operand lhs;
+  path_operand rhs;
+};
+
+/*
+  Query plan of a JSONPath expression
+*/
+struct path_plan {
+  std::vector<path_step> steps;
+  std::vector<path_filter> filters;
+};
+
+/*
+  Compiler of the supported JSONPath subset into a query plan:
+    $                     the root
+    .name  ['name']       member
+    [0]                   array element
+    .*  [*]               all members/elements
+    ..name  ..*  ..[...]  descendants
+    [?(<filter>)]         members/elements for which the filter is true
+  Filters compare @-relative paths (@.a.b, @['a'][0]) and literals (numbers,
+  'strings', "strings", true, false, null) with ==, !=, <, <=, >, >=, test
+  if a path exists (@.a), and combine them with &&, || and parentheses.
+*/
+class path_compiler {
+ public:
+  explicit path_compiler(const std::string &expression)
+      : m_s(expression) {}
+
+  path_plan compile() {
+    if (m_s.empty() || m_s[0] != '$') {
+      fail("expected $");
+    }
+    m_pos = 1;
+    while (m_pos < m_s.size()) {
+      if (consume("..")) {
+        add_step(path_step::kind::descendant);
+        if (peek() == '[') {
+          parse_bracket();
+        } else {
+          parse_dot_member();
+        }
+      } else if (consume(".")) {
+        parse_dot_member();
+      } else if (peek() == '[') {
+        parse_bracket();
+      } else {
+        fail("unexpected character");
+      }
+    }
+    return std::move(m_plan);
+  }
+
+ private:
+  void parse_dot_member() {
+    if (consume("*")) {
+      add_step(path_step::kind::wildcard);
+      return;
+    }
+    path_step step;
+    step.type = path_step::kind::name;
+    step.name = parse_name();
+    m_plan.steps.push_back(std::move(step));
+  }
+
+  void parse_bracket() {
+    m_pos++;
+    skip_whitespace();
+    path_step step;
+    char c = peek();
+    if (c == '*') {
+      m_pos++;
+      step.type = path_step::kind::wildcard;
+    } else if (c == '\'' || c == '"') {
+      step.type = path_step::kind::name;
+      step.name = parse_quoted();
+    } else if (isdigit(static_cast<unsigned char>(c))) {
+      step.type = path_step::kind::index;
+      step.index = parse_index();
+    } else if (consume("?")) {
+      skip_whitespace();
+      expect('(');
+      step.type = path_step::kind::filter;
+      step.filter = parse_or();
+      skip_whitespace();
+      expect(')');
+    } else {
+      fail("expected name, index, * or filter");
+    }
+    skip_whitespace();
+    expect(']');
+    m_plan.steps.push_back(std::move(step));
+  }
+
+  size_t parse_or() {
+    size_t left = parse_and();
+    for (;;) {
+      skip_whitespace();
+      if (!consume("||")) {
+        return left;
+      }
+      size_t right = parse_and();
+      left = add_logical(path_filter::kind::logical_or, left, right);
+    }
+  }
+
+  size_t parse_and() {
+    size_t left = parse_unary();
+    for (;;) {
+      skip_whitespace();
+      if (!consume("&&")) {
+        return left;
+      }
+      size_t right = parse_unary();
+      left = add_logical(path_filter::kind::logical_and, left, right);
+    }
+  }
+
+  size_t parse_unary() {
+    skip_whitespace();
+    if (consume("(")) {
+      size_t res = parse_or();
+      skip_whitespace();
+      expect(')');
+      return res;
+    }
+    path_filter filter;
+    filter.lhs = parse_operand();
+    skip_whitespace();
+    static const struct {
+      const char *token;
+      path_filter::kind type;
+    } operators[] = {{"==", path_filter::kind::equal},
+                     {"!=", path_filter::kind::not_equal},
+                     {"<=", path_filter::kind::less_equal},
+                     {">=", path_filter::kind::greater_equal},
+                     {"<", path_filter::kind::less},
+                     {">", path_filter::kind::greater}};
+    filter.type = path_filter::kind::exists;
+    for (auto &op : operators) {
+      if (consume(op.token)) {
+        filter.type = op.type;
+        break;
+      }
+    }
+    if (filter.type == path_filter::kind::exists) {
+      if (!filter.lhs.relative) {
+        fail("expected comparison operator");
+      }
+    } else {
+      filter.rhs = parse_operand();
+    }
+    m_plan.filters.push_back(std::move(filter));
+    return m_plan.filters.size() - 1;
+  }
+
+  path_operand parse_operand() {
+    skip_whitespace();
+    path_operand operand;
+    char c = peek();
+    if (consume("@")) {
+      operand.relative = true;
+      for (;;) {
+        path_step step;
+        if (consume(".")) {
+          step.type = path_step::kind::name;
+          step.name = parse_name();
+        } else if (peek() == '[') {
+          m_pos++;
+          skip_whitespace();
+          char d = peek();
+          if (d == '\'' || d == '"') {
+            step.type = path_step::kind::name;
+            step.name = parse_quoted();
+          } else if (isdigit(static_cast<unsigned char>(d))) {
+            step.type = path_step::kind::index;
+            step.index = parse_index();
+          } else {
+            fail("expected name or index");
+          }
+          skip_whitespace();
+          expect(']');
+        } else {
+          return operand;
+        }
+        operand.path.push_back(std::move(step));
+      }
+    }
+    if (c == '\'' || c == '"') {
+      operand.type = json_value_type::string;
+      operand.str = parse_quoted();
+    } else if (c == '-' || isdigit(static_cast<unsigned char>(c))) {
+      parse_number(&operand);
+    } else if (consume("true") || consume("false")) {
+      operand.type = json_value_type::boolean;
+      operand.boolean = c == 't';
+    } else if (consume("null")) {
+      operand.type = json_value_type::null;
+    } else {
+      fail("expected @, string, number, true, false or null");
+    }
+    return operand;
+  }
+
+  void parse_number(path_operand *operand) {
+    size_t start = m_pos;
+    while (m_pos < m_s.size() && is_number_character(m_s[m_pos])) {
+      m_pos++;
+    }
+    std::string number_s = m_s.substr(start, m_pos - start);
+    char *end_ptr = nullptr;
+    double d = strtod(number_s.c_str(), &end_ptr);
+    if (*end_ptr != '\0') {
+      m_pos = start;
+      fail("invalid number");
+    }
+    if (number_s.find_first_of(".eE") == std::string::npos &&
+        d >= -9223372036854775808.0 && d < 9223372036854775808.0) {
+      operand->type = json_value_type::number_int;
+      operand->integer = strtoll(number_s.c_str(), nullptr, 10);
+    } else {
+      operand->type = json_value_type::number_double;
+      operand->number = d;
+    }
+  }
+
+  std::string parse_name() {
+    size_t start = m_pos;
+    while (m_pos < m_s.size() && is_name_character(m_s[m_pos])) {
+      m_pos++;
+    }
+    if (m_pos == start) {
+      fail("expected name");
+    }
+    return m_s.substr(start, m_pos - start);
+  }
+
+  /*
+    Parse a name enclosed in single or double quotes. A backslash escapes the
+    character after it.
+  */
+  std::string parse_quoted() {
+    char quote = m_s[m_pos++];
+    std::string res;
+    while (m_pos < m_s.size() && m_s[m_pos] != quote) {
+      if (m_s[m_pos] == '\\' && m_pos + 1 < m_s.size()) {
+        m_pos++;
+      }
+      res += m_s[m_pos++];
+    }
+    expect(quote);
+    return res;
+  }
+
+  size_t parse_index() {
+    size_t res = 0;
+    while (m_pos < m_s.size() &&
+           isdigit(static_cast<unsigned char>(m_s[m_pos]))) {
+      res = res * 10 + (m_s[m_pos++] - '0');
+    }
+    return res;
+  }
+
+  static bool is_number_character(char c) {
+    return isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' ||
+           c == '.' || c == 'e' || c == 'E';
+  }
+
+  static bool is_name_character(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return isalnum(u) || c == '_' || c == '-' || c == '$' || u >= 0x80;
+  }
+
+  void add_step(path_step::kind type) {
+    path_step step;
+    step.type = type;
+    m_plan.steps.push_back(std::move(step));
+  }
+
+  size_t add_logical(path_filter::kind type, size_t left, size_t right) {
+    path_filter filter;
+    filter.type = type;
+    filter.left = left;
+    filter.right = right;
+    m_plan.filters.push_back(std::move(filter));
+    return m_plan.filters.size() - 1;
+  }
+
+  char peek() const { return m_pos < m_s.size() ? m_s[m_pos] : '\0'; }
+
+  bool consume(const char *token) {
+    size_t n = strlen(token);
+    if (m_s.compare(m_pos, n, token) != 0) {
+      return false;
+    }
+    m_pos += n;
+    return true;
+  }
+
+  void expect(char c) {
+    if (peek() != c) {
+      fail((std::string("expected ") + c).c_str());
+    }
+    m_pos++;
+  }
+
+  void skip_whitespace() {
+    while (m_pos < m_s.size() && is_whitespace(m_s[m_pos])) {
+      m_pos++;
+    }
+  }
+
+  void fail(const char *message) {
+    static_cast<void>(message);  // unused when exceptions are disabled
+    MINIJSON_THROW(json_path_error(std::string(message) + " at offset " +
+                                   std::to_string(m_pos) + " of \"" + m_s +
+                                   "\""));
+  }
+
+ private:
+  const std::string &m_s;
+  size_t m_pos = 0;
+  path_plan m_plan;
+};
+
+template <typename JSONNode>
+/*
+  Evaluator of a query plan. The plan is run as an automaton: every node is
+  visited with the set of steps that are still to be applied to it, so each
+  matching node is found once and in document order.
+  - select: run over a JSON node; results are the nodes of the tree
+  - stream: run over a JSON string without building the tree. Only the
+    matched values and the elements tested by filters are parsed into JSON
+    nodes, everything else is skipped and only validated.
+*/
+class path_evaluator {
+ public:
+  explicit path_evaluator(const path_plan &plan) : m_plan(plan) {}
+
+  /*
+    Call emit with every matching node of the tree under root
+  */
+  template <typename F>
+  void select(const JSONNode &root, F &emit) {
+    run(root, states_t{0}, emit);
+  }
+
+  /*
+    Call emit with every matching value of the JSON string
+  */
+  template <typename F>
+  parse_result stream(const std::string &s, const parse_options &options,
+                      F &emit) {
+    const char *begin = s.data();
+    const char *end = begin + s.size();
+    const char *p = begin;
+    parse_error_code error = parse_error_code::none;
+    states_t arriving{0};
+    bool expect_key = false;
+    m_frames.clear();
+    for (;;) {
+      p = skip_whitespace(p, end);
+      if (expect_key) {
+        // an object key and the colon after it
+        if (p == end || *p != '"') {
+          return result(p == end ? parse_error_code::unexpected_end
+                                 : parse_error_code::expected_key,
+                        p, begin);
+        }
+        m_key.clear();
+        p = scan_string(p + 1, end, &m_key, &error);
+        if (error != parse_error_code::none) {
+          return result(error, p, begin);
+        }
+        p = skip_whitespace(p, end);
+        if (p == end || *p != ':') {
+          return result(p == end ? parse_error_code::unexpected_end
+                                 : parse_error_code::expected_colon,
+                        p, begin);
+        }
+        p = skip_whitespace(p + 1, end);
+        arriving.clear();
+        advance(m_frames.back().states, m_key.data(), m_key.size(), 0,
+                &arriving);
+        expect_key = false;
+      }
+      if (p == end) {
+        return result(parse_error_code::unexpected_end, p, begin);
+      }
+      size_t depth = m_frames.size();
+      bool filter = depth > 0 && m_frames.back().filter;
+      closure(arriving, &m_closure);
+      if (filter || is_final(m_closure)) {
+        // the value is a result or is tested by a filter: build it
+        JSONNode value;
+        size_t value_end = 0;
+        parse_options value_options = options;
+        value_options.max_depth = options.max_depth - depth;
+        parse_result res = m_parser.parse_prefix(s, p - begin, &value,
+                                                 value_options, &value_end);
+        if (!res) {
+          return res;
+        }
+        if (filter) {
+          advance_filters(m_frames.back().states, value, &arriving);
+        }
+        run(value, arriving, emit);
+        p = begin + value_end;
+      } else if (m_closure.empty() || (*p != '[' && *p != '{')) {
+        p = skip_value(p, end, options.max_depth - depth, &error);
+        if (error != parse_error_code::none) {
+          return result(error, p, begin);
+        }
+      } else {
+        if (depth >= options.max_depth) {
+          return result(parse_error_code::depth_exceeded, p, begin);
+        }
+        bool is_object = *p == '{';
+        p = skip_whitespace(p + 1, end);
+        if (p == end || *p != (is_object ? '}' : ']')) {
+          m_frames.push_back(
+              frame{is_object, 0, m_closure, has_filter(m_closure)});
+          expect_key = is_object;
+          if (!is_object) {
+            arriving.clear();
+            advance(m_frames.back().states, nullptr, 0, 0, &arriving);
+          }
+          continue;
+        }
+        p++;
+      }
+      // the comma or the closing brackets after the value
+      for (;;) {
+        p = skip_whitespace(p, end);
+        if (m_frames.empty()) {
+          return p == end ? parse_result()
+                          : result(parse_error_code::trailing_characters, p,
+                                   begin);
+        }
+        frame &f = m_frames.back();
+        if (p < end && *p == ',') {
+          p++;
+          f.index++;
+          expect_key = f.is_object;
+          if (!f.is_object) {
+            arriving.clear();
+            advance(f.states, nullptr, 0, f.index, &arriving);
+          }
+          break;
+        }
+        if (p < end && *p == (f.is_object ? '}' : ']')) {
+          p++;
+          m_frames.pop_back();
+          continue;
+        }
+        return result(p == end ? parse_error_code::unexpected_end
+                               : parse_error_code::expected_comma_or_end,
+                      p, begin);
+      }
+    }
+  }
+
+ private:
+  using string_t = typename JSONNode::json_string_t;
+  using states_t = std::vector<size_t>;  // indices of the next step
+
+  /*
+    An array/object being streamed and the states of the automaton in it
+  */
+  struct frame {
+    bool is_object;
+    size_t index;
+    states_t states;
+    bool filter;
+  };
+
+  /*
+    Value of a filter operand. Missing values are not present.
+  */
+  struct operand_value {
+    bool present = false;
+    json_value_type type = json_value_type::null;
+    const JSONNode *node = nullptr;
+    int64_t integer = 0;
+    double number = 0;
+    bool boolean = false;
+    const char *str = nullptr;
+    size_t size = 0;
+  };
+
+  /*
+    Visit the tree under root in document order with an explicit stack
+  */
+  template <typename F>
+  void run(const JSONNode &root, states_t states, F &emit) {
+    struct item {
+      const JSONNode *node;
+      states_t states;
+    };
+    std::vector<item> stack;
+    stack.push_back(item{&root, std::move(states)});
+    states_t c;
+    while (!stack.empty()) {
+      item it = std::move(stack.back());
+      stack.pop_back();
+      closure(it.states, &c);
+      if (c.empty()) {
+        continue;
+      }
+      const JSONNode &node = *it.node;
+      if (is_final(c)) {
+        emit(node);
+      }
+      size_t first = stack.size();
+      if (node.m_type == json_value_type::array) {
+        auto &array = *node.m_value.array;
+        const path_step *step = single_step(c);
+        if (step != nullptr && step->type == path_step::kind::index) {
+          // only one element is wanted
+          if (step->index < array.size()) {
+            stack.push_back(item{array[step->index], states_t{c[0] + 1}});
+          }
+          continue;
+        }
+        for (size_t i = 0; i < array.size(); i++) {
+          states_t child;
+          advance(c, nullptr, 0, i, &child);
+          advance_filters(c, *array[i], &child);
+          if (!child.empty()) {
+            stack.push_back(item{array[i], std::move(child)});
+          }
+        }
+      } else if (node.m_type == json_value_type::object) {
+        auto &object = *node.m_value.object;
+        const path_step *step = single_step(c);
+        if (step != nullptr && step->type == path_step::kind::name) {
+          // only one member is wanted
+          const JSONNode *child = member(node, step->name);
+          if (child != nullptr) {
+            stack.push_back(item{child, states_t{c[0] + 1}});
+          }
+          continue;
+        }
+        for (auto i = object.values_begin(); i != object.values_end(); i++) {
+          states_t child;
+          advance(c, i.key().data(), i.key().size(), 0, &child);
+          advance_filters(c, **i, &child);
+          if (!child.empty()) {
+            stack.push_back(item{*i, std::move(child)});
+          }
+        }
+      }
+      std::reverse(stack.begin() + first, stack.end());
+    }
+  }
+
+  /*
+    Add the states reached without moving to a child: a descendant step also
+    applies the step after it to the node itself
+  */
+  void closure(const states_t &states, states_t *out) const {
+    out->clear();
+    for (size_t i : states) {
+      out->push_back(i);
+      if (i < m_plan.steps.size() &&
+          m_plan.steps[i].type == path_step::kind::descendant) {
+        out->push_back(i + 1);
+      }
+    }
+    normalize(out);
+  }
+
+  bool is_final(const states_t &states) const {
+    return !states.empty() && states.back() == m_plan.steps.size();
+  }
+
+  bool has_filter(const states_t &states) const {
+    for (size_t i : states) {
+      if (i < m_plan.steps.size() &&
+          m_plan.steps[i].type == path_step::kind::filter) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*
+    Get the step if it is the only one still to be applied to the children
+  */
+  const path_step *single_step(const states_t &states) const {
+    size_t n = states.size() - (is_final(states) ? 1 : 0);
+    return n == 1 ? &m_plan.steps[states[0]] : nullptr;
+  }
+
+  /*
+    Add the states of the child with the key (object member, key is null for
+    array elements) or index reached by all steps but filters
+  */
+  void advance(const states_t &states, const char *key, size_t key_size,
+               size_t index, states_t *out) const {
+    for (size_t i : states) {
+      if (i == m_plan.steps.size()) {
+        continue;
+      }
+      const path_step &step = m_plan.steps[i];
+      switch (step.type) {
+        case path_step::kind::name:
+          if (key != nullptr && step.name.size() == key_size &&
+              memcmp(step.name.data(), key, key_size) == 0) {
+            out->push_back(i + 1);
+          }
+          break;
+        case path_step::kind::index:
+          if (key == nullptr && step.index == index) {
+            out->push_back(i + 1);
+          }
+          break;
+        case path_step::kind::wildcard:
+          out->push_back(i + 1);
+          break;
+        case path_step::kind::descendant:
+          out->push_back(i);
+          break;
+        default:
+          break;
+      }
+    }
+    normalize(out);
+  }
+
+  /*
+    Add the states of the child reached by filter steps
+  */
+  void advance_filters(const states_t &states, const JSONNode &child,
+                       states_t *out) const {
+    for (size_t i : states) {
+      if (i < m_plan.steps.size() &&
+          m_plan.steps[i].type == path_step::kind::filter &&
+          test(m_plan.steps[i].filter, child)) {
+        out->push_back(i + 1);
+      }
+    }
+    normalize(out);
+  }
+
+  static void normalize(states_t *states) {
+    std::sort(states->begin(), states->end());
+    states->erase(std::unique(states->begin(), states->end()), states->end());
+  }
+
+  bool test(size_t index, const JSONNode &node) const {
+    const path_filter &f = m_plan.filters[index];
+    switch (f.type) {
+      case path_filter::kind::logical_or:
+        return test(f.left, node) || test(f.right, node);
+      case path_filter::kind::logical_and:
+        return test(f.left, node) && test(f.right, node);
+      case path_filter::kind::exists:
+        return resolve(f.lhs, node).present;
+      default:
+        break;
+    }
+    operand_value a = resolve(f.lhs, node);
+    operand_value b = resolve(f.rhs, node);
+    switch (f.type) {
+      case path_filter::kind::equal:
+        return equal(a, b);
+      case path_filter::kind::not_equal:
+        return !equal(a, b);
+      case path_filter::kind::less:
+        return less(a, b);
+      case path_filter::kind::less_equal:
+        return less(a, b) || (a.present && equal(a, b));
+      case path_filter::kind::greater:
+        return less(b, a);
+      default:
+        return less(b, a) || (a.present && equal(a, b));
+    }
+  }
+
+  static operand_value resolve(const path_operand &operand,
+                               const JSONNode &node) {
+    operand_value v;
+    if (!operand.relative) {
+      v.present = true;
+      v.type = operand.type;
+      v.integer = operand.integer;
+      v.number = operand.number;
+      v.boolean = operand.boolean;
+      v.str = operand.str.data();
+      v.size = operand.str.size();
+      return v;
+    }
+    const JSONNode *j = &node;
+    for (const path_step &step : operand.path) {
+      if (step.type == path_step::kind::name &&
+          j->m_type == json_value_type::object) {
+        j = member(*j, step.name);
+      } else if (step.type == path_step::kind::index &&
+                 j->m_type == json_value_type::array &&
+                 step.index < j->m_value.array->size()) {
+        j = (*j->m_value.array)[step.index];
+      } else {
+        j = nullptr;
+      }
+      if (j == nullptr) {
+        return v;
+      }
+    }
+    if (j->m_type == json_value_type::indeterminate) {
+      return v;
+    }
+    v.present = true;
+    v.type = j->m_type;
+    v.node = j;
+    if (v.type == json_value_type::number_int) {
+      v.integer = static_cast<int64_t>(j->number_int());
+    } else if (v.type == json_value_type::number_double) {
+      v.number = static_cast<double>(j->number_double());
+    } else if (v.type == json_value_type::boolean) {
+      v.boolean = j->m_value.boolean;
+    } else if (v.type == json_value_type::string) {
+      v.str = j->m_value.str->data();
+      v.size = j->m_value.str->size();
+    }
+    return v;
+  }
+
+  static bool is_number(const operand_value &v) {
+    return v.type == json_value_type::number_int ||
+           v.type == json_value_type::number_double;
+  }
+
+  static int compare_number(const operand_value &a, const operand_value &b) {
+    if (a.type == json_value_type::number_int &&
+        b.type == json_value_type::number_int) {
+      return a.integer == b.integer ? 0 : (a.integer < b.integer ? -1 : 1);
+    }
+    if (a.type == json_value_type::number_double &&
+        b.type == json_value_type::number_double) {
+      return a.number == b.number ? 0 : (a.number < b.number ? -1 : 1);
+    }
+    if (a.type == json_value_type::number_double) {
+      return -compare_number(b, a);
+    }
+    // an integer and a double are compared exactly, as json_node does
+    const double limit = 9223372036854775808.0;  // 2^63
+    if (b.number >= limit) {
+      return -1;
+    }
+    if (b.number < -limit) {
+      return 1;
+    }
+    int64_t b_integral = static_cast<int64_t>(b.number);
+    if (a.integer != b_integral) {
+      return a.integer < b_integral ? -1 : 1;
+    }
+    double fraction = b.number - static_cast<double>(b_integral);
+    return fraction == 0.0 ? 0 : (fraction > 0.0 ? -1 : 1);
+  }
+
+  static int compare_string(const operand_value &a, const operand_value &b) {
+    int res = memcmp(a.str, b.str, std::min(a.size, b.size));
+    if (res == 0 && a.size != b.size) {
+      res = a.size < b.size ? -1 : 1;
+    }
+    return res;
+  }
+
+  /*
+    Two missing values are equal; a missing value is not equal to a present
+    one
+  */
+  static bool equal(const operand_value &a, const operand_value &b) {
+    if (!a.present || !b.present) {
+      return !a.present && !b.present;
+    }
+    if (is_number(a) && is_number(b)) {
+      return compare_number(a, b) == 0;
+    }
+    if (a.type != b.type) {
+      return false;
+    }
+    switch (a.type) {
+      case json_value_type::string:
+        return compare_string(a, b) == 0;
+      case json_value_type::boolean:
+        return a.boolean == b.boolean;
+      case json_value_type::array:
+      case json_value_type::object:
+        return *a.node == *b.node;
+      default:
+        return true;
+    }
+  }
+
+  /*
+    Only numbers and strings are ordered
+  */
+  static bool less(const operand_value &a, const operand_value &b) {
+    if (!a.present || !b.present) {
+      return false;
+    }
+    if (is_number(a) && is_number(b)) {
+      return compare_number(a, b) < 0;
+    }
+    if (a.type == json_value_type::string &&
+        b.type == json_value_type::string) {
+      return compare_string(a, b) < 0;
+    }
+    return false;
+  }
+
+  static const JSONNode *member(const JSONNode &node,
+                                const std::string &name) {
+    return find_member(node, name, std::is_same<string_t, std::string>());
+  }
+  static const JSONNode *find_member(const JSONNode &node,
+                                     const std::string &name,
+                                     std::true_type) {
+    auto child = node.m_value.object->find(name);
+    return child == nullptr ? nullptr : *child;
+  }
+  static const JSONNode *find_member(const JSONNode &node,
+                                     const std::string &name,
+                                     std::false_type) {
+    auto child = node.m_value.object->find(string_t(name.data(), name.size()));
+    return child == nullptr ? nullptr : *child;
+  }
+
+  static parse_result result(parse_error_code code, const char *p,
+                             const char *begin) {
+    parse_result res;
+    res.code = code;
+    res.offset = static_cast<size_t>(p - begin);
+    return res;
+  }
+
+ private:
+  const path_plan &m_plan;
+  parser<JSONNode> m_parser;   // builds the values needed while streaming
+  std::vector<frame> m_frames;  // arrays and objects being streamed
+  states_t m_closure;
+  std::string m_key;
+};
+}  // namespace detail
+}  // namespace miniJSON
@@ -0,0 +1,56 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace miniJSON {
+namespace detail {
+/*
+  Split JSON pointer (RFC 6901) into unescaped reference tokens
+*/
+template <typename String, typename Token>
+inline bool parse_pointer(const String &pointer, std::vector<Token> *tokens) {
+  if (pointer.empty()) {
+    return true;
+  }
+  if (pointer[0] != '/') {
+    return false;
+  }
+  for (size_t i = 0; i < pointer.size(); i++) {
+    char c = pointer[i];
+    if (c == '/') {
+      tokens->emplace_back();
+    } else if (c != '~') {
+      tokens->back() += c;
+    } else if (i + 1 < pointer.size() && pointer[i + 1] == '0') {
+      tokens->back() += '~';
+      i++;
+    } else if (i + 1 < pointer.size() && pointer[i + 1] == '1') {
+      tokens->back() += '/';
+      i++;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  Append an object key or array index to a JSON pointer (RFC 6901) as an
+  escaped reference token
+*/
+template <typename String, typename Token>
+inline void append_pointer_token(String *pointer, const Token &token) {
+  *pointer += '/';
+  for (char c : token) {
+    if (c == '~') {
+      *pointer += "~0";
+    } else if (c == '/') {
+      *pointer += "~1";
+    } else {
+      *pointer += c;
+    }
+  }
+}
+}  // namespace detail
+}  // namespace miniJSON
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace miniJSON {
+namespace detail {
+template <typename Garbage>
+/*
+  Reclaimer frees dropped values on a background thread so that the threads
+  dropping them do not pay for the deallocation. Garbage pushed while the
+  reclaimer is stopped is freed immediately on the calling thread.
+*/
+class reclaimer {
+ public:
+  using deleter_t = void (*)(const Garbage &);
+
+  explicit reclaimer(deleter_t deleter) : m_deleter(deleter) {}
+  reclaimer(const reclaimer &other) = delete;
+  reclaimer &operator=(const reclaimer &other) = delete;
+  ~reclaimer() { stop(); }
+
+ public:
+  /*
+    Start the background thread if it is not running yet
+  */
+  void start() {
+    std::lock_guard<std::mutex> control_lock(m_control_mutex);
+    if (m_thread.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_accepting = true;
+    }
+    m_thread = std::thread(&reclaimer::run, this);
+    m_running.store(true, std::memory_order_release);
+  }
+
+  /*
+    Stop the background thread after it has freed all pending garbage
+  */
+  void stop() {
+    std::lock_guard<std::mutex> control_lock(m_control_mutex);
+    if (!m_thread.joinable()) {
+      return;
+    }
+    m_running.store(false, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_accepting = false;
+    }
+    m_work_cv.notify_one();
+    m_thread.join();
+  }
+
+  /*
+    Check if garbage is currently freed on the background thread
+  */
+  bool running() const { return m_running.load(std::memory_order_relaxed); }
+
+  /*
+    Hand garbage over to the background thread
+  */
+  void push(const Garbage &garbage) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_accepting) {
+        bool notify = m_pending.empty();
+        m_pending.push_back(garbage);
+        if (notify) {
+          m_work_cv.notify_one();
+        }
+        return;
+      }
+    }
+    m_deleter(garbage);
+  }
+
+  /*
+    Wait until all garbage pushed so far has been freed
+  */
+  void flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this] { return m_pending.empty() && !m_busy; });
+  }
+
+ private:
+  void run() {
+    std::vector<Garbage> batch;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+      m_work_cv.wait(lock,
+                     [this] { return !m_accepting || !m_pending.empty(); });
+      if (m_pending.empty()) {
+        return;  // stopping and everything has been freed
+      }
+      batch.swap(m_pending);
+      m_busy = true;
+      lock.unlock();
+      for (auto &garbage : batch) {
+        m_deleter(garbage);
+      }
+      batch.clear();
+      lock.lock();
+      m_busy = false;
+      m_idle_cv.notify_all();
+    }
+  }
+
+ private:
+  deleter_t m_deleter;
+  std::atomic<bool> m_running{false};
+  std::mutex m_control_mutex;  // serializes start() and stop()
+  std::thread m_thread;
+  std::mutex m_mutex;  // guards the members below
+  std::condition_variable m_work_cv;  // signals pending garbage or stopping
+  std::condition_variable m_idle_cv;  // signals all garbage has been freed
+  std::vector<Garbage> m_pending;
+  bool m_accepting = false;  // whether push() hands garbage to the thread
+  bool m_busy = false;       // whether the thread is freeing a batch
+};
+}  // namespace detail
+}  // namespace miniJSON
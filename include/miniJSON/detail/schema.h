@@ -0,0 +1,580 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../errors.h"
+#include "../json_types.h"
+#include "./pointer.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  A JSON Schema compiled into a flat list of schema nodes that refer to their
+  subschemas by index; the root schema is the first one. The keywords are
+  decoded once, so checking a value never looks at the schema document again.
+  Validation of a tree and validation while parsing run the same program: the
+  parser follows properties/items/additionalProperties as it descends and
+  checks every value once it is complete.
+*/
+template <typename JSONNode>
+class schema_program {
+ public:
+  using string_t = typename JSONNode::json_string_t;
+
+  enum : size_t {
+    any = static_cast<size_t>(-1),     // the true schema, accepts everything
+    nothing = static_cast<size_t>(-2)  // the false schema, accepts nothing
+  };
+
+  explicit schema_program(const JSONNode &schema)
+      : m_root(compile(schema, "#")) {}
+
+  size_t root() const { return m_root; }
+
+  /*
+    Get the schema of the member key of an object with the schema n: its
+    entry in properties, or else additionalProperties
+  */
+  size_t member(size_t n, const string_t &key) const {
+    if (n == any || n == nothing) {
+      return n;
+    }
+    auto &properties = m_nodes[n].properties;
+    auto it = std::lower_bound(
+        properties.begin(), properties.end(), key,
+        [](const std::pair<string_t, size_t> &p, const string_t &k) {
+          return p.first < k;
+        });
+    if (it != properties.end() && it->first == key) {
+      return it->second;
+    }
+    return m_nodes[n].additional;
+  }
+
+  /*
+    Get the schema of the elements of an array with the schema n
+  */
+  size_t items(size_t n) const {
+    return n == any || n == nothing ? n : m_nodes[n].items;
+  }
+
+  /*
+    Check the first character of a value against the type keyword, so that
+    the parser rejects a value of the wrong type before parsing it
+  */
+  bool accepts(size_t n, char c) const {
+    if (n == any || n == nothing) {
+      return n == any;
+    }
+    unsigned types = m_nodes[n].types;
+    switch (c) {
+      case '{':
+        return (types & object_type) != 0;
+      case '[':
+        return (types & array_type) != 0;
+      case '"':
+        return (types & string_type) != 0;
+      case 't':
+      case 'f':
+        return (types & boolean_type) != 0;
+      case 'n':
+        return (types & null_type) != 0;
+      default:
+        return (types & (integer_type | number_type)) != 0;
+    }
+  }
+
+  /*
+    Check a value against the keywords of the schema n that do not involve
+    subschemas; members and elements are checked against their own schemas
+    by the caller. message receives the reason if the value is rejected.
+  */
+  bool check(const JSONNode &value, size_t n, std::string *message) const {
+    if (n == any) {
+      return true;
+    }
+    if (n == nothing) {
+      *message = "no value is allowed here";
+      return false;
+    }
+    const schema_node &node = m_nodes[n];
+    if (!has_type(value, node.types)) {
+      *message = "expected " + type_names(node.types);
+      return false;
+    }
+    if (node.has_enum &&
+        std::find(node.enum_values.begin(), node.enum_values.end(), value) ==
+            node.enum_values.end()) {
+      *message = "must be one of the enum values";
+      return false;
+    }
+    if (node.has_const && !(value == node.const_value)) {
+      *message = "must be equal to the const value";
+      return false;
+    }
+    switch (value.m_type) {
+      case json_value_type::number_int:
+      case json_value_type::number_double:
+        return check_number(value, node, message);
+      case json_value_type::string:
+        return check_string(*value.m_value.str, node, message);
+      case json_value_type::array:
+        return check_size(value.m_value.array->size(), node.item_count,
+                          " items", message);
+      case json_value_type::object:
+        return check_object(value, node, message);
+      default:
+        return true;
+    }
+  }
+
+  /*
+    Validate a value and its descendants against the schema n. On failure,
+    path receives the JSON pointer of the rejected value and message the
+    reason.
+  */
+  bool validate(const JSONNode &value, size_t n, std::string *path,
+                std::string *message) const {
+    if (!check(value, n, message)) {
+      return false;
+    }
+    if (n == any) {
+      return true;
+    }
+    size_t length = path->size();
+    if (value.m_type == json_value_type::array &&
+        m_nodes[n].items != any) {
+      size_t items = m_nodes[n].items;
+      size_t i = 0;
+      for (auto child : *value.m_value.array) {
+        append_pointer_token(path, std::to_string(i++));
+        if (!validate(*child, items, path, message)) {
+          return false;
+        }
+        path->resize(length);
+      }
+    } else if (value.m_type == json_value_type::object) {
+      auto &object = *value.m_value.object;
+      for (auto it = object.values_begin(); it != object.values_end(); it++) {
+        size_t child = member(n, it.key());
+        if (child == any) {
+          continue;
+        }
+        append_pointer_token(path, it.key());
+        if (child == nothing) {
+          *message = "property \"" + to_std_string(it.key()) +
+                     "\" is not allowed";
+          return false;
+        }
+        if (!validate(**it, child, path, message)) {
+          return false;
+        }
+        path->resize(length);
+      }
+    }
+    return true;
+  }
+
+ private:
+  /*
+    Types accepted by the type keyword
+  */
+  enum : unsigned {
+    null_type = 1,
+    boolean_type = 2,
+    integer_type = 4,
+    number_type = 8,
+    string_type = 16,
+    array_type = 32,
+    object_type = 64,
+    all_types = 127
+  };
+
+  /*
+    A bound of minimum/maximum/exclusiveMinimum/exclusiveMaximum, with the
+    text of the schema value for error messages. The value is kept as a
+    number node so that integers are compared exactly.
+  */
+  struct bound {
+    bool set = false;
+    JSONNode value;
+    std::string text;
+  };
+
+  /*
+    The range of minLength/maxLength, minItems/maxItems or
+    minProperties/maxProperties
+  */
+  struct size_range {
+    size_t min = 0;
+    size_t max = std::numeric_limits<size_t>::max();
+  };
+
+  /*
+    The decoded keywords of one schema object
+  */
+  struct schema_node {
+    unsigned types = all_types;
+    std::vector<std::pair<string_t, size_t>> properties;  // sorted by key
+    size_t additional = any;  // additionalProperties
+    std::vector<string_t> required;
+    size_t items = any;
+    bool has_enum = false;
+    std::vector<JSONNode> enum_values;
+    bool has_const = false;
+    JSONNode const_value;
+    bound minimum;
+    bound maximum;
+    bound exclusive_minimum;
+    bound exclusive_maximum;
+    size_range length;  // in code points
+    size_range item_count;
+    size_range property_count;
+    bool has_pattern = false;
+    std::regex pattern;
+    std::string pattern_text;
+  };
+
+  static bool has_type(const JSONNode &value, unsigned types) {
+    switch (value.m_type) {
+      case json_value_type::null:
+        return (types & null_type) != 0;
+      case json_value_type::boolean:
+        return (types & boolean_type) != 0;
+      case json_value_type::number_int:
+        return (types & (integer_type | number_type)) != 0;
+      case json_value_type::number_double: {
+        if ((types & number_type) != 0) {
+          return true;
+        }
+        // JSON Schema integers are numbers without a fractional part
+        double d = static_cast<double>(value.number_double());
+        return (types & integer_type) != 0 && std::isfinite(d) &&
+               std::floor(d) == d;
+      }
+      case json_value_type::string:
+        return (types & string_type) != 0;
+      case json_value_type::array:
+        return (types & array_type) != 0;
+      case json_value_type::object:
+        return (types & object_type) != 0;
+      default:
+        return false;
+    }
+  }
+
+  static std::string type_names(unsigned types) {
+    static const char *names[] = {"null",   "boolean", "integer", "number",
+                                  "string", "array",   "object"};
+    std::string res;
+    for (unsigned i = 0; i < 7; i++) {
+      if ((types & (1u << i)) != 0) {
+        res += res.empty() ? names[i] : std::string(" or ") + names[i];
+      }
+    }
+    return res.empty() ? "no type" : res;
+  }
+
+  static bool check_number(const JSONNode &value, const schema_node &node,
+                           std::string *message) {
+    const char *failed = nullptr;
+    const bound *limit = nullptr;
+    if (node.minimum.set && value.compare_number(node.minimum.value) < 0) {
+      failed = ">= ";
+      limit = &node.minimum;
+    } else if (node.maximum.set &&
+               value.compare_number(node.maximum.value) > 0) {
+      failed = "<= ";
+      limit = &node.maximum;
+    } else if (node.exclusive_minimum.set &&
+               value.compare_number(node.exclusive_minimum.value) <= 0) {
+      failed = "> ";
+      limit = &node.exclusive_minimum;
+    } else if (node.exclusive_maximum.set &&
+               value.compare_number(node.exclusive_maximum.value) >= 0) {
+      failed = "< ";
+      limit = &node.exclusive_maximum;
+    }
+    if (failed != nullptr) {
+      *message = "must be " + std::string(failed) + limit->text;
+      return false;
+    }
+    return true;
+  }
+
+  static bool check_string(const string_t &s, const schema_node &node,
+                           std::string *message) {
+    size_t code_points = 0;
+    for (char c : s) {
+      code_points += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+    if (!check_size(code_points, node.length, " characters", message)) {
+      return false;
+    }
+    if (node.has_pattern &&
+        !std::regex_search(s.data(), s.data() + s.size(), node.pattern)) {
+      *message = "must match the pattern \"" + node.pattern_text + "\"";
+      return false;
+    }
+    return true;
+  }
+
+  static bool check_object(const JSONNode &value, const schema_node &node,
+                           std::string *message) {
+    auto &object = *value.m_value.object;
+    if (!check_size(object.size(), node.property_count, " properties",
+                    message)) {
+      return false;
+    }
+    for (auto &key : node.required) {
+      if (object.find(key) == nullptr) {
+        *message = "missing required property \"" + to_std_string(key) + "\"";
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool check_size(size_t size, const size_range &range,
+                         const char *unit, std::string *message) {
+    if (size < range.min) {
+      *message = "must have at least " + std::to_string(range.min) + unit;
+      return false;
+    }
+    if (size > range.max) {
+      *message = "must have at most " + std::to_string(range.max) + unit;
+      return false;
+    }
+    return true;
+  }
+
+  static std::string to_std_string(const string_t &s) {
+    return std::string(s.data(), s.size());
+  }
+
+  /*
+    Compile a schema and its subschemas, and get its index. path is the JSON
+    pointer of the schema in the schema document, for error messages.
+  */
+  size_t compile(const JSONNode &schema, const std::string &path) {
+    if (schema.m_type == json_value_type::boolean) {
+      return schema.m_value.boolean ? any : nothing;
+    }
+    if (schema.m_type != json_value_type::object) {
+      invalid(path, "a schema must be an object or a boolean");
+    }
+    size_t n = m_nodes.size();
+    m_nodes.emplace_back();
+    auto &object = *schema.m_value.object;
+    for (auto it = object.values_begin(); it != object.values_end(); it++) {
+      const string_t &key = it.key();
+      const JSONNode &value = **it;
+      std::string at = path;
+      append_pointer_token(&at, key);
+      // m_nodes grows while subschemas are compiled, so it is indexed anew
+      if (key == "type") {
+        m_nodes[n].types = compile_type(value, at);
+      } else if (key == "properties") {
+        compile_properties(value, at, n);
+      } else if (key == "additionalProperties") {
+        size_t additional = compile(value, at);
+        m_nodes[n].additional = additional;
+      } else if (key == "required") {
+        compile_required(value, at, n);
+      } else if (key == "items") {
+        if (value.m_type == json_value_type::array) {
+          invalid(at, "tuple validation is not supported");
+        }
+        size_t items = compile(value, at);
+        m_nodes[n].items = items;
+      } else if (key == "enum") {
+        if (value.m_type != json_value_type::array) {
+          invalid(at, "must be an array");
+        }
+        m_nodes[n].has_enum = true;
+        for (auto child : *value.m_value.array) {
+          m_nodes[n].enum_values.push_back(child->share());
+        }
+      } else if (key == "const") {
+        m_nodes[n].has_const = true;
+        m_nodes[n].const_value = value.share();
+      } else if (key == "minimum") {
+        m_nodes[n].minimum = compile_bound(value, at);
+      } else if (key == "maximum") {
+        m_nodes[n].maximum = compile_bound(value, at);
+      } else if (key == "exclusiveMinimum") {
+        m_nodes[n].exclusive_minimum = compile_bound(value, at);
+      } else if (key == "exclusiveMaximum") {
+        m_nodes[n].exclusive_maximum = compile_bound(value, at);
+      } else if (key == "minLength") {
+        m_nodes[n].length.min = compile_count(value, at);
+      } else if (key == "maxLength") {
+        m_nodes[n].length.max = compile_count(value, at);
+      } else if (key == "minItems") {
+        m_nodes[n].item_count.min = compile_count(value, at);
+      } else if (key == "maxItems") {
+        m_nodes[n].item_count.max = compile_count(value, at);
+      } else if (key == "minProperties") {
+        m_nodes[n].property_count.min = compile_count(value, at);
+      } else if (key == "maxProperties") {
+        m_nodes[n].property_count.max = compile_count(value, at);
+      } else if (key == "pattern") {
+        if (value.m_type != json_value_type::string) {
+          invalid(at, "must be a string");
+        }
+        m_nodes[n].has_pattern = true;
+        m_nodes[n].pattern_text = to_std_string(*value.m_value.str);
+        compile_pattern(&m_nodes[n], at);
+      } else if (is_unsupported(key)) {
+        invalid(at, "keyword is not supported");
+      }
+      // annotations ($schema, title, description, default, ...) are ignored
+    }
+    return n;
+  }
+
+  unsigned compile_type(const JSONNode &value, const std::string &path) {
+    if (value.m_type == json_value_type::string) {
+      return type_bit(*value.m_value.str, path);
+    }
+    if (value.m_type != json_value_type::array) {
+      invalid(path, "must be a string or an array of strings");
+    }
+    unsigned types = 0;
+    for (auto child : *value.m_value.array) {
+      if (child->m_type != json_value_type::string) {
+        invalid(path, "must be a string or an array of strings");
+      }
+      types |= type_bit(*child->m_value.str, path);
+    }
+    return types;
+  }
+
+  static unsigned type_bit(const string_t &name, const std::string &path) {
+    static const char *names[] = {"null",   "boolean", "integer", "number",
+                                  "string", "array",   "object"};
+    for (unsigned i = 0; i < 7; i++) {
+      if (name == names[i]) {
+        return 1u << i;
+      }
+    }
+    invalid(path, "unknown type \"" + to_std_string(name) + "\"");
+    return 0;
+  }
+
+  void compile_properties(const JSONNode &value, const std::string &path,
+                          size_t n) {
+    if (value.m_type != json_value_type::object) {
+      invalid(path, "must be an object");
+    }
+    auto &object = *value.m_value.object;
+    for (auto it = object.values_begin(); it != object.values_end(); it++) {
+      std::string at = path;
+      append_pointer_token(&at, it.key());
+      size_t child = compile(**it, at);
+      m_nodes[n].properties.emplace_back(it.key(), child);
+    }
+    auto &properties = m_nodes[n].properties;
+    std::sort(properties.begin(), properties.end(),
+              [](const std::pair<string_t, size_t> &a,
+                 const std::pair<string_t, size_t> &b) {
+                return a.first < b.first;
+              });
+  }
+
+  void compile_required(const JSONNode &value, const std::string &path,
+                        size_t n) {
+    if (value.m_type != json_value_type::array) {
+      invalid(path, "must be an array of strings");
+    }
+    for (auto child : *value.m_value.array) {
+      if (child->m_type != json_value_type::string) {
+        invalid(path, "must be an array of strings");
+      }
+      m_nodes[n].required.push_back(*child->m_value.str);
+    }
+  }
+
+  static bound compile_bound(const JSONNode &value, const std::string &path) {
+    bound res;
+    res.set = true;
+    if (value.m_type != json_value_type::number_int &&
+        value.m_type != json_value_type::number_double) {
+      invalid(path, "must be a number");
+    }
+    res.value = value.share();
+    res.text = to_std_string(value.get_number_text());
+    return res;
+  }
+
+  static void compile_pattern(schema_node *node, const std::string &path) {
+#ifdef MINIJSON_HAS_EXCEPTIONS
+    try {
+      node->pattern = std::regex(node->pattern_text, std::regex::ECMAScript);
+    } catch (const std::regex_error &e) {
+      invalid(path, std::string("invalid regular expression: ") + e.what());
+    }
+#else
+    node->pattern = std::regex(node->pattern_text, std::regex::ECMAScript);
+#endif
+  }
+
+  static size_t compile_count(const JSONNode &value, const std::string &path) {
+    if (value.m_type != json_value_type::number_int ||
+        value.number_int() < 0) {
+      invalid(path, "must be a non-negative integer");
+    }
+    return static_cast<size_t>(value.number_int());
+  }
+
+  /*
+    Keywords that would change the result of validation but are not
+    implemented. They are rejected rather than ignored, so that a schema is
+    never more permissive than its author intended.
+  */
+  static bool is_unsupported(const string_t &key) {
+    static const char *keywords[] = {"$ref",
+                                     "allOf",
+                                     "anyOf",
+                                     "oneOf",
+                                     "not",
+                                     "if",
+                                     "then",
+                                     "else",
+                                     "patternProperties",
+                                     "propertyNames",
+                                     "dependencies",
+                                     "dependentRequired",
+                                     "dependentSchemas",
+                                     "contains",
+                                     "prefixItems",
+                                     "additionalItems",
+                                     "uniqueItems",
+                                     "multipleOf",
+                                     "unevaluatedItems",
+                                     "unevaluatedProperties"};
+    for (const char *keyword : keywords) {
+      if (key == keyword) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void invalid(const std::string &path, const std::string &message) {
+    MINIJSON_THROW(json_schema_error(path + ": " + message));
+  }
+
+ private:
+  std::vector<schema_node> m_nodes;
+  size_t m_root;
+};
+}  // namespace detail
+}  // namespace miniJSON
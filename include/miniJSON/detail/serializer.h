@@ -0,0 +1,262 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "../errors.h"
+#include "../json_types.h"
+#include "../options.h"
+#include "./simd.h"
+#include "./small_stack.h"
+#include "./utf8.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  Write the \uXXXX escape of a UTF-16 code unit
+*/
+inline void write_code_unit(uint32_t code_unit, std::string *out) {
+  static const char hex[] = "0123456789abcdef";
+  char buf[6] = {'\\',
+                 'u',
+                 hex[(code_unit >> 12) & 0xf],
+                 hex[(code_unit >> 8) & 0xf],
+                 hex[(code_unit >> 4) & 0xf],
+                 hex[code_unit & 0xf]};
+  out->append(buf, sizeof(buf));
+}
+
+/*
+  Write the escape sequence of the character at p and return the number of
+  bytes it spans. Non-ASCII characters are written as \uXXXX escapes (a
+  surrogate pair beyond the BMP); bytes that are not well-formed UTF-8 are
+  written as U+FFFD.
+*/
+inline size_t write_escape(const char *p, const char *end, std::string *out) {
+  unsigned char c = static_cast<unsigned char>(*p);
+  switch (c) {
+    case '"':
+      *out += "\\\"";
+      return 1;
+    case '\\':
+      *out += "\\\\";
+      return 1;
+    case '\b':
+      *out += "\\b";
+      return 1;
+    case '\f':
+      *out += "\\f";
+      return 1;
+    case '\n':
+      *out += "\\n";
+      return 1;
+    case '\r':
+      *out += "\\r";
+      return 1;
+    case '\t':
+      *out += "\\t";
+      return 1;
+    default:
+      break;
+  }
+  if (c < 0x80) {
+    write_code_unit(c, out);
+    return 1;
+  }
+  size_t length = utf8_sequence_length(p, end);
+  if (length == 0) {
+    write_code_unit(0xfffd, out);
+    return 1;
+  }
+  uint32_t code_point = decode_utf8(p, length);
+  if (code_point >= 0x10000) {
+    code_point -= 0x10000;
+    write_code_unit(0xd800 + (code_point >> 10), out);
+    write_code_unit(0xdc00 + (code_point & 0x3ff), out);
+  } else {
+    write_code_unit(code_point, out);
+  }
+  return length;
+}
+
+/*
+  Write a string enclosed in quotation marks. Runs of characters that need
+  no escaping are found with SIMD and copied in bulk.
+*/
+template <typename String>
+inline void write_string(const String &str, bool ensure_ascii,
+                         std::string *out) {
+  const char *p = str.data();
+  const char *end = p + str.size();
+  *out += '"';
+  while (p < end) {
+    const char *special =
+        ensure_ascii ? find_escape<true>(p, end) : find_escape(p, end);
+    out->append(p, special);
+    if (special == end) {
+      break;
+    }
+    p = special + write_escape(special, end, out);
+  }
+  *out += '"';
+}
+
+/*
+  Write a double number
+*/
+inline void write_double(double d, std::string *out) {
+  std::ostringstream sstream;
+  sstream << d;
+  *out += sstream.str();
+}
+
+/*
+  Start a new line indented for the nesting depth
+*/
+inline void write_indent(size_t depth, size_t indent, std::string *out) {
+  *out += '\n';
+  out->append(depth * indent, ' ');
+}
+
+template <typename JSONNode>
+/*
+  Serializer is responsible for converting the JSON nodes (tree) into a JSON
+  string. Everything is appended to a single output buffer.
+*/
+class serializer {
+ public:
+  serializer(std::string *out, const serialize_options &options)
+      : m_out(out), m_options(options) {}
+
+ public:
+  /*
+    Serialize the node and its descendants. The tree is walked with an
+    explicit stack of the arrays/objects being written, so documents nested
+    deeper than the call stack allows can be serialized.
+  */
+  void serialize(const JSONNode &root) {
+    const JSONNode *node = &root;
+    while (node != nullptr) {
+      write_value(*node);
+      node = nullptr;
+      while (node == nullptr && !m_frames.empty()) {
+        frame &f = m_frames.back();
+        if (f.node->m_type == json_value_type::array) {
+          auto &array = *f.node->m_value.array;
+          if (f.index < array.size()) {
+            next_child(f.index++);
+            node = array[f.index - 1];
+            continue;
+          }
+        } else if (f.it != f.node->m_value.object->values_end()) {
+          next_child(f.index++);
+          write_string(f.it.key());
+          *m_out += m_options.indent != 0 ? ": " : ":";
+          node = *f.it++;
+          continue;
+        }
+        bool array = f.node->m_type == json_value_type::array;
+        m_frames.pop_back();
+        new_line(m_frames.size());
+        *m_out += array ? ']' : '}';
+      }
+    }
+  }
+
+  /*
+    Write a number, or its text if it was parsed with lazy_numbers
+  */
+  static void write_number(const JSONNode &node, std::string *out) {
+    if (node.m_number_text) {
+      out->append(node.m_value.str->data(), node.m_value.str->size());
+    } else if (node.m_type == json_value_type::number_int) {
+      *out += std::to_string(node.m_value.number_int);
+    } else {
+      write_double(node.m_value.number_double, out);
+    }
+  }
+
+ private:
+  /*
+    An array/object being written and the position of its next child
+  */
+  struct frame {
+    const JSONNode *node;
+    size_t index;
+    typename JSONNode::json_object_t::values_iterator it;
+  };
+
+  /*
+    Write a scalar or an empty array/object, or open a non-empty one
+  */
+  void write_value(const JSONNode &node) {
+    switch (node.m_type) {
+      case json_value_type::boolean:
+        *m_out += node.m_value.boolean ? "true" : "false";
+        break;
+      case json_value_type::null:
+        *m_out += "null";
+        break;
+      case json_value_type::string:
+        write_string(*node.m_value.str);
+        break;
+      case json_value_type::number_int:
+      case json_value_type::number_double:
+        write_number(node, m_out);
+        break;
+      case json_value_type::array:
+        if (node.m_value.array->empty()) {
+          *m_out += "[]";
+        } else {
+          *m_out += '[';
+          m_frames.push_back(frame{&node, 0, {}});
+        }
+        break;
+      case json_value_type::object:
+        if (node.m_value.object->size() == 0) {
+          *m_out += "{}";
+        } else {
+          *m_out += '{';
+          m_frames.push_back(
+              frame{&node, 0, node.m_value.object->values_begin()});
+        }
+        break;
+      case json_value_type::indeterminate:
+        MINIJSON_THROW(json_type_error(
+            "JSON node has an indeterminate child. Access of the previously "
+            "non-existent element of object or array creates indeterminate "
+            "node."));
+      default:
+        MINIJSON_THROW(json_type_error("invalid type"));
+    }
+  }
+
+  /*
+    Start the child at index of the innermost array/object
+  */
+  void next_child(size_t index) {
+    if (index != 0) {
+      *m_out += ',';
+    }
+    new_line(m_frames.size());
+  }
+
+  template <typename String>
+  void write_string(const String &str) {
+    detail::write_string(str, m_options.ensure_ascii, m_out);
+  }
+
+  void new_line(size_t depth) {
+    if (m_options.indent != 0) {
+      write_indent(depth, m_options.indent, m_out);
+    }
+  }
+
+ private:
+  std::string *m_out;
+  serialize_options m_options;
+  small_stack<frame> m_frames;  // arrays/objects being written, innermost last
+};
+}  // namespace detail
+}  // namespace miniJSON
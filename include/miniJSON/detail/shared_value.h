@@ -0,0 +1,47 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace miniJSON {
+namespace detail {
+/*
+  A heap allocated value with an intrusive reference count. Objects, arrays and
+  strings of JSON nodes are stored this way so that a shared copy of a JSON
+  node can point to the same value until one of the owners modifies it.
+*/
+template <typename T>
+class shared_value : public T {
+ public:
+  template <typename... Args>
+  explicit shared_value(Args &&...args) : T(std::forward<Args>(args)...) {}
+  shared_value(const shared_value &other) = delete;
+  shared_value &operator=(const shared_value &other) = delete;
+
+  /*
+    Add a new owner of the value
+  */
+  void add_ref() { m_refs.fetch_add(1, std::memory_order_relaxed); }
+
+  /*
+    Remove an owner of the value. Returns true if it was the last owner, in
+    which case the caller is responsible for deleting the value.
+  */
+  bool release() {
+    if (m_refs.load(std::memory_order_acquire) == 1) {
+      return true;
+    }
+    return m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  /*
+    Check if the value has exactly one owner
+  */
+  bool unique() const { return m_refs.load(std::memory_order_acquire) == 1; }
+
+ private:
+  std::atomic<size_t> m_refs{1};
+};
+}  // namespace detail
+}  // namespace miniJSON
@@ -0,0 +1,134 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define MINIJSON_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINIJSON_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace miniJSON {
+namespace detail {
+/*
+  Helper functions scanning strings 32 (AVX2) or 16 (SSE2) bytes at a time.
+  The remaining bytes, and all bytes on other targets, are scanned one at a
+  time.
+*/
+
+/*
+  Get the index of the lowest set bit of a non-zero mask
+*/
+inline int lowest_bit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+/*
+  Check if a byte must be escaped in a JSON string: quotation mark, reverse
+  solidus and control characters
+*/
+inline bool needs_escape(unsigned char c) {
+  return c == '"' || c == '\\' || c < 0x20;
+}
+
+/*
+  Find the first byte in [p, end) that must be escaped in a JSON string, or
+  that is not ASCII if EscapeNonASCII is set. Returns end if there is none.
+*/
+template <bool EscapeNonASCII = false>
+inline const char *find_escape(const char *p, const char *end) {
+#ifdef MINIJSON_AVX2
+  const __m256i quote32 = _mm256_set1_epi8('"');
+  const __m256i backslash32 = _mm256_set1_epi8('\\');
+  const __m256i control32 = _mm256_set1_epi8(0x1f);
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i mask = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32),
+                        _mm256_cmpeq_epi8(chunk, backslash32)),
+        _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control32), control32));
+    if (EscapeNonASCII) {
+      mask = _mm256_or_si256(mask, chunk);  // the sign bit marks non-ASCII
+    }
+    uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+    if (bits != 0) {
+      return p + lowest_bit(bits);
+    }
+  }
+#endif
+#ifdef MINIJSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // c <= 0x1f exactly when max(c, 0x1f) == 0x1f (unsigned)
+    __m128i mask = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+    if (EscapeNonASCII) {
+      mask = _mm_or_si128(mask, chunk);  // the sign bit marks non-ASCII
+    }
+    uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(mask));
+    if (bits != 0) {
+      return p + lowest_bit(bits);
+    }
+  }
+#endif
+  for (; p < end; p++) {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (needs_escape(c) || (EscapeNonASCII && c >= 0x80)) {
+      return p;
+    }
+  }
+  return end;
+}
+
+/*
+  Find the first non-ASCII byte in [p, end). Returns end if there is none.
+*/
+inline const char *find_non_ascii(const char *p, const char *end) {
+#ifdef MINIJSON_AVX2
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(chunk));
+    if (bits != 0) {
+      return p + lowest_bit(bits);
+    }
+  }
+#endif
+#ifdef MINIJSON_SSE2
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+    if (bits != 0) {
+      return p + lowest_bit(bits);
+    }
+  }
+#endif
+  for (; p < end; p++) {
+    if (static_cast<unsigned char>(*p) >= 0x80) {
+      return p;
+    }
+  }
+  return end;
+}
+}  // namespace detail
+}  // namespace miniJSON
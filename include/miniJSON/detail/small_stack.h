@@ -0,0 +1,47 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace miniJSON {
+namespace detail {
+/*
+  A stack that keeps its first N elements inline and only allocates once it
+  grows deeper. The trees are walked with explicit stacks of this type, so
+  walking a shallow tree allocates nothing and a deep one cannot overflow the
+  call stack.
+*/
+template <typename T, size_t N = 32>
+class small_stack {
+ public:
+  bool empty() const { return m_size == 0; }
+  size_t size() const { return m_size; }
+
+  T &back() { return m_size <= N ? m_inline[m_size - 1] : m_overflow.back(); }
+
+  void push_back(T value) {
+    if (m_size < N) {
+      m_inline[m_size] = std::move(value);
+    } else {
+      m_overflow.push_back(std::move(value));
+    }
+    m_size++;
+  }
+
+  void pop_back() {
+    if (m_size > N) {
+      m_overflow.pop_back();
+    } else {
+      m_inline[m_size - 1] = T();  // releases what the element owns
+    }
+    m_size--;
+  }
+
+ private:
+  T m_inline[N];
+  std::vector<T> m_overflow;
+  size_t m_size = 0;
+};
+}  // namespace detail
+}  // namespace miniJSON
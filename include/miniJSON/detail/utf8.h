@@ -0,0 +1,109 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "./simd.h"
+
+namespace miniJSON {
+namespace detail {
+/*
+  Helper functions to validate and encode UTF-8 (RFC 3629)
+*/
+
+/*
+  Get the length of the well-formed UTF-8 sequence starting at the non-ASCII
+  byte p, or 0 if it is ill-formed: truncated, overlong, a surrogate or
+  beyond U+10FFFF
+*/
+inline size_t utf8_sequence_length(const char *p, const char *end) {
+  const unsigned char *s = reinterpret_cast<const unsigned char *>(p);
+  size_t available = static_cast<size_t>(end - p);
+  unsigned char lead = s[0];
+  size_t length;
+  unsigned char min = 0x80, max = 0xbf;  // range of the second byte
+  if (lead >= 0xc2 && lead <= 0xdf) {
+    length = 2;
+  } else if (lead >= 0xe0 && lead <= 0xef) {
+    length = 3;
+    if (lead == 0xe0) {
+      min = 0xa0;
+    } else if (lead == 0xed) {
+      max = 0x9f;
+    }
+  } else if (lead >= 0xf0 && lead <= 0xf4) {
+    length = 4;
+    if (lead == 0xf0) {
+      min = 0x90;
+    } else if (lead == 0xf4) {
+      max = 0x8f;
+    }
+  } else {
+    return 0;
+  }
+  if (available < length || s[1] < min || s[1] > max) {
+    return 0;
+  }
+  for (size_t i = 2; i < length; i++) {
+    if ((s[i] & 0xc0) != 0x80) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+/*
+  Find the first byte in [p, end) that is not part of well-formed UTF-8.
+  Returns end if the whole range is valid. ASCII runs are skipped in bulk.
+*/
+inline const char *find_invalid_utf8(const char *p, const char *end) {
+  for (;;) {
+    p = find_non_ascii(p, end);
+    if (p == end) {
+      return end;
+    }
+    size_t length = utf8_sequence_length(p, end);
+    if (length == 0) {
+      return p;
+    }
+    p += length;
+  }
+}
+
+/*
+  Get the code point of the well-formed UTF-8 sequence of the given length
+  starting at p
+*/
+inline uint32_t decode_utf8(const char *p, size_t length) {
+  const unsigned char *s = reinterpret_cast<const unsigned char *>(p);
+  static const unsigned char lead_mask[] = {0, 0x7f, 0x1f, 0x0f, 0x07};
+  uint32_t code_point = s[0] & lead_mask[length];
+  for (size_t i = 1; i < length; i++) {
+    code_point = (code_point << 6) | (s[i] & 0x3f);
+  }
+  return code_point;
+}
+
+/*
+  Append the UTF-8 encoding of a Unicode code point to out
+*/
+template <typename String>
+inline void append_utf8(uint32_t code_point, String *out) {
+  if (code_point < 0x80) {
+    *out += static_cast<char>(code_point);
+  } else if (code_point < 0x800) {
+    *out += static_cast<char>(0xc0 | (code_point >> 6));
+    *out += static_cast<char>(0x80 | (code_point & 0x3f));
+  } else if (code_point < 0x10000) {
+    *out += static_cast<char>(0xe0 | (code_point >> 12));
+    *out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+    *out += static_cast<char>(0x80 | (code_point & 0x3f));
+  } else {
+    *out += static_cast<char>(0xf0 | (code_point >> 18));
+    *out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+    *out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+    *out += static_cast<char>(0x80 | (code_point & 0x3f));
+  }
+}
+}  // namespace detail
+}  // namespace miniJSON
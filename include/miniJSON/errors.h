@@ -1,10 +1,101 @@
 // Copyright (c) 2024 Zhichen (Joshua) Wen
 #pragma once
 
+#include <cstddef>
+#include <cstdlib>
 #include <exception>
 #include <string>
 
+/*
+  Errors are reported by throwing exceptions. When exceptions are disabled
+  (e.g. compiled with -fno-exceptions, or MINIJSON_NOEXCEPTION is defined),
+  the program is aborted instead, and the exception-free API such as
+  parse(const std::string &, json_node *) should be used.
+*/
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+// exceptions thrown by the standard library can be caught
+#define MINIJSON_HAS_EXCEPTIONS 1
+#endif
+#if defined(MINIJSON_HAS_EXCEPTIONS) && !defined(MINIJSON_NOEXCEPTION)
+#define MINIJSON_THROW(exception) throw exception
+#else
+#define MINIJSON_THROW(exception) std::abort()
+#endif
+
 namespace miniJSON {
+/*
+  Kinds of JSON parsing errors
+*/
+enum class parse_error_code {
+  none,
+  unexpected_end,
+  unexpected_character,
+  invalid_literal,
+  invalid_number,
+  invalid_escape,
+  unterminated_string,
+  expected_key,
+  expected_colon,
+  expected_comma_or_end,
+  trailing_characters,
+  depth_exceeded,
+  invalid_utf8,
+  control_character,
+  schema_violation
+};
+
+/*
+  Result of parsing a JSON string without exceptions: the kind of error and
+  the byte offset in the JSON string where it is detected. Converts to true if
+  the JSON string is parsed successfully.
+*/
+struct parse_result {
+  parse_error_code code = parse_error_code::none;
+  size_t offset = 0;
+
+  explicit operator bool() const { return code == parse_error_code::none; }
+
+  /*
+    Get the description of the error (statically allocated)
+  */
+  const char *message() const {
+    switch (code) {
+      case parse_error_code::none:
+        return "no error";
+      case parse_error_code::unexpected_end:
+        return "unexpected end of input";
+      case parse_error_code::unexpected_character:
+        return "unexpected character";
+      case parse_error_code::invalid_literal:
+        return "invalid literal";
+      case parse_error_code::invalid_number:
+        return "invalid number";
+      case parse_error_code::invalid_escape:
+        return "invalid escape sequence";
+      case parse_error_code::unterminated_string:
+        return "unterminated string";
+      case parse_error_code::expected_key:
+        return "expected object key";
+      case parse_error_code::expected_colon:
+        return "expected colon after object key";
+      case parse_error_code::expected_comma_or_end:
+        return "expected comma or end of array/object";
+      case parse_error_code::trailing_characters:
+        return "trailing characters after JSON value";
+      case parse_error_code::depth_exceeded:
+        return "maximum nesting depth exceeded";
+      case parse_error_code::invalid_utf8:
+        return "invalid UTF-8 in string";
+      case parse_error_code::control_character:
+        return "unescaped control character in string";
+      case parse_error_code::schema_violation:
+        return "value does not match the schema";
+      default:
+        return "unknown error";
+    }
+  }
+};
+
 /*
   This is used to denote JSON parsing error.
 */
@@ -12,11 +103,21 @@ class json_parse_error : public std::exception {
  public:
   explicit json_parse_error(std::string message)
       : m_message(template_str + message) {}
+  explicit json_parse_error(const parse_result &result)
+      : m_message(template_str + result.message() + " at offset " +
+                  std::to_string(result.offset)),
+        m_result(result) {}
   const char *what() const noexcept override { return m_message.c_str(); }
 
+  /*
+    Get the kind of error and the byte offset where it is detected
+  */
+  const parse_result &result() const { return m_result; }
+
  private:
   std::string template_str = "json parse error: ";
   std::string m_message;
+  parse_result m_result;
 };
 
 /*
@@ -33,4 +134,63 @@ class json_type_error : public std::exception {
   std::string template_str = "json type error: ";
   std::string m_message;
 };
+
+/*
+  This is used to denote JSON patch error when a patch document is invalid or
+  one of its operations cannot be applied.
+*/
+class json_patch_error : public std::exception {
+ public:
+  explicit json_patch_error(std::string message)
+      : m_message(template_str + message) {}
+  const char *what() const noexcept override { return m_message.c_str(); }
+
+ private:
+  std::string template_str = "json patch error: ";
+  std::string m_message;
+};
+
+/*
+  This is used to denote JSONPath error when a JSONPath expression is invalid.
+*/
+class json_path_error : public std::exception {
+ public:
+  explicit json_path_error(std::string message)
+      : m_message(template_str + message) {}
+  const char *what() const noexcept override { return m_message.c_str(); }
+
+ private:
+  std::string template_str = "json path error: ";
+  std::string m_message;
+};
+
+/*
+  This is used to denote JSON Schema error when a schema is invalid or uses a
+  keyword that is not supported.
+*/
+class json_schema_error : public std::exception {
+ public:
+  explicit json_schema_error(std::string message)
+      : m_message(template_str + message) {}
+  const char *what() const noexcept override { return m_message.c_str(); }
+
+ private:
+  std::string template_str = "json schema error: ";
+  std::string m_message;
+};
+
+/*
+  This is used to denote JSON merge error when merge() finds conflicting
+  values and is asked to fail on them.
+*/
+class json_merge_error : public std::exception {
+ public:
+  explicit json_merge_error(std::string message)
+      : m_message(template_str + message) {}
+  const char *what() const noexcept override { return m_message.c_str(); }
+
+ private:
+  std::string template_str = "json merge error: ";
+  std::string m_message;
+};
 }  // namespace miniJSON
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./detail/pointer.h"
+#include "./errors.h"
+
+namespace miniJSON {
+namespace detail {
+template <typename JSONNode>
+class parser;
+}  // namespace detail
+
+/*
+  The set of fields to build when parsing with parse(s, mask). Fields are
+  given as JSON pointers (RFC 6901) of object members, e.g. "/user/name";
+  arrays on the way are projected element by element, so "/items/sku" selects
+  the sku of every item. A selected field is parsed completely, its ancestors
+  only keep the selected members. Everything else is validated but skipped
+  without being built, including scalars where the mask expects an object.
+  The empty pointer "" selects the whole document.
+*/
+class field_mask {
+ public:
+  field_mask() : m_nodes(1) {}
+  field_mask(std::initializer_list<std::string> paths) : field_mask() {
+    for (auto &path : paths) {
+      add(path);
+    }
+  }
+
+  /*
+    Add a field to the mask. It will throw json_path_error if the path is not
+    a valid JSON pointer.
+  */
+  field_mask &add(const std::string &path) {
+    std::vector<std::string> tokens;
+    if (!detail::parse_pointer(path, &tokens)) {
+      MINIJSON_THROW(json_path_error("invalid JSON pointer \"" + path + "\""));
+    }
+    size_t n = 0;
+    for (auto &token : tokens) {
+      if (m_nodes[n].whole) {
+        return *this;
+      }
+      size_t child = find(n, token.data(), token.size());
+      if (child == none) {
+        child = m_nodes.size();
+        m_nodes.emplace_back();
+        m_nodes[n].children.emplace_back(token, child);
+      }
+      n = child;
+    }
+    m_nodes[n].whole = true;
+    m_nodes[n].children.clear();
+    return *this;
+  }
+
+ private:
+  template <typename JSONNode>
+  friend class detail::parser;
+
+  /*
+    A member on the path of a field. It is whole if the field ends there.
+  */
+  struct node {
+    std::vector<std::pair<std::string, size_t>> children;
+    bool whole = false;
+  };
+
+  enum : size_t {
+    all = static_cast<size_t>(-1),  // parsed completely
+    none = static_cast<size_t>(-2)  // skipped
+  };
+
+  /*
+    Get the node of the document root
+  */
+  size_t root() const {
+    return m_nodes[0].whole ? static_cast<size_t>(all) : size_t(0);
+  }
+
+  /*
+    Get the node of a member of an object with the node n
+  */
+  size_t child(size_t n, const char *key, size_t size) const {
+    if (n == all) {
+      return all;
+    }
+    size_t res = find(n, key, size);
+    return res != none && m_nodes[res].whole ? all : res;
+  }
+
+  size_t find(size_t n, const char *key, size_t size) const {
+    for (auto &child : m_nodes[n].children) {
+      if (child.first.size() == size &&
+          memcmp(child.first.data(), key, size) == 0) {
+        return child.second;
+      }
+    }
+    return none;
+  }
+
+ private:
+  std::vector<node> m_nodes;  // the root is the first one
+};
+}  // namespace miniJSON
@@ -0,0 +1,508 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "./detail/lexer.h"
+#include "./detail/serializer.h"
+#include "./detail/simd.h"
+#include "./detail/utf8.h"
+#include "./errors.h"
+#include "./options.h"
+
+namespace miniJSON {
+/*
+  Rewrites JSON minified or indented without building JSON nodes. The input
+  is given in chunks of any size and split anywhere; the output of each chunk
+  is passed to the sink before write() returns. The input is checked against
+  the same grammar as parse() as it goes, and the same errors and offsets are
+  reported. Strings and numbers are copied as they are written in the input.
+  Memory use does not grow with the size of the input, only with the length
+  of the longest number and the nesting depth (one bit per level).
+*/
+class json_formatter {
+ public:
+  using sink_type = std::function<void(const char *data, size_t size)>;
+
+  explicit json_formatter(sink_type sink,
+                          const format_options &options = format_options(),
+                          const parse_options &parse = parse_options())
+      : m_sink(std::move(sink)), m_options(options), m_parse(parse) {}
+
+  /*
+    Format the next chunk of input. Once the input is found to be invalid the
+    error is returned and the following chunks are ignored; the output written
+    before the error is not taken back.
+  */
+  parse_result write(const char *data, size_t size) {
+    const char *p = data;
+    const char *end = data + size;
+    m_chunk = data;
+    while (m_state != state::error && p < end) {
+      switch (m_state) {
+        case state::value:
+        case state::element:
+        case state::first_element:
+          p = on_value(p, end);
+          break;
+        case state::key:
+        case state::first_key:
+          p = on_key(p, end);
+          break;
+        case state::colon:
+          p = on_colon(p, end);
+          break;
+        case state::separator:
+          p = on_separator(p, end);
+          break;
+        case state::string:
+          p = on_string(p, end);
+          break;
+        case state::escape:
+          p = on_escape(p, end);
+          break;
+        case state::number:
+          p = on_number(p, end);
+          break;
+        case state::literal:
+          p = on_literal(p, end);
+          break;
+        case state::done:
+          p = detail::skip_whitespace(p, end);
+          if (p != end) {
+            fail(parse_error_code::trailing_characters, p);
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    m_offset += size;
+    flush();
+    return m_error;
+  }
+
+  parse_result write(const std::string &chunk) {
+    return write(chunk.data(), chunk.size());
+  }
+
+  /*
+    End the input, check that it held one complete JSON value and flush the
+    output. The formatter is then ready for the next document.
+  */
+  parse_result finish() {
+    switch (m_state) {
+      case state::number:
+        finish_number();
+        break;
+      case state::literal:
+        fail_at(parse_error_code::invalid_literal, m_token_start);
+        break;
+      case state::escape:
+        finish_escape();
+        break;
+      case state::string:
+        if (m_utf8_need != 0) {
+          fail_at(parse_error_code::invalid_utf8, m_utf8_start);
+        } else {
+          fail_at(parse_error_code::unterminated_string, m_offset);
+        }
+        break;
+      default:
+        break;
+    }
+    if (m_state != state::done && m_state != state::error) {
+      fail_at(parse_error_code::unexpected_end, m_offset);
+    }
+    flush();
+    parse_result res = m_error;
+    reset();
+    return res;
+  }
+
+  /*
+    Drop the current document and start over
+  */
+  void reset() {
+    m_out.clear();
+    m_stack = detail::container_stack();
+    m_state = state::value;
+    m_offset = 0;
+    m_utf8_need = 0;
+    m_error = parse_result();
+  }
+
+ private:
+  /*
+    What the formatter expects next. element and first_element are values
+    in arrays, which start on a new line when indenting; first_element and
+    first_key may also be the end of an empty array/object.
+  */
+  enum class state {
+    value,
+    element,
+    first_element,
+    key,
+    first_key,
+    colon,
+    separator,
+    string,
+    escape,
+    number,
+    literal,
+    done,
+    error
+  };
+
+  const char *on_value(const char *p, const char *end) {
+    p = detail::skip_whitespace(p, end);
+    if (p == end) {
+      return p;
+    }
+    char c = *p;
+    if (m_state == state::first_element && c == ']') {
+      return close(p);
+    }
+    if (m_state != state::value) {
+      new_line(m_stack.size());
+    }
+    switch (c) {
+      case '[':
+      case '{':
+        if (m_stack.size() >= m_parse.max_depth) {
+          return fail(parse_error_code::depth_exceeded, p);
+        }
+        m_stack.push(c == '{');
+        m_out += c;
+        m_state = c == '{' ? state::first_key : state::first_element;
+        return p + 1;
+      case '"':
+        m_out += c;
+        m_in_key = false;
+        m_state = state::string;
+        return p + 1;
+      case 't':
+      case 'f':
+      case 'n':
+        m_literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+        m_literal_size = 0;
+        m_token_start = offset(p);
+        m_state = state::literal;
+        return p;
+      default:
+        if (!isdigit(static_cast<unsigned char>(c)) && c != '-') {
+          return fail(parse_error_code::unexpected_character, p);
+        }
+        m_token.clear();
+        m_token_start = offset(p);
+        m_state = state::number;
+        return p;
+    }
+  }
+
+  const char *on_key(const char *p, const char *end) {
+    p = detail::skip_whitespace(p, end);
+    if (p == end) {
+      return p;
+    }
+    if (m_state == state::first_key && *p == '}') {
+      return close(p);
+    }
+    if (*p != '"') {
+      return fail(parse_error_code::expected_key, p);
+    }
+    new_line(m_stack.size());
+    m_out += '"';
+    m_in_key = true;
+    m_state = state::string;
+    return p + 1;
+  }
+
+  const char *on_colon(const char *p, const char *end) {
+    p = detail::skip_whitespace(p, end);
+    if (p == end) {
+      return p;
+    }
+    if (*p != ':') {
+      return fail(parse_error_code::expected_colon, p);
+    }
+    m_out += m_options.indent != 0 ? ": " : ":";
+    m_state = state::value;
+    return p + 1;
+  }
+
+  const char *on_separator(const char *p, const char *end) {
+    p = detail::skip_whitespace(p, end);
+    if (p == end) {
+      return p;
+    }
+    bool is_object = m_stack.top_is_object();
+    if (*p == ',') {
+      m_out += ',';
+      m_state = is_object ? state::key : state::element;
+      return p + 1;
+    }
+    if (*p != (is_object ? '}' : ']')) {
+      return fail(parse_error_code::expected_comma_or_end, p);
+    }
+    new_line(m_stack.size() - 1);
+    return close(p);
+  }
+
+  /*
+    Close the innermost array/object with the bracket at p
+  */
+  const char *close(const char *p) {
+    m_out += *p;
+    m_stack.pop();
+    end_value();
+    return p + 1;
+  }
+
+  /*
+    Copy the characters of a string. Runs of characters without escapes are
+    found with SIMD and checked as UTF-8 in bulk; a UTF-8 sequence split
+    between two chunks is checked byte by byte.
+  */
+  const char *on_string(const char *p, const char *end) {
+    for (; m_utf8_need != 0 && p < end; p++) {
+      unsigned char c = static_cast<unsigned char>(*p);
+      if (c < m_utf8_min || c > m_utf8_max) {
+        return fail_at(parse_error_code::invalid_utf8, m_utf8_start);
+      }
+      m_out += *p;
+      m_utf8_need--;
+      m_utf8_min = 0x80;
+      m_utf8_max = 0xbf;
+    }
+    if (p == end) {
+      return p;
+    }
+    const char *special = detail::find_escape(p, end);
+    const char *invalid = detail::find_invalid_utf8(p, special);
+    if (invalid != special) {
+      if (special != end || !begin_utf8(invalid, end)) {
+        return fail(parse_error_code::invalid_utf8, invalid);
+      }
+      m_out.append(p, end);
+      return end;
+    }
+    m_out.append(p, special);
+    if (special == end) {
+      return end;
+    }
+    if (*special == '"') {
+      m_out += '"';
+      if (m_in_key) {
+        m_state = state::colon;
+      } else {
+        end_value();
+      }
+      return special + 1;
+    }
+    if (*special != '\\') {
+      return fail(parse_error_code::control_character, special);
+    }
+    m_out += '\\';
+    m_escape_size = 0;
+    m_token_start = offset(special + 1);
+    m_state = state::escape;
+    return special + 1;
+  }
+
+  /*
+    Start checking the UTF-8 sequence at p that is cut by the end of the
+    chunk. Returns false if its bytes so far are already ill-formed.
+  */
+  bool begin_utf8(const char *p, const char *end) {
+    unsigned char lead = static_cast<unsigned char>(*p);
+    m_utf8_min = 0x80;
+    m_utf8_max = 0xbf;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+      m_utf8_need = 1;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+      m_utf8_need = 2;
+      m_utf8_min = lead == 0xe0 ? 0xa0 : 0x80;
+      m_utf8_max = lead == 0xed ? 0x9f : 0xbf;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+      m_utf8_need = 3;
+      m_utf8_min = lead == 0xf0 ? 0x90 : 0x80;
+      m_utf8_max = lead == 0xf4 ? 0x8f : 0xbf;
+    } else {
+      return false;
+    }
+    m_utf8_start = offset(p);
+    for (p++; p < end; p++) {
+      unsigned char c = static_cast<unsigned char>(*p);
+      if (c < m_utf8_min || c > m_utf8_max || m_utf8_need == 0) {
+        m_utf8_need = 0;
+        return false;
+      }
+      m_utf8_need--;
+      m_utf8_min = 0x80;
+      m_utf8_max = 0xbf;
+    }
+    return m_utf8_need != 0;
+  }
+
+  /*
+    Collect the escape sequence after a reverse solidus: a single character,
+    \uXXXX, or a surrogate pair \uXXXX\uXXXX, then check it like the parser
+  */
+  const char *on_escape(const char *p, const char *end) {
+    while (p < end) {
+      char c = *p++;
+      m_out += c;
+      m_escape[m_escape_size++] = c;
+      uint32_t code_unit = 0;
+      bool complete =
+          m_escape[0] != 'u' ||
+          (m_escape_size == 5 &&
+           !(detail::parse_hex4(m_escape + 1, m_escape + 5, &code_unit) &&
+             code_unit >= 0xd800 && code_unit <= 0xdbff)) ||
+          m_escape_size == sizeof(m_escape);
+      if (complete) {
+        finish_escape();
+        break;
+      }
+    }
+    return p;
+  }
+
+  void finish_escape() {
+    detail::discard_string discard;
+    parse_error_code error = parse_error_code::none;
+    const char *p = detail::scan_escape(m_escape, m_escape + m_escape_size,
+                                        &discard, &error);
+    if (error != parse_error_code::none) {
+      fail_at(error, m_token_start + static_cast<size_t>(p - m_escape));
+      return;
+    }
+    m_state = state::string;
+  }
+
+  /*
+    Collect the characters of a number; it is checked once it ends
+  */
+  const char *on_number(const char *p, const char *end) {
+    const char *q = p;
+    while (q < end && (isdigit(static_cast<unsigned char>(*q)) || *q == '-' ||
+                       *q == '+' || *q == 'e' || *q == 'E' || *q == '.')) {
+      q++;
+    }
+    m_token.append(p, q);
+    if (q != end) {
+      finish_number();
+    }
+    return q;
+  }
+
+  void finish_number() {
+    double d = 0;
+    parse_error_code error = parse_error_code::none;
+    const char *begin = m_token.data();
+    const char *p =
+        detail::scan_number(begin, begin + m_token.size(), &d, &error);
+    if (error != parse_error_code::none) {
+      fail_at(error, m_token_start + static_cast<size_t>(p - begin));
+      return;
+    }
+    m_out += m_token;
+    end_value();
+  }
+
+  const char *on_literal(const char *p, const char *end) {
+    size_t n = strlen(m_literal);
+    for (; p < end && m_literal_size < n; p++, m_literal_size++) {
+      if (*p != m_literal[m_literal_size]) {
+        return fail_at(parse_error_code::invalid_literal, m_token_start);
+      }
+    }
+    if (m_literal_size == n) {
+      m_out.append(m_literal, n);
+      end_value();
+    }
+    return p;
+  }
+
+  void end_value() {
+    m_state = m_stack.empty() ? state::done : state::separator;
+  }
+
+  void new_line(size_t depth) {
+    if (m_options.indent != 0) {
+      detail::write_indent(depth, m_options.indent, &m_out);
+    }
+  }
+
+  void flush() {
+    if (!m_out.empty()) {
+      m_sink(m_out.data(), m_out.size());
+      m_out.clear();
+    }
+  }
+
+  /*
+    Get the offset in the whole input of a position in the current chunk
+  */
+  size_t offset(const char *p) const {
+    return m_offset + static_cast<size_t>(p - m_chunk);
+  }
+
+  const char *fail(parse_error_code code, const char *p) {
+    return fail_at(code, offset(p));
+  }
+
+  const char *fail_at(parse_error_code code, size_t offset) {
+    m_error.code = code;
+    m_error.offset = offset;
+    m_state = state::error;
+    return nullptr;
+  }
+
+ private:
+  sink_type m_sink;
+  format_options m_options;
+  parse_options m_parse;
+  std::string m_out;                // output of the current chunk
+  detail::container_stack m_stack;  // arrays and objects being formatted
+  state m_state = state::value;
+  parse_result m_error;
+  const char *m_chunk = nullptr;  // the current chunk
+  size_t m_offset = 0;            // offset of the current chunk in the input
+  size_t m_token_start = 0;       // offset of the number/literal/escape
+  bool m_in_key = false;          // the string is an object key
+  std::string m_token;            // characters of the number so far
+  const char *m_literal = nullptr;
+  size_t m_literal_size = 0;  // characters of the literal matched so far
+  char m_escape[11];          // escape sequence after the reverse solidus
+  size_t m_escape_size = 0;
+  size_t m_utf8_need = 0;  // continuation bytes of a split UTF-8 sequence
+  unsigned char m_utf8_min = 0x80;  // range of the next continuation byte
+  unsigned char m_utf8_max = 0xbf;
+  size_t m_utf8_start = 0;  // offset of the split UTF-8 sequence
+};
+
+/*
+  Rewrite a JSON string minified or indented without building JSON nodes.
+  out is only assigned if the JSON string is valid.
+*/
+inline parse_result format(const std::string &s, std::string *out,
+                           const format_options &options = format_options()) {
+  std::string res;
+  res.reserve(s.size());
+  json_formatter formatter(
+      [&res](const char *data, size_t size) { res.append(data, size); },
+      options);
+  formatter.write(s);
+  parse_result result = formatter.finish();
+  if (result) {
+    *out = std::move(res);
+  }
+  return result;
+}
+}  // namespace miniJSON
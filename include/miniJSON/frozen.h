@@ -0,0 +1,368 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./detail/serializer.h"
+#include "./errors.h"
+#include "./json_types.h"
+#include "./options.h"
+
+namespace miniJSON {
+/*
+  An immutable JSON document created by json_node::freeze(). All values are
+  stored in flat arrays: the elements/members of an array/object are stored
+  next to each other, and the keys of each object are indexed in sorted order
+  so that they are found by binary search. Nothing is modified after
+  construction, so any number of threads can read a frozen document
+  concurrently without synchronization. Copies share the same storage.
+*/
+class frozen_json {
+ private:
+  /*
+    A frozen value. Arrays and objects refer to their elements/members by the
+    index of the first one and their count.
+  */
+  struct entry {
+    json_value_type type = json_value_type::null;
+    uint32_t size = 0;
+    union {
+      int64_t number_int;
+      double number_double;
+      bool boolean;
+      size_t str;    // index into data::strings
+      size_t first;  // index of the first element/member
+    };
+    entry() : number_int(0) {}
+  };
+
+  /*
+    Storage of a frozen document shared by its copies
+  */
+  struct data {
+    std::vector<entry> entries;        // values, the root is the first one
+    std::vector<size_t> keys;          // keys of object members by entry
+    std::vector<uint32_t> sorted;      // member positions sorted by key
+    std::vector<std::string> strings;  // string values and keys
+  };
+
+ public:
+  class value;
+
+  /*
+    Freeze a JSON node. Object members keep their insertion order.
+  */
+  template <typename JSONNode>
+  explicit frozen_json(const JSONNode &node) {
+    // values are laid out breadth first so that children are contiguous
+    std::shared_ptr<data> d = std::make_shared<data>();
+    std::deque<std::pair<const JSONNode *, size_t>> queue;
+    d->entries.emplace_back();
+    queue.emplace_back(&node, 0);
+    while (!queue.empty()) {
+      const JSONNode *j = queue.front().first;
+      size_t index = queue.front().second;
+      queue.pop_front();
+      freeze_value(*j, index, &queue, d.get());
+    }
+    m_data = std::move(d);
+  }
+
+  /*
+    Get the root value
+  */
+  value root() const;
+
+ public:
+  /*
+    A read-only handle to a value of a frozen document. It stays valid as long
+    as the document or one of its copies is alive.
+  */
+  class value {
+   public:
+    value() = default;
+
+    /*
+      Get the JSON value type
+    */
+    json_value_type get_type() const { return entry().type; }
+
+    /*
+      Get the boolean value
+    */
+    bool get_boolean() const {
+      expect(json_value_type::boolean, "boolean");
+      return entry().boolean;
+    }
+
+    /*
+      Get the string value
+    */
+    const std::string &get_string() const {
+      expect(json_value_type::string, "string");
+      return m_document->strings[entry().str];
+    }
+
+    /*
+      Get the integer value
+    */
+    int64_t get_integer() const {
+      expect(json_value_type::number_int, "integer");
+      return entry().number_int;
+    }
+
+    /*
+      Get the double value
+    */
+    double get_double() const {
+      expect(json_value_type::number_double, "double");
+      return entry().number_double;
+    }
+
+    /*
+      Get the number of elements/members of an array/object
+    */
+    size_t size() const {
+      if (!is_container()) {
+        MINIJSON_THROW(json_type_error(
+            "trying to get size of a non-array/object JSON node"));
+      }
+      return entry().size;
+    }
+
+    /*
+      Find the value associated with key in an object. Returns false if the
+      key does not exist.
+    */
+    bool find(const std::string &key, value *result) const {
+      expect(json_value_type::object, "object");
+      const data &doc = *m_document;
+      const entry_t &e = entry();
+      const uint32_t *first = doc.sorted.data() + e.first;
+      const uint32_t *last = first + e.size;
+      const uint32_t *it = std::lower_bound(
+          first, last, key, [&doc, &e](uint32_t member, const std::string &k) {
+            return doc.strings[doc.keys[e.first + member]] < k;
+          });
+      if (it == last || doc.strings[doc.keys[e.first + *it]] != key) {
+        return false;
+      }
+      *result = value(m_document, e.first + *it);
+      return true;
+    }
+
+    /*
+      Check if an object has the key
+    */
+    bool contains(const std::string &key) const {
+      value v;
+      return find(key, &v);
+    }
+
+    /*
+      Get the value associated with key from an object. It throws
+      std::out_of_range if the key does not exist.
+    */
+    value at(const std::string &key) const {
+      value v;
+      if (!find(key, &v)) {
+        MINIJSON_THROW(std::out_of_range("key not found: " + key));
+      }
+      return v;
+    }
+    value operator[](const std::string &key) const { return at(key); }
+
+    /*
+      Get the element at index of an array or the member at index of an
+      object. It throws std::out_of_range if the index is invalid.
+    */
+    value at(size_t index) const {
+      if (!is_container()) {
+        MINIJSON_THROW(json_type_error(
+            "trying to access element of a non-array/object JSON node"));
+      }
+      if (index >= entry().size) {
+        MINIJSON_THROW(std::out_of_range("invalid index"));
+      }
+      return value(m_document, entry().first + index);
+    }
+    value operator[](size_t index) const { return at(index); }
+
+    /*
+      Get the key of the member at index of an object
+    */
+    const std::string &key(size_t index) const {
+      expect(json_value_type::object, "object");
+      if (index >= entry().size) {
+        MINIJSON_THROW(std::out_of_range("invalid index"));
+      }
+      return m_document->strings[m_document->keys[entry().first + index]];
+    }
+
+    /*
+      Convert the value into JSON string (Serialization)
+    */
+    std::string to_string(
+        const serialize_options &options = serialize_options()) const {
+      std::string s;
+      serialize(options, 0, &s);
+      return s;
+    }
+
+   private:
+    friend class frozen_json;
+    using entry_t = frozen_json::entry;
+    using data = frozen_json::data;
+
+    value(const data *document, size_t index)
+        : m_document(document), m_index(index) {}
+
+    const entry_t &entry() const { return m_document->entries[m_index]; }
+    bool is_container() const {
+      return get_type() == json_value_type::array ||
+             get_type() == json_value_type::object;
+    }
+    void expect(json_value_type type, const char *name) const {
+      static_cast<void>(name);  // unused when exceptions are disabled
+      if (get_type() != type) {
+        MINIJSON_THROW(json_type_error(std::string("trying to access ") +
+                                       name + " value from a non-" + name +
+                                       " JSON node"));
+      }
+    }
+
+    void serialize(const serialize_options &options, size_t depth,
+                   std::string *out) const {
+      const entry_t &e = entry();
+      switch (e.type) {
+        case json_value_type::boolean:
+          *out += e.boolean ? "true" : "false";
+          break;
+        case json_value_type::string:
+          detail::write_string(m_document->strings[e.str],
+                               options.ensure_ascii, out);
+          break;
+        case json_value_type::number_int:
+          *out += std::to_string(e.number_int);
+          break;
+        case json_value_type::number_double:
+          detail::write_double(e.number_double, out);
+          break;
+        case json_value_type::array:
+        case json_value_type::object:
+          *out += e.type == json_value_type::array ? '[' : '{';
+          for (size_t i = 0; i < e.size; i++) {
+            if (i != 0) {
+              *out += ',';
+            }
+            if (options.indent != 0) {
+              detail::write_indent(depth + 1, options.indent, out);
+            }
+            if (e.type == json_value_type::object) {
+              detail::write_string(key(i), options.ensure_ascii, out);
+              *out += options.indent != 0 ? ": " : ":";
+            }
+            value(m_document, e.first + i).serialize(options, depth + 1, out);
+          }
+          if (options.indent != 0 && e.size != 0) {
+            detail::write_indent(depth, options.indent, out);
+          }
+          *out += e.type == json_value_type::array ? ']' : '}';
+          break;
+        default:
+          *out += "null";
+          break;
+      }
+    }
+
+   private:
+    const data *m_document = nullptr;
+    size_t m_index = 0;
+  };
+
+ private:
+  template <typename JSONNode>
+  static void freeze_value(
+      const JSONNode &node, size_t index,
+      std::deque<std::pair<const JSONNode *, size_t>> *queue, data *d) {
+    json_value_type type = node.m_type;
+    entry e;
+    e.type = type;
+    if (type == json_value_type::boolean) {
+      e.boolean = node.m_value.boolean;
+    } else if (type == json_value_type::number_int) {
+      e.number_int = node.number_int();
+    } else if (type == json_value_type::number_double) {
+      e.number_double = node.number_double();
+    } else if (type == json_value_type::string) {
+      e.str = add_string(*node.m_value.str, d);
+    } else if (type == json_value_type::array) {
+      auto &array = *node.m_value.array;
+      e.size = static_cast<uint32_t>(array.size());
+      e.first = allocate(array.size(), d);
+      for (size_t i = 0; i < array.size(); i++) {
+        queue->emplace_back(array[i], e.first + i);
+      }
+    } else if (type == json_value_type::object) {
+      auto &object = *node.m_value.object;
+      e.size = static_cast<uint32_t>(object.size());
+      e.first = allocate(object.size(), d);
+      size_t i = e.first;
+      for (auto it = object.values_begin(); it != object.values_end(); it++) {
+        d->keys[i] = add_string(it.key(), d);
+        queue->emplace_back(*it, i++);
+      }
+      index_keys(e.first, e.size, d);
+    } else {
+      e.type = json_value_type::null;  // indeterminate nodes are frozen as null
+    }
+    d->entries[index] = e;
+  }
+
+  /*
+    Allocate n consecutive entries and return the index of the first one
+  */
+  static size_t allocate(size_t n, data *d) {
+    size_t first = d->entries.size();
+    d->entries.resize(first + n);
+    d->keys.resize(first + n);
+    d->sorted.resize(first + n);
+    return first;
+  }
+
+  template <typename String>
+  static size_t add_string(const String &s, data *d) {
+    d->strings.emplace_back(s.data(), s.size());
+    return d->strings.size() - 1;
+  }
+
+  /*
+    Sort the positions of the object members in [first, first + n) by key
+  */
+  static void index_keys(size_t first, size_t n, data *d) {
+    uint32_t *sorted = d->sorted.data() + first;
+    for (size_t i = 0; i < n; i++) {
+      sorted[i] = static_cast<uint32_t>(i);
+    }
+    const size_t *keys = d->keys.data() + first;
+    const std::vector<std::string> &strings = d->strings;
+    std::sort(sorted, sorted + n, [keys, &strings](uint32_t a, uint32_t b) {
+      return strings[keys[a]] < strings[keys[b]];
+    });
+  }
+
+ private:
+  std::shared_ptr<const data> m_data;
+};
+
+inline frozen_json::value frozen_json::root() const {
+  return value(m_data.get(), 0);
+}
+}  // namespace miniJSON
@@ -0,0 +1,61 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <string>
+#include <vector>
+
+#include "./detail/path.h"
+#include "./errors.h"
+#include "./options.h"
+
+namespace miniJSON {
+/*
+  A JSONPath query compiled once and run any number of times. It supports
+  member names (.name, ['name']), array indices ([0]), wildcards (.*, [*]),
+  descendants (..name) and filters ([?(@.price < 10 && @.tags)]) comparing
+  @-relative paths with literals. The expression is compiled by the
+  constructor, which throws json_path_error if it is invalid.
+*/
+template <typename JSONNode>
+class basic_json_path {
+ public:
+  explicit basic_json_path(const std::string &expression)
+      : m_expression(expression),
+        m_plan(detail::path_compiler(m_expression).compile()) {}
+
+  /*
+    Get the nodes matching the query in document order. Nothing is copied:
+    the results point into the tree of root and stay valid as long as it is
+    not modified.
+  */
+  std::vector<const JSONNode *> select(const JSONNode &root) const {
+    std::vector<const JSONNode *> res;
+    auto emit = [&res](const JSONNode &j) { res.push_back(&j); };
+    detail::path_evaluator<JSONNode>(m_plan).select(root, emit);
+    return res;
+  }
+
+  /*
+    Run the query over a JSON string without parsing it into a tree and call
+    callback(const JSONNode &) with every matching value in document order.
+    Only the matching values (and the elements tested by filters) are parsed,
+    the rest of the input is validated and skipped. A value is only valid
+    during the call. Invalid input stops the query and its error is returned;
+    matches before the error have been reported already. Values are reported
+    as soon as they are parsed, so every member of an object with a
+    duplicate key is matched, while parse() and select() only keep the last
+    one.
+  */
+  template <typename F>
+  parse_result stream(const std::string &input, F callback,
+                      const parse_options &options = parse_options()) const {
+    return detail::path_evaluator<JSONNode>(m_plan).stream(input, options,
+                                                           callback);
+  }
+
+  const std::string &expression() const { return m_expression; }
+
+ private:
+  std::string m_expression;
+  detail::path_plan m_plan;
+};
+}  // namespace miniJSON
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <string>
+
+#include "./detail/schema.h"
+#include "./errors.h"
+
+namespace miniJSON {
+template <typename JSONNode>
+class basic_parser;
+
+/*
+  Result of validating a JSON node against a JSON Schema. Converts to true if
+  the node is valid; otherwise path is the JSON pointer (RFC 6901) of the
+  first rejected value and message says why it is rejected.
+*/
+struct schema_result {
+  bool valid = true;
+  std::string path;
+  std::string message;
+
+  explicit operator bool() const { return valid; }
+};
+
+/*
+  A JSON Schema compiled once and checked against any number of JSON nodes,
+  or against JSON strings while they are parsed with parse(s, schema). The
+  supported keywords are type, enum, const, properties, required,
+  additionalProperties, items, minimum, maximum, exclusiveMinimum,
+  exclusiveMaximum, minLength, maxLength, pattern (ECMAScript regular
+  expressions, not anchored), minItems, maxItems, minProperties and
+  maxProperties; annotations are ignored. The constructor throws
+  json_schema_error if the schema is invalid or uses a keyword that is not
+  supported, such as $ref or anyOf.
+*/
+template <typename JSONNode>
+class basic_json_schema {
+ public:
+  explicit basic_json_schema(const JSONNode &schema) : m_program(schema) {}
+
+  /*
+    Parse the schema from a JSON string. It will also throw json_parse_error
+    if the JSON string format is invalid.
+  */
+  explicit basic_json_schema(const std::string &schema);
+  explicit basic_json_schema(const char *schema)
+      : basic_json_schema(std::string(schema)) {}
+
+  /*
+    Validate a JSON node and its descendants. Members are checked in
+    insertion order and the first violation is reported.
+  */
+  schema_result validate(const JSONNode &json) const {
+    schema_result res;
+    res.valid = m_program.validate(json, m_program.root(), &res.path,
+                                   &res.message);
+    return res;
+  }
+
+ private:
+  friend class basic_parser<JSONNode>;
+
+  detail::schema_program<JSONNode> m_program;
+};
+}  // namespace miniJSON
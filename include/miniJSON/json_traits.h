@@ -0,0 +1,54 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./detail/ordered_map.h"
+
+namespace miniJSON {
+/*
+  Types used by json_node. A basic_json_node can be instantiated with other
+  traits to change how values are stored:
+  - string_type: strings and object keys, a std::basic_string of char
+  - integer_type: signed integral numbers
+  - float_type: floating point numbers
+  - object_type: map from key to child node with the interface of
+    ordered_map described below
+  - array_type: sequence of child nodes with the interface of std::vector
+  - allocator_type: allocator of the JSON nodes and of the object/array/string
+    values they own. Every node keeps an instance: the one passed to the
+    basic_json_node(allocator) constructor, the one of its parent for the
+    nodes added to a document, or else a default constructed one. Values
+    whose own allocator_type can be constructed from it (std::uses_allocator)
+    are constructed with it as their last argument, so a stateful allocator
+    serves a whole document once the containers are declared with it.
+
+  The object_type keeps its members in insertion order and provides, as
+  ordered_map does:
+  - a default constructor, and one taking its allocator_type if it has one
+  - Value &operator[](const Key &) inserting a value-initialized member
+  - std::pair<Value *, bool> emplace(const Key &, Value) leaving an existing
+    member alone, and void insert_at(size_t pos, const Key &, Value) for a
+    new key
+  - const Value *find(const Key &) const, returning nullptr if key is absent
+  - size_t count(const Key &) const, size_t index_of(const Key &) const,
+    size_t erase(const Key &), size_t size() const and void reserve(size_t)
+  - void for_each_value(F f) calling f on every value in any order
+  - begin()/end() iterating over the keys, and values_begin()/values_end()
+    iterating over the values in insertion order with a default
+    constructible values_iterator whose key() is the key of the member
+*/
+struct default_json_traits {
+  using string_type = std::string;
+  using integer_type = int64_t;
+  using float_type = double;
+  template <typename Key, typename Value>
+  using object_type = ordered_map<Key, Value>;
+  template <typename Value>
+  using array_type = std::vector<Value>;
+  template <typename T>
+  using allocator_type = std::allocator<T>;
+};
+}  // namespace miniJSON
@@ -0,0 +1,1014 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "./miniJSON.h"
+
+/*
+  Compile-time JSON literals. "..."_json is parsed and validated by the
+  compiler into a read-only document in static storage: a malformed literal
+  is a build error and nothing is parsed at startup. The literal operator
+  takes the string as a template argument, which needs C++20; this header
+  defines nothing in earlier modes.
+*/
+#if defined(__cpp_nontype_template_args) && \
+    __cpp_nontype_template_args >= 201911L
+#include <bit>
+#include <string_view>
+
+namespace miniJSON {
+namespace detail {
+/*
+  A string literal usable as a template argument
+*/
+template <size_t N>
+struct fixed_string {
+  constexpr fixed_string(const char (&s)[N]) {  // NOLINT(runtime/explicit)
+    for (size_t i = 0; i < N; i++) {
+      data[i] = s[i];
+    }
+  }
+  constexpr size_t size() const { return N - 1; }
+
+  char data[N] = {};
+};
+
+/*
+  A value of a static document. Values are stored in document order: the
+  elements/members of an array/object follow it, and next is the index of the
+  value after its last descendant.
+*/
+struct static_entry {
+  json_value_type type = json_value_type::null;
+  size_t size = 0;      // length of a string, elements/members of a container
+  size_t next = 0;      // index of the next sibling
+  size_t str = 0;       // offset of a string in the characters
+  size_t key = 0;       // offset of the key of an object member
+  size_t key_size = 0;  // length of the key of an object member
+  int64_t number_int = 0;
+  double number_double = 0;
+  bool boolean = false;
+};
+
+/*
+  Instantiated with the error of every JSON literal. A malformed literal
+  fails the build with the kind of error and its offset in the name of the
+  instantiation, e.g. malformed_json_literal<expected_key, 14>.
+*/
+template <parse_error_code Code, size_t Offset>
+struct malformed_json_literal {
+  static_assert(Code == parse_error_code::none, "malformed JSON literal");
+  static constexpr bool value = true;
+};
+
+/*
+  An unsigned integer of up to 5120 bits, enough for the exact comparisons
+  of decimal numbers of up to 800 significant digits with doubles
+*/
+struct big_integer {
+  static constexpr size_t capacity = 160;
+
+  constexpr explicit big_integer(uint64_t x) {
+    for (; x != 0; x >>= 32) {
+      limbs[size++] = static_cast<uint32_t>(x);
+    }
+  }
+
+  constexpr void multiply(uint32_t x) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < size; i++) {
+      uint64_t v = static_cast<uint64_t>(limbs[i]) * x + carry;
+      limbs[i] = static_cast<uint32_t>(v);
+      carry = v >> 32;
+    }
+    if (carry != 0) {
+      limbs[size++] = static_cast<uint32_t>(carry);
+    }
+  }
+
+  constexpr void add(uint32_t x) {
+    for (size_t i = 0; x != 0; i++) {
+      if (i == size) {
+        limbs[size++] = 0;
+      }
+      uint64_t v = static_cast<uint64_t>(limbs[i]) + x;
+      limbs[i] = static_cast<uint32_t>(v);
+      x = static_cast<uint32_t>(v >> 32);
+    }
+  }
+
+  constexpr void multiply_pow5(int64_t n) {
+    for (; n >= 13; n -= 13) {
+      multiply(1220703125);  // 5^13
+    }
+    uint32_t x = 1;
+    for (; n > 0; n--) {
+      x *= 5;
+    }
+    multiply(x);
+  }
+
+  constexpr void shift_left(int64_t n) {
+    if (size == 0) {
+      return;
+    }
+    size_t words = static_cast<size_t>(n / 32);
+    unsigned bits = static_cast<unsigned>(n % 32);
+    uint32_t top = bits != 0 ? limbs[size - 1] >> (32 - bits) : 0;
+    for (size_t i = size; i-- > 0;) {
+      uint32_t v = limbs[i] << bits;
+      if (bits != 0 && i > 0) {
+        v |= limbs[i - 1] >> (32 - bits);
+      }
+      limbs[i + words] = v;
+    }
+    for (size_t i = 0; i < words; i++) {
+      limbs[i] = 0;
+    }
+    size += words;
+    if (top != 0) {
+      limbs[size++] = top;
+    }
+  }
+
+  friend constexpr int compare(const big_integer &a, const big_integer &b) {
+    if (a.size != b.size) {
+      return a.size < b.size ? -1 : 1;
+    }
+    for (size_t i = a.size; i-- > 0;) {
+      if (a.limbs[i] != b.limbs[i]) {
+        return a.limbs[i] < b.limbs[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  uint32_t limbs[capacity] = {};
+  size_t size = 0;  // limbs in use, the highest one is nonzero
+};
+
+/*
+  Parser of JSON literals that runs during constant evaluation. Without
+  storage it only counts the values and string characters of the document,
+  which size the storage of the second run.
+*/
+class literal_parser {
+ public:
+  constexpr literal_parser(const char *s, size_t size, static_entry *entries,
+                           char *chars)
+      : m_s(s), m_size(size), m_entries(entries), m_chars(chars) {}
+
+  constexpr void parse() {
+    skip_whitespace();
+    if (!parse_value(0, 0, 0)) {
+      return;
+    }
+    skip_whitespace();
+    if (m_index != m_size) {
+      fail(parse_error_code::trailing_characters);
+    }
+  }
+
+  constexpr parse_error_code error() const { return m_error; }
+  constexpr size_t error_offset() const { return m_error_offset; }
+  constexpr size_t entry_count() const { return m_entry_count; }
+  constexpr size_t char_count() const { return m_char_count; }
+
+ private:
+  constexpr bool fail(parse_error_code code) {
+    m_error = code;
+    m_error_offset = m_index;
+    return false;
+  }
+
+  constexpr bool at_end() const { return m_index >= m_size; }
+  constexpr char peek() const { return m_s[m_index]; }
+
+  static constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+  constexpr void skip_whitespace() {
+    while (!at_end() && (peek() == ' ' || peek() == '\n' || peek() == '\r' ||
+                         peek() == '\t')) {
+      m_index++;
+    }
+  }
+
+  constexpr bool parse_value(size_t depth, size_t key, size_t key_size) {
+    if (at_end()) {
+      return fail(parse_error_code::unexpected_end);
+    }
+    size_t index = m_entry_count++;
+    static_entry e;
+    e.key = key;
+    e.key_size = key_size;
+    bool ok = true;
+    char c = peek();
+    if (c == '{' || c == '[') {
+      if (depth >= parse_options().max_depth) {
+        return fail(parse_error_code::depth_exceeded);
+      }
+      e.type = c == '{' ? json_value_type::object : json_value_type::array;
+      ok = parse_container(depth, &e);
+    } else if (c == '"') {
+      e.type = json_value_type::string;
+      ok = parse_string(&e.str, &e.size);
+    } else if (c == 't' || c == 'f' || c == 'n') {
+      ok = parse_literal(&e);
+    } else if (c == '-' || c == '.' || is_digit(c)) {
+      ok = parse_number(&e);
+    } else {
+      return fail(parse_error_code::unexpected_character);
+    }
+    e.next = m_entry_count;
+    if (ok && m_entries != nullptr) {
+      m_entries[index] = e;
+    }
+    return ok;
+  }
+
+  constexpr bool parse_container(size_t depth, static_entry *e) {
+    bool object = e->type == json_value_type::object;
+    char close = object ? '}' : ']';
+    m_index++;
+    skip_whitespace();
+    if (!at_end() && peek() == close) {
+      m_index++;
+      return true;
+    }
+    while (true) {
+      size_t key = 0, key_size = 0;
+      if (object) {
+        if (at_end()) {
+          return fail(parse_error_code::unexpected_end);
+        }
+        if (peek() != '"') {
+          return fail(parse_error_code::expected_key);
+        }
+        if (!parse_string(&key, &key_size)) {
+          return false;
+        }
+        skip_whitespace();
+        if (at_end()) {
+          return fail(parse_error_code::unexpected_end);
+        }
+        if (peek() != ':') {
+          return fail(parse_error_code::expected_colon);
+        }
+        m_index++;
+        skip_whitespace();
+      }
+      if (!parse_value(depth + 1, key, key_size)) {
+        return false;
+      }
+      e->size++;
+      skip_whitespace();
+      if (at_end()) {
+        return fail(parse_error_code::unexpected_end);
+      }
+      if (peek() == close) {
+        m_index++;
+        return true;
+      }
+      if (peek() != ',') {
+        return fail(parse_error_code::expected_comma_or_end);
+      }
+      m_index++;
+      skip_whitespace();
+    }
+  }
+
+  constexpr bool parse_literal(static_entry *e) {
+    const char *literal = peek() == 't' ? "true"
+                          : peek() == 'f' ? "false"
+                                          : "null";
+    for (size_t i = 0; literal[i] != '\0'; i++) {
+      if (m_index + i >= m_size || m_s[m_index + i] != literal[i]) {
+        return fail(parse_error_code::invalid_literal);
+      }
+    }
+    e->type = literal[0] == 'n' ? json_value_type::null
+                                : json_value_type::boolean;
+    e->boolean = literal[0] == 't';
+    m_index += literal[0] == 'f' ? 5 : 4;
+    return true;
+  }
+
+  constexpr void put(char c) {
+    if (m_chars != nullptr) {
+      m_chars[m_char_count] = c;
+    }
+    m_char_count++;
+  }
+
+  constexpr void put_code_point(uint32_t cp) {
+    if (cp < 0x80) {
+      put(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      put(static_cast<char>(0xc0 | (cp >> 6)));
+      put(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+      put(static_cast<char>(0xe0 | (cp >> 12)));
+      put(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+      put(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else {
+      put(static_cast<char>(0xf0 | (cp >> 18)));
+      put(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+      put(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+      put(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+  }
+
+  /*
+    Parse 4 hex digits at the parse index, or return -1
+  */
+  constexpr int32_t parse_hex4() const {
+    int32_t res = 0;
+    for (size_t i = 0; i < 4; i++) {
+      if (m_index + i >= m_size) {
+        return -1;
+      }
+      char c = m_s[m_index + i];
+      int32_t digit = is_digit(c)               ? c - '0'
+                      : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                      : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                             : -1;
+      if (digit < 0) {
+        return -1;
+      }
+      res = res * 16 + digit;
+    }
+    return res;
+  }
+
+  /*
+    Get the length of the well-formed UTF-8 sequence at the parse index, or 0
+  */
+  constexpr size_t utf8_length() const {
+    auto byte = [this](size_t i) {
+      return m_index + i < m_size
+                 ? static_cast<uint32_t>(static_cast<unsigned char>(
+                       m_s[m_index + i]))
+                 : 0u;
+    };
+    uint32_t lead = byte(0);
+    size_t length = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : 2;
+    if (lead < 0xc2 || lead > 0xf4) {
+      return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+      if ((byte(i) & 0xc0) != 0x80) {
+        return 0;
+      }
+    }
+    uint32_t second = byte(1);
+    if ((lead == 0xe0 && second < 0xa0) || (lead == 0xed && second > 0x9f) ||
+        (lead == 0xf0 && second < 0x90) || (lead == 0xf4 && second > 0x8f)) {
+      return 0;  // overlong, surrogate or beyond U+10FFFF
+    }
+    return length;
+  }
+
+  /*
+    Parse a string, storing the decoded characters
+  */
+  constexpr bool parse_string(size_t *offset, size_t *size) {
+    *offset = m_char_count;
+    m_index++;
+    while (true) {
+      if (at_end()) {
+        return fail(parse_error_code::unterminated_string);
+      }
+      unsigned char c = static_cast<unsigned char>(peek());
+      if (c == '"') {
+        m_index++;
+        break;
+      }
+      if (c < 0x20) {
+        return fail(parse_error_code::control_character);
+      }
+      if (c >= 0x80) {
+        size_t length = utf8_length();
+        if (length == 0) {
+          return fail(parse_error_code::invalid_utf8);
+        }
+        for (size_t i = 0; i < length; i++) {
+          put(m_s[m_index++]);
+        }
+        continue;
+      }
+      if (c != '\\') {
+        put(static_cast<char>(c));
+        m_index++;
+        continue;
+      }
+      if (!parse_escape()) {
+        return false;
+      }
+    }
+    *size = m_char_count - *offset;
+    return true;
+  }
+
+  constexpr bool parse_escape() {
+    size_t begin = m_index;
+    m_index++;
+    if (at_end()) {
+      return fail(parse_error_code::unexpected_end);
+    }
+    char c = peek();
+    m_index++;
+    switch (c) {
+      case '"':
+      case '\\':
+      case '/':
+        put(c);
+        return true;
+      case 'b':
+        put('\b');
+        return true;
+      case 'f':
+        put('\f');
+        return true;
+      case 'n':
+        put('\n');
+        return true;
+      case 'r':
+        put('\r');
+        return true;
+      case 't':
+        put('\t');
+        return true;
+      case 'u':
+        break;
+      default:
+        m_index = begin;
+        return fail(parse_error_code::invalid_escape);
+    }
+    int32_t unit = parse_hex4();
+    if (unit < 0) {
+      m_index = begin;
+      return fail(parse_error_code::invalid_escape);
+    }
+    m_index += 4;
+    uint32_t cp = static_cast<uint32_t>(unit);
+    if (cp >= 0xd800 && cp <= 0xdbff) {
+      int32_t low = m_index + 1 < m_size && peek() == '\\' &&
+                            m_s[m_index + 1] == 'u'
+                        ? (m_index += 2, parse_hex4())
+                        : -1;
+      if (low < 0xdc00 || low > 0xdfff) {
+        m_index = begin;
+        return fail(parse_error_code::invalid_escape);
+      }
+      m_index += 4;
+      cp = 0x10000 + ((cp - 0xd800) << 10) + (static_cast<uint32_t>(low) -
+                                              0xdc00);
+    } else if (cp >= 0xdc00 && cp <= 0xdfff) {
+      m_index = begin;
+      return fail(parse_error_code::invalid_escape);
+    }
+    put_code_point(cp);
+    return true;
+  }
+
+  /*
+    Parse a number with the grammar of parse(). Integers that fit int64_t
+    are exact and other numbers are correctly rounded to the nearest double,
+    ties to even, as by strtod in parse(). Integral doubles become integers,
+    as in parse().
+  */
+  constexpr bool parse_number(static_entry *e) {
+    size_t begin = m_index;
+    bool negative = peek() == '-';
+    m_index += negative ? 1 : 0;
+    size_t digits_begin = m_index;
+    uint64_t mantissa = 0;
+    size_t significant = 0;  // digits in the mantissa
+    size_t digits = 0;
+    int64_t exponent = 0;
+    bool integer = true;
+    bool exact = true;  // the integer fits the mantissa
+    auto add_digit = [&](char c, bool fraction) {
+      digits++;
+      if (significant == 0 && c == '0') {
+        exponent -= fraction ? 1 : 0;
+        return;
+      }
+      if (significant < 19) {
+        mantissa = mantissa * 10 + static_cast<uint64_t>(c - '0');
+        significant++;
+        exponent -= fraction ? 1 : 0;
+      } else {
+        exact = false;
+        exponent += fraction ? 0 : 1;
+      }
+    };
+    while (!at_end() && is_digit(peek())) {
+      add_digit(m_s[m_index++], false);
+    }
+    if (!at_end() && peek() == '.') {
+      integer = false;
+      m_index++;
+      while (!at_end() && is_digit(peek())) {
+        add_digit(m_s[m_index++], true);
+      }
+      if (m_s[m_index - 1] == '.') {
+        if (digits != 0 && (at_end() || (peek() != 'e' && peek() != 'E'))) {
+          return fail(parse_error_code::invalid_number);
+        }
+      }
+    }
+    if (digits == 0) {
+      m_index = begin;
+      return fail(parse_error_code::invalid_number);
+    }
+    size_t digits_end = m_index;
+    int64_t explicit_exponent = 0;
+    if (!at_end() && (peek() == 'e' || peek() == 'E')) {
+      integer = false;
+      m_index++;
+      bool negative_exponent = !at_end() && peek() == '-';
+      m_index += !at_end() && (peek() == '-' || peek() == '+') ? 1 : 0;
+      if (at_end() || !is_digit(peek())) {
+        return fail(parse_error_code::invalid_number);
+      }
+      int64_t e10 = 0;
+      while (!at_end() && is_digit(peek())) {
+        e10 = e10 < 100000 ? e10 * 10 + (m_s[m_index] - '0') : e10;
+        m_index++;
+      }
+      explicit_exponent = negative_exponent ? -e10 : e10;
+      exponent += explicit_exponent;
+    }
+    if (!at_end() && (peek() == '-' || peek() == '+' || peek() == '.' ||
+                      peek() == 'e' || peek() == 'E')) {
+      return fail(parse_error_code::invalid_number);
+    }
+
+    const uint64_t int64_max = std::numeric_limits<int64_t>::max();
+    if (integer && exact && mantissa <= int64_max + (negative ? 1 : 0)) {
+      e->type = json_value_type::number_int;
+      e->number_int = negative ? static_cast<int64_t>(0 - mantissa)
+                               : static_cast<int64_t>(mantissa);
+      return true;
+    }
+    double d = 0;
+    if (exact && mantissa < (uint64_t(1) << 53) && exponent >= -22 &&
+        exponent <= 22) {
+      d = to_double(mantissa, exponent);  // a single rounding
+    } else if (mantissa != 0) {
+      d = round_decimal(to_double(mantissa, exponent), m_s + digits_begin,
+                        m_s + digits_end, explicit_exponent);
+    }
+    if (d < 9223372036854775808.0 && static_cast<double>(
+                                         static_cast<int64_t>(d)) == d) {
+      e->type = json_value_type::number_int;
+      e->number_int = negative ? -static_cast<int64_t>(d)
+                               : static_cast<int64_t>(d);
+    } else {
+      e->type = json_value_type::number_double;
+      e->number_double = negative ? -d : d;
+    }
+    return true;
+  }
+
+  /*
+    Get a double within a few units in the last place of mantissa *
+    10^exponent. It is exact if the mantissa and the power of ten are exact
+    doubles.
+  */
+  static constexpr double to_double(uint64_t mantissa, int64_t exponent) {
+    constexpr double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+    double d = static_cast<double>(mantissa);
+    if (mantissa == 0) {
+      return 0;
+    }
+    if (mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+      return exponent < 0 ? d / powers[-exponent] : d * powers[exponent];
+    }
+    // overflowing is not a constant expression, so it is checked first on
+    // half the product, which is rounded the same way
+    const double max = std::numeric_limits<double>::max();
+    const double infinity = std::numeric_limits<double>::infinity();
+    for (; exponent > 22; exponent -= 22) {
+      if (d > max / 1e22 || d / 2 * 1e22 > max / 2) {
+        return infinity;
+      }
+      d *= 1e22;
+    }
+    for (; exponent < -22 && d > 0; exponent += 22) {
+      d /= 1e22;
+    }
+    if (exponent < -22) {
+      return d;
+    }
+    if (exponent >= 0 && (d > max / powers[exponent] ||
+                          d / 2 * powers[exponent] > max / 2)) {
+      return infinity;
+    }
+    return exponent < 0 ? d / powers[-exponent] : d * powers[exponent];
+  }
+
+  /*
+    Round the positive decimal number with the digits (and the dot) in
+    [p, end) and the exponent to the nearest double, ties to even. The
+    approximation guess is moved to the neighboring double as long as the
+    number is beyond the point halfway to it, which is decided exactly with
+    big integers. Digits beyond the 800th can only break a tie.
+  */
+  static constexpr double round_decimal(double guess, const char *p,
+                                        const char *end, int64_t exponent) {
+    big_integer digits(0);
+    int64_t count = 0;
+    bool fraction = false;
+    bool truncated = false;  // nonzero digits were dropped
+    for (; p < end; p++) {
+      if (*p == '.') {
+        fraction = true;
+      } else if (count == 0 && *p == '0') {
+        exponent -= fraction ? 1 : 0;
+      } else if (count < 800) {
+        digits.multiply(10);
+        digits.add(static_cast<uint32_t>(*p - '0'));
+        count++;
+        exponent -= fraction ? 1 : 0;
+      } else {
+        truncated = truncated || *p != '0';
+        exponent += fraction ? 0 : 1;
+      }
+    }
+    // the number is in [10^(count + exponent - 1), 10^(count + exponent))
+    if (count + exponent > 309) {
+      return std::numeric_limits<double>::infinity();
+    }
+    if (count + exponent <= -324) {
+      return 0;
+    }
+    const double max = std::numeric_limits<double>::max();
+    double d = guess > max ? max : guess;
+    while (true) {
+      int above = compare_halfway(digits, exponent, truncated, d);
+      if (above > 0 || (above == 0 && is_odd(d))) {
+        if (d == max) {
+          return std::numeric_limits<double>::infinity();
+        }
+        d = next_double(d, 1);
+        if (above == 0) {
+          return d;
+        }
+        continue;
+      }
+      if (d == 0) {
+        return d;
+      }
+      double below = next_double(d, -1);
+      int below_half = compare_halfway(digits, exponent, truncated, below);
+      if (below_half < 0 || (below_half == 0 && !is_odd(below))) {
+        d = below;
+        if (below_half == 0) {
+          return d;
+        }
+        continue;
+      }
+      return d;
+    }
+  }
+
+  /*
+    Compare digits * 10^exponent, plus a little if truncated, with the point
+    halfway between the finite double d >= 0 and the next one
+  */
+  static constexpr int compare_halfway(const big_integer &digits,
+                                       int64_t exponent, bool truncated,
+                                       double d) {
+    uint64_t bits = std::bit_cast<uint64_t>(d);
+    uint64_t biased = bits >> 52;
+    uint64_t m = bits & ((uint64_t(1) << 52) - 1);
+    int64_t e = -1074;
+    if (biased != 0) {
+      m |= uint64_t(1) << 52;
+      e = static_cast<int64_t>(biased) - 1075;
+    }
+    // digits * 5^exponent * 2^exponent against (2m + 1) * 2^(e - 1)
+    big_integer left = digits;
+    big_integer right(2 * m + 1);
+    if (exponent >= 0) {
+      left.multiply_pow5(exponent);
+    } else {
+      right.multiply_pow5(-exponent);
+    }
+    int64_t shift = exponent - (e - 1);
+    if (shift >= 0) {
+      left.shift_left(shift);
+    } else {
+      right.shift_left(-shift);
+    }
+    int res = compare(left, right);
+    return res == 0 && truncated ? 1 : res;
+  }
+
+  static constexpr bool is_odd(double d) {
+    return (std::bit_cast<uint64_t>(d) & 1) != 0;
+  }
+
+  /*
+    Get the next double after the finite d >= 0 in the direction of step
+  */
+  static constexpr double next_double(double d, int step) {
+    uint64_t bits = std::bit_cast<uint64_t>(d);
+    return std::bit_cast<double>(step > 0 ? bits + 1 : bits - 1);
+  }
+
+ private:
+  const char *m_s;
+  size_t m_size;
+  size_t m_index = 0;
+  static_entry *m_entries;  // null when only counting
+  char *m_chars;
+  size_t m_entry_count = 0;
+  size_t m_char_count = 0;
+  parse_error_code m_error = parse_error_code::none;
+  size_t m_error_offset = 0;
+};
+
+/*
+  The storage of the document of a JSON literal, sized by a counting run of
+  the parser
+*/
+template <fixed_string S>
+struct static_document {
+  static constexpr literal_parser measure() {
+    literal_parser parser(S.data, S.size(), nullptr, nullptr);
+    parser.parse();
+    return parser;
+  }
+
+  static constexpr literal_parser measured = measure();
+  static_assert(malformed_json_literal<measured.error(),
+                                       measured.error_offset()>::value);
+  static constexpr size_t entry_count = measured.entry_count();
+  static constexpr size_t char_count = measured.char_count();
+
+  struct storage {
+    static_entry entries[entry_count];
+    char chars[char_count + 1] = {};
+  };
+
+  static constexpr storage build() {
+    storage s{};
+    literal_parser parser(S.data, S.size(), s.entries, s.chars);
+    parser.parse();
+    return s;
+  }
+
+  static constexpr storage data = build();
+};
+}  // namespace detail
+
+/*
+  A read-only value of a document created from a JSON literal. The document
+  lives in static storage, so values can be copied freely and read
+  concurrently; all reads are constexpr. Object members keep their order and
+  are found by a linear search, which suits small embedded documents. A
+  duplicate key is kept, and lookups find its last member as parse() does.
+*/
+class static_json {
+ public:
+  /*
+    Get the JSON value type
+  */
+  constexpr json_value_type get_type() const { return entry().type; }
+
+  /*
+    Get the boolean value
+  */
+  constexpr bool get_boolean() const {
+    expect(json_value_type::boolean, "boolean");
+    return entry().boolean;
+  }
+
+  /*
+    Get the string value
+  */
+  constexpr std::string_view get_string() const {
+    expect(json_value_type::string, "string");
+    return std::string_view(m_chars + entry().str, entry().size);
+  }
+
+  /*
+    Get the integer value
+  */
+  constexpr int64_t get_integer() const {
+    expect(json_value_type::number_int, "integer");
+    return entry().number_int;
+  }
+
+  /*
+    Get the double value
+  */
+  constexpr double get_double() const {
+    expect(json_value_type::number_double, "double");
+    return entry().number_double;
+  }
+
+  /*
+    Get the number of elements/members of an array/object
+  */
+  constexpr size_t size() const {
+    if (!is_container()) {
+      MINIJSON_THROW(json_type_error(
+          "trying to get size of a non-array/object JSON node"));
+    }
+    return entry().size;
+  }
+
+  /*
+    Find the value associated with key in an object. Returns false if the
+    key does not exist.
+  */
+  constexpr bool find(std::string_view key, static_json *result) const {
+    expect(json_value_type::object, "object");
+    bool found = false;
+    size_t child = m_index + 1;
+    for (size_t i = 0; i < entry().size; i++) {
+      const detail::static_entry &e = m_entries[child];
+      if (std::string_view(m_chars + e.key, e.key_size) == key) {
+        *result = static_json(m_entries, m_chars, child);
+        found = true;
+      }
+      child = e.next;
+    }
+    return found;
+  }
+
+  /*
+    Check if an object has the key
+  */
+  constexpr bool contains(std::string_view key) const {
+    static_json v = *this;
+    return find(key, &v);
+  }
+
+  /*
+    Get the value associated with key from an object. It throws
+    std::out_of_range if the key does not exist.
+  */
+  constexpr static_json at(std::string_view key) const {
+    static_json v = *this;
+    if (!find(key, &v)) {
+      MINIJSON_THROW(std::out_of_range("key not found: " + std::string(key)));
+    }
+    return v;
+  }
+  constexpr static_json operator[](std::string_view key) const {
+    return at(key);
+  }
+
+  /*
+    Get the element at index of an array or the member at index of an
+    object. It throws std::out_of_range if the index is invalid.
+  */
+  constexpr static_json at(size_t index) const {
+    return static_json(m_entries, m_chars, child(index));
+  }
+  constexpr static_json operator[](size_t index) const { return at(index); }
+
+  /*
+    Get the key of the member at index of an object
+  */
+  constexpr std::string_view key(size_t index) const {
+    expect(json_value_type::object, "object");
+    const detail::static_entry &e = m_entries[child(index)];
+    return std::string_view(m_chars + e.key, e.key_size);
+  }
+
+  /*
+    Build a JSON node with the same value
+  */
+  template <typename JSONNode = json_node>
+  JSONNode to_json_node() const {
+    using string_t = typename JSONNode::json_string_t;
+    const detail::static_entry &e = entry();
+    switch (e.type) {
+      case json_value_type::boolean:
+        return JSONNode(static_cast<typename JSONNode::json_boolean_t>(
+            e.boolean));
+      case json_value_type::number_int:
+        return JSONNode(
+            static_cast<typename JSONNode::json_int_t>(e.number_int));
+      case json_value_type::number_double:
+        return JSONNode(
+            static_cast<typename JSONNode::json_double_t>(e.number_double));
+      case json_value_type::string:
+        return JSONNode(string_t(m_chars + e.str, e.size));
+      case json_value_type::array: {
+        JSONNode j(json_value_type::array);
+        j.reserve(e.size);
+        for (size_t i = 0, c = m_index + 1; i < e.size;
+             i++, c = m_entries[c].next) {
+          j.push_back(static_json(m_entries, m_chars, c)
+                          .template to_json_node<JSONNode>());
+        }
+        return j;
+      }
+      case json_value_type::object: {
+        JSONNode j(json_value_type::object);
+        j.reserve(e.size);
+        for (size_t i = 0, c = m_index + 1; i < e.size;
+             i++, c = m_entries[c].next) {
+          const detail::static_entry &member = m_entries[c];
+          j.insert(string_t(m_chars + member.key, member.key_size),
+                   static_json(m_entries, m_chars, c)
+                       .template to_json_node<JSONNode>());
+        }
+        return j;
+      }
+      default:
+        return JSONNode();
+    }
+  }
+
+  /*
+    Convert the value into JSON string (Serialization)
+  */
+  std::string to_string(
+      const serialize_options &options = serialize_options()) const {
+    return to_json_node().to_string(options);
+  }
+
+ private:
+  template <detail::fixed_string S>
+  friend constexpr static_json static_parse();
+
+  constexpr static_json(const detail::static_entry *entries,
+                        const char *chars, size_t index)
+      : m_entries(entries), m_chars(chars), m_index(index) {}
+
+  constexpr const detail::static_entry &entry() const {
+    return m_entries[m_index];
+  }
+  constexpr bool is_container() const {
+    return get_type() == json_value_type::array ||
+           get_type() == json_value_type::object;
+  }
+  constexpr void expect(json_value_type type, const char *name) const {
+    if (get_type() != type) {
+      MINIJSON_THROW(json_type_error(std::string("trying to access ") + name +
+                                     " value from a non-" + name +
+                                     " JSON node"));
+    }
+  }
+
+  /*
+    Get the index of the element/member at index of an array/object
+  */
+  constexpr size_t child(size_t index) const {
+    if (!is_container()) {
+      MINIJSON_THROW(json_type_error(
+          "trying to access element of a non-array/object JSON node"));
+    }
+    if (index >= entry().size) {
+      MINIJSON_THROW(std::out_of_range("invalid index"));
+    }
+    size_t c = m_index + 1;
+    for (size_t i = 0; i < index; i++) {
+      c = m_entries[c].next;
+    }
+    return c;
+  }
+
+ private:
+  const detail::static_entry *m_entries;
+  const char *m_chars;  // string values and keys
+  size_t m_index;
+};
+
+/*
+  Get the document of a JSON string given as a template argument, parsed at
+  compile time
+*/
+template <detail::fixed_string S>
+constexpr static_json static_parse() {
+  return static_json(detail::static_document<S>::data.entries,
+                     detail::static_document<S>::data.chars, 0);
+}
+
+namespace literals {
+/*
+  Parse a JSON literal at compile time, e.g. R"({"retries": 3})"_json
+*/
+template <detail::fixed_string S>
+constexpr static_json operator""_json() {
+  return static_parse<S>();
+}
+}  // namespace literals
+}  // namespace miniJSON
+
+#endif
@@ -1,18 +1,42 @@
 // Copyright (c) 2024 Zhichen (Joshua) Wen
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <functional>
 #include <initializer_list>
-#include <sstream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "./detail/canonical.h"
+#include "./detail/diff.h"
+#include "./detail/hash.h"
+#include "./detail/merge.h"
 #include "./detail/ordered_map.h"
 #include "./detail/parser.h"
+#include "./detail/patch.h"
+#include "./detail/reclaimer.h"
+#include "./detail/serializer.h"
+#include "./detail/sha256.h"
+#include "./detail/shared_value.h"
+#include "./detail/small_stack.h"
 #include "./errors.h"
+#include "./field_mask.h"
+#include "./formatter.h"
+#include "./frozen.h"
+#include "./json_path.h"
+#include "./json_schema.h"
+#include "./json_traits.h"
 #include "./json_types.h"
+#include "./options.h"
+#include "./stats.h"
 
 #define MINIJSON_VERSION_MAJOR 0
 #define MINIJSON_VERSION_MINOR 1
@@ -21,188 +45,859 @@
 namespace miniJSON {
 /*
   A JSON node can hold the value of any JSON type
-  (object/array/string/number/boolean/null).
+  (object/array/string/number/boolean/null). The types used to store values
+  and the allocator are given by Traits (see default_json_traits).
 */
-class json_node {
+template <typename Traits>
+class basic_json_node {
  public:
-  json_node() { test_invariant(); }
-  json_node(json_node &&other)
-      : m_value(std::move(other.m_value)), m_type(other.m_type) {
+  using traits_type = Traits;
+  using json_string_t = typename Traits::string_type;
+  using json_object_t =
+      typename Traits::template object_type<json_string_t, basic_json_node *>;
+  using json_array_t = typename Traits::template array_type<basic_json_node *>;
+  using json_int_t = typename Traits::integer_type;
+  using json_double_t = typename Traits::float_type;
+  using json_boolean_t = bool;
+  using allocator_type =
+      typename Traits::template allocator_type<basic_json_node>;
+
+ private:
+  using shared_object_t = detail::shared_value<json_object_t>;
+  using shared_array_t = detail::shared_value<json_array_t>;
+  using shared_string_t = detail::shared_value<json_string_t>;
+
+ public:
+  basic_json_node() { test_invariant(); }
+
+  /*
+    Create a null JSON node whose descendants are allocated with allocator.
+    The nodes added to a document take the allocator of their parent, and
+    parsing into the node with basic_parser builds the document with it.
+  */
+  explicit basic_json_node(const allocator_type &allocator)
+      : m_allocator(allocator) {
+    test_invariant();
+  }
+  basic_json_node(basic_json_node &&other)
+      : m_value(std::move(other.m_value)),
+        m_type(other.m_type),
+        m_number_text(other.m_number_text),
+        m_allocator(other.m_allocator),
+        m_hash(other.m_hash.load(std::memory_order_relaxed)) {
     other.m_value = {};
     other.m_type = json_value_type::null;
+    other.m_number_text = false;
+    other.m_hash.store(0, std::memory_order_relaxed);
     test_invariant();
   }
-  json_node &operator=(json_node &&other) {
+  /*
+    The allocator of a node is never replaced by assignment. A value moved
+    from a node with an unequal allocator is copied, and other is left null.
+  */
+  basic_json_node &operator=(basic_json_node &&other) {
     test_invariant();
-    if (this != &other) {
-      if (m_type == json_value_type::object) {
-        delete_object();
-      }
-      if (m_type == json_value_type::array) {
-        delete_array();
-      }
-      if (m_type == json_value_type::string) {
-        delete_string();
-      }
+    if (this != &other && m_allocator != other.m_allocator) {
+      *this = static_cast<const basic_json_node &>(other);
+      basic_json_node dropped(std::move(other));
+    } else if (this != &other) {
+      release_value();
       m_value = std::move(other.m_value);
       m_type = other.m_type;
+      m_number_text = other.m_number_text;
+      copy_hash(other);
       other.m_value = {};
       other.m_type = json_value_type::null;
+      other.m_number_text = false;
+      other.m_hash.store(0, std::memory_order_relaxed);
     }
     test_invariant();
     return *this;
   }
-  json_node(const json_node &other) : m_type(other.m_type) {
-    if (m_type == json_value_type::object) {
-      m_value.object = new json_object_t(*other.m_value.object);
-      for (auto &key : *other.m_value.object) {
-        (*m_value.object)[key] = new json_node(json_value_type::indeterminate);
-        *(*m_value.object)[key] = *(*other.m_value.object)[key];
-      }
-    } else if (m_type == json_value_type::array) {
-      m_value.array = new json_array_t(*other.m_value.array);
-      for (int i = 0; i < other.m_value.array->size(); i++) {
-        (*m_value.array)[i] = new json_node(json_value_type::indeterminate);
-        *(*m_value.array)[i] = *(*other.m_value.array)[i];
-      }
-    } else if (m_type == json_value_type::string) {
-      m_value.str = new json_string_t(*other.m_value.str);
-    } else {
-      m_value = other.m_value;
-    }
+  basic_json_node(const basic_json_node &other)
+      : m_type(other.m_type),
+        m_number_text(other.m_number_text),
+        m_allocator(std::allocator_traits<allocator_type>::
+                        select_on_container_copy_construction(
+                            other.m_allocator)),
+        m_hash(other.m_hash.load(std::memory_order_relaxed)) {
+    copy_value(other);
     test_invariant();
   }
-  json_node &operator=(const json_node &other) {
+  basic_json_node &operator=(const basic_json_node &other) {
     test_invariant();
     if (this != &other) {
-      if (m_type == json_value_type::object) {
-        delete_object();
-      }
-      if (m_type == json_value_type::array) {
-        delete_array();
-      }
-      if (m_type == json_value_type::string) {
-        delete_string();
-      }
+      release_value();
       m_type = other.m_type;
-      if (m_type == json_value_type::object) {
-        m_value.object = new json_object_t(*other.m_value.object);
-        for (auto &key : *other.m_value.object) {
-          (*m_value.object)[key] =
-              new json_node(json_value_type::indeterminate);
-          *(*m_value.object)[key] = *(*other.m_value.object)[key];
-        }
-      } else if (m_type == json_value_type::array) {
-        m_value.array = new json_array_t(*other.m_value.array);
-        for (int i = 0; i < other.m_value.array->size(); i++) {
-          (*m_value.array)[i] = new json_node(json_value_type::indeterminate);
-          *(*m_value.array)[i] = *(*other.m_value.array)[i];
-        }
-      } else if (m_type == json_value_type::string) {
-        m_value.str = new json_string_t(*other.m_value.str);
-      } else {
-        m_value = other.m_value;
-      }
+      m_number_text = other.m_number_text;
+      copy_hash(other);
+      copy_value(other);
     }
     test_invariant();
     return *this;
   }
-  ~json_node() {
+  ~basic_json_node() {
     test_invariant();
+    release_value();
+  }
+
+  /*
+    Create a copy of the JSON node in O(1) that shares its object/array/string
+    value with this node instead of deep copying it. The shared value is
+    treated as immutable: whichever node modifies it first clones it, along
+    with the path from the node to the modified descendant, so the other
+    owners never observe the modification.
+  */
+  basic_json_node share() const {
+    basic_json_node j(m_allocator);
+    j.m_type = m_type;
+    j.m_value = m_value;
+    j.m_number_text = m_number_text;
+    j.copy_hash(*this);
+    if (m_type == json_value_type::object) {
+      m_value.object->add_ref();
+    } else if (m_type == json_value_type::array) {
+      m_value.array->add_ref();
+    } else if (has_string()) {
+      m_value.str->add_ref();
+    }
+    return j;
+  }
+
+  /*
+    Get the allocator of the JSON node and of its descendants
+  */
+  allocator_type get_allocator() const { return m_allocator; }
+
+  /*
+    Check if the object/array/string value of the JSON node is shared with
+    other JSON nodes
+  */
+  bool is_shared() const {
+    if (m_type == json_value_type::object) {
+      return !m_value.object->unique();
+    }
     if (m_type == json_value_type::array) {
-      delete_array();
-    } else if (m_type == json_value_type::string) {
-      delete_string();
-    } else if (m_type == json_value_type::object) {
-      delete_object();
+      return !m_value.array->unique();
+    }
+    if (has_string()) {
+      return !m_value.str->unique();
+    }
+    return false;
+  }
+
+ private:
+  struct garbage;
+
+  /*
+    Delete an object/array value along with all descendants that do not share
+    their values with other JSON nodes. The tree is walked with an explicit
+    work list instead of recursion so that deleting deep trees cannot overflow
+    the call stack.
+   */
+  static void delete_tree(const garbage &g) {
+    std::vector<basic_json_node *> pending;
+    delete_value(g, &pending);
+    while (!pending.empty()) {
+      basic_json_node *j = pending.back();
+      pending.pop_back();
+      delete_value(garbage{j->m_type, j->m_value, j->m_allocator}, &pending);
+      j->m_type = json_value_type::null;
+      j->m_value = {};
+      destroy_node(j);
+    }
+  }
+
+  /*
+    Delete an object/array value and release its children
+   */
+  static void delete_value(const garbage &g,
+                           std::vector<basic_json_node *> *pending) {
+    if (g.type == json_value_type::object) {
+      g.value.object->for_each_value(
+          [pending](basic_json_node *j) { release_child(j, pending); });
+      destroy(g.value.object, g.allocator);
+    } else {
+      for (basic_json_node *j : *g.value.array) {
+        release_child(j, pending);
+      }
+      destroy(g.value.array, g.allocator);
+    }
+  }
+
+  /*
+    Delete a child node of a deleted tree. A child that was the last owner of
+    an object/array value is queued instead so that delete_tree deletes its
+    descendants.
+   */
+  static void release_child(basic_json_node *j,
+                            std::vector<basic_json_node *> *pending) {
+    bool last_owner;
+    if (j->m_type == json_value_type::object) {
+      last_owner = j->m_value.object->release();
+    } else if (j->m_type == json_value_type::array) {
+      last_owner = j->m_value.array->release();
+    } else {
+      destroy_node(j);
+      return;
+    }
+    if (last_owner) {
+      pending->push_back(j);
+      return;
     }
+    j->m_type = json_value_type::null;
+    j->m_value = {};
+    destroy_node(j);
   }
 
+  /*
+    Give up the ownership of the object/array/string value, deleting it if
+    this node is the last owner. A dropped object/array value is handed to the
+    reclaimer thread if deferred free is enabled.
+   */
+  void release_value() {
+    bool last_owner = false;
+    if (m_type == json_value_type::object) {
+      last_owner = m_value.object->release();
+    } else if (m_type == json_value_type::array) {
+      last_owner = m_value.array->release();
+    } else if (has_string() && m_value.str->release()) {
+      destroy(m_value.str, m_allocator);
+    }
+    if (!last_owner) {
+      return;
+    }
+    garbage g{m_type, m_value, m_allocator};
+    if (reclaimer().running()) {
+      reclaimer().push(g);
+    } else {
+      delete_tree(g);
+    }
+  }
+
+ public:
+  /*
+    Free dropped arrays and objects on a background thread instead of the
+    thread dropping them, keeping deallocation of large documents off the
+    latency critical path. Disabling it waits until all trees handed to the
+    background thread have been freed.
+  */
+  static void set_deferred_free(bool enabled) {
+    if (enabled) {
+      reclaimer().start();
+    } else {
+      reclaimer().stop();
+    }
+  }
+
+  /*
+    Wait until all trees handed to the background thread have been freed
+  */
+  static void flush_deferred_free() { reclaimer().flush(); }
+
  private:
   /*
-    Helper methods to delete JSON nodes of object/array/string types
+    Helper method to deep copy the value of another JSON node of the same
+    type. The descendants are copied with an explicit stack of the
+    arrays/objects being copied instead of recursively, so that copying deep
+    trees cannot overflow the call stack.
    */
+  void copy_value(const basic_json_node &other) {
+    detail::small_stack<copy_frame> frames;
+    copy_shallow(other, &frames);
+    while (!frames.empty()) {
+      copy_frame &f = frames.back();
+      const basic_json_node *src;
+      basic_json_node *child;
+      if (f.src->m_type == json_value_type::array) {
+        if (f.index == f.src->m_value.array->size()) {
+          frames.pop_back();
+          continue;
+        }
+        src = (*f.src->m_value.array)[f.index++];
+        child = create_node();
+        f.dst->m_value.array->push_back(child);
+      } else {
+        if (f.it == f.src->m_value.object->values_end()) {
+          frames.pop_back();
+          continue;
+        }
+        src = *f.it;
+        child = create_node();
+        f.dst->m_value.object->emplace(f.it.key(), child);
+        f.it++;
+      }
+      child->copy_shallow(*src, &frames);
+    }
+  }
+
+  /*
+    An array/object being copied and the position of its next child
+  */
+  struct copy_frame {
+    basic_json_node *dst;
+    const basic_json_node *src;
+    size_t index;
+    typename json_object_t::values_iterator it;
+  };
 
-  void delete_object() {
-    for (auto key : *m_value.object) {
-      delete (*m_value.object)[key];
+  /*
+    Copy the value of another JSON node without its children: an
+    array/object is created empty and pushed to frames to be filled
+   */
+  void copy_shallow(const basic_json_node &other,
+                    detail::small_stack<copy_frame> *frames) {
+    if (other.m_type == json_value_type::object) {
+      m_value.object = create_value<json_object_t>();
+      m_value.object->reserve(other.m_value.object->size());
+      frames->push_back(
+          copy_frame{this, &other, 0, other.m_value.object->values_begin()});
+    } else if (other.m_type == json_value_type::array) {
+      m_value.array = create_value<json_array_t>();
+      m_value.array->reserve(other.m_value.array->size());
+      frames->push_back(copy_frame{this, &other, 0, {}});
+    } else if (other.has_string()) {
+      const json_string_t &str = *other.m_value.str;
+      m_value.str = create_value<json_string_t>(str);
+    } else {
+      m_value = other.m_value;
     }
-    delete m_value.object;
+    m_type = other.m_type;
+    m_number_text = other.m_number_text;
+    copy_hash(other);
   }
-  void delete_array() {
-    for (int i = 0; i < m_value.array->size(); i++) {
-      json_node *j = (*m_value.array)[i];
-      delete j;
+
+  /*
+    Prepare this node for modification: the cached structural hash is dropped
+    and the node is made the only owner of its object/array/string value. A
+    shared value is cloned one level deep: the children of the clone are
+    shared copies of the original children.
+   */
+  void detach() {
+    m_hash.store(0, std::memory_order_relaxed);
+    if (m_type == json_value_type::object && !m_value.object->unique()) {
+      shared_object_t *object = create_value<json_object_t>();
+      object->reserve(m_value.object->size());
+      for (auto &key : *m_value.object) {
+        object->emplace(key, create_node((*m_value.object)[key]->share()));
+      }
+      release_value();
+      m_value.object = object;
+    } else if (m_type == json_value_type::array && !m_value.array->unique()) {
+      shared_array_t *array = create_value<json_array_t>();
+      array->reserve(m_value.array->size());
+      for (auto j : *m_value.array) {
+        array->push_back(create_node(j->share()));
+      }
+      release_value();
+      m_value.array = array;
+    } else if (m_type == json_value_type::string && !m_value.str->unique()) {
+      const json_string_t &str = *m_value.str;
+      shared_string_t *copy = create_value<json_string_t>(str);
+      release_value();
+      m_value.str = copy;
     }
-    delete m_value.array;
   }
-  void delete_string() { delete m_value.str; }
 
  public:
+  /*
+    Create an immutable copy of the JSON node that threads can read
+    concurrently without synchronization
+  */
+  frozen_json freeze() const { return frozen_json(*this); }
+
   /*
     Convert JSON node into JSON string (Serialization)
   */
-  std::string to_string() const {
-    if (m_type == json_value_type::boolean) {
-      return m_value.boolean ? "true" : "false";
+  std::string to_string(
+      const serialize_options &options = serialize_options()) const {
+    MINIJSON_STATS(detail::stats_scope scope(
+        detail::stats_scope::operation::serialize));
+    std::string s;
+    {
+      MINIJSON_STATS(detail::stats_timer timer(&detail::stats().serialize_ns));
+      detail::serializer<basic_json_node>(&s, options).serialize(*this);
     }
-    if (m_type == json_value_type::null) {
-      return "null";
+    MINIJSON_STATS(detail::stats().bytes_serialized += s.size());
+    return s;
+  }
+
+  /*
+    Write the JSON node in the JSON Canonicalization Scheme (RFC 8785) to the
+    sink, in chunks: no whitespace, object members sorted by key, numbers
+    written as ECMAScript doubles (so integers beyond 2^53 are rounded) and
+    strings with minimal escaping. Equal documents are written as the same
+    bytes regardless of member order, number type or locale. NaN and
+    Infinity throw json_type_error.
+  */
+  void to_canonical(
+      const std::function<void(const char *, size_t)> &sink) const {
+    using sink_type = const std::function<void(const char *, size_t)>;
+    detail::canonical_serializer<basic_json_node, sink_type>(&sink).serialize(
+        *this);
+  }
+
+  /*
+    Get the canonical form (RFC 8785) of the JSON node as a string
+  */
+  std::string to_canonical_string() const {
+    std::string s;
+    auto append = [&s](const char *data, size_t size) { s.append(data, size); };
+    detail::canonical_serializer<basic_json_node, decltype(append)>(&append)
+        .serialize(*this);
+    return s;
+  }
+
+  /*
+    Get the SHA-256 digest of the canonical form (RFC 8785) of the JSON node,
+    a content hash to deduplicate and cache documents by. The canonical form
+    is hashed as it is written and never held in memory as a whole.
+  */
+  std::array<uint8_t, 32> content_hash() const {
+    detail::sha256 sha;
+    auto update = [&sha](const char *data, size_t size) {
+      sha.update(data, size);
+    };
+    detail::canonical_serializer<basic_json_node, decltype(update)>(&update)
+        .serialize(*this);
+    return sha.finish();
+  }
+
+
+ public:
+  /*
+    Get the structural hash of the JSON node. Equal JSON values have equal
+    hashes: object members are hashed regardless of their order and integral
+    double numbers hash the same as the equal integers. The hash is cached per
+    node and dropped whenever the node is accessed through a method that can
+    modify it, as every node on the path from the root to a modified
+    descendant is. A reference to a descendant kept across a call to
+    structural_hash() bypasses that path: modify the descendant through the
+    root again, or the cached hashes of its ancestors become stale. Set
+    memoize to false to compute the hash without caching it for the node and
+    its descendants.
+  */
+  size_t structural_hash(bool memoize = true) const {
+    size_t h = cached_hash();
+    if (h != 0) {
+      return h;
     }
-    if (m_type == json_value_type::string) {
-      return '\"' + *m_value.str + '\"';
+    detail::small_stack<hash_frame> frames;
+    const basic_json_node *node = this;
+    for (;;) {
+      h = node->cached_hash();
+      if (h == 0 && (node->m_type == json_value_type::array ||
+                     node->m_type == json_value_type::object)) {
+        hash_frame f{node, 0, 0, {}};
+        if (node->m_type == json_value_type::array) {
+          f.res = static_cast<uint64_t>(node->m_type);
+        } else {
+          f.it = node->m_value.object->values_begin();
+        }
+        frames.push_back(f);
+      } else if (h == 0) {
+        h = node->store_hash(node->scalar_hash(), memoize);
+      }
+      // fold h, the hash of the child just finished (0 for a new frame),
+      // into the innermost array/object until one has a child left
+      for (;;) {
+        if (frames.empty()) {
+          return h;
+        }
+        hash_frame &f = frames.back();
+        if (f.node->m_type == json_value_type::array) {
+          auto &array = *f.node->m_value.array;
+          if (h != 0) {
+            f.res = detail::hash_combine(f.res, h);
+            f.index++;
+          }
+          if (f.index < array.size()) {
+            node = array[f.index];
+            break;
+          }
+        } else {
+          if (h != 0) {
+            f.res += detail::hash_combine(
+                detail::string_hash<json_string_t>()(f.it.key()), h);
+            f.it++;
+          }
+          if (f.it != f.node->m_value.object->values_end()) {
+            node = *f.it;
+            break;
+          }
+          f.res = detail::hash_combine(
+              static_cast<uint64_t>(json_value_type::object), f.res);
+        }
+        h = f.node->store_hash(f.res, memoize);
+        frames.pop_back();
+      }
     }
-    if (m_type == json_value_type::number_int) {
-      return std::to_string(m_value.number_int);
+  }
+
+ private:
+  /*
+    An array/object whose structural hash is being computed: res is the hash
+    of the elements so far, or the sum of the hashes of the members so far
+  */
+  struct hash_frame {
+    const basic_json_node *node;
+    uint64_t res;
+    size_t index;  // next element of an array
+    typename json_object_t::values_iterator it;  // next member of an object
+  };
+
+  /*
+    An array/object being compared with another one of the same type, and
+    the position of their next children
+  */
+  struct compare_frame {
+    const basic_json_node *a;
+    const basic_json_node *b;
+    size_t index;
+    typename json_object_t::values_iterator it;
+  };
+
+  /*
+    An array/object being ordered against another one of the same type. The
+    keys of objects are sorted when they are pushed.
+  */
+  struct order_frame {
+    const basic_json_node *a;
+    const basic_json_node *b;
+    size_t index;
+    std::vector<const json_string_t *> keys;
+    std::vector<const json_string_t *> other_keys;
+  };
+
+  /*
+    Hash a value that is neither an array nor an object
+  */
+  uint64_t scalar_hash() const {
+    uint64_t res = static_cast<uint64_t>(m_type);
+    switch (m_type) {
+      case json_value_type::string:
+        return detail::hash_combine(
+            res, detail::string_hash<json_string_t>()(*m_value.str));
+      case json_value_type::number_int:
+      case json_value_type::number_double:
+        res = m_type == json_value_type::number_int
+                  ? detail::hash_mix(static_cast<uint64_t>(number_int()))
+                  : detail::hash_number(number_double());
+        return detail::hash_combine(
+            static_cast<uint64_t>(json_value_type::number_int), res);
+      case json_value_type::boolean:
+        return detail::hash_combine(res, m_value.boolean);
+      default:
+        return detail::hash_mix(res);
     }
-    if (m_type == json_value_type::number_double) {
-      std::ostringstream sstream;
-      sstream << m_value.number_double;
-      return sstream.str();
+  }
+
+  /*
+    Turn a hash into a structural hash, which is never 0, and cache it for
+    the node
+  */
+  size_t store_hash(uint64_t res, bool memoize) const {
+    size_t h = static_cast<size_t>(res) == 0 ? 1 : static_cast<size_t>(res);
+    if (memoize) {
+      m_hash.store(h, std::memory_order_release);
     }
-    if (m_type == json_value_type::array) {
-      std::string s{"["};
-      for (int i = 0; i < m_value.array->size(); i++) {
-        s += (*m_value.array)[i]->to_string();
-        if (i != m_value.array->size() - 1) {
-          s += ",";
+    return h;
+  }
+
+ public:
+
+  /*
+    Deep equality of JSON values. Object members are compared regardless of
+    their order, and integer and double numbers are equal if they have the
+    same numeric value (1 == 1.0). Nodes sharing the same value or having
+    different cached hashes are decided without a recursive comparison.
+  */
+  friend bool operator==(const basic_json_node &a, const basic_json_node &b) {
+    return a.equals(b);
+  }
+  friend bool operator!=(const basic_json_node &a, const basic_json_node &b) {
+    return !a.equals(b);
+  }
+
+  /*
+    Total ordering of JSON values consistent with equality. Values of
+    different types are ordered by type:
+    null < boolean < number < string < array < object < indeterminate.
+    Arrays are compared lexicographically, objects by their members sorted by
+    key.
+  */
+  friend bool operator<(const basic_json_node &a, const basic_json_node &b) {
+    return a.compare(b) < 0;
+  }
+  friend bool operator>(const basic_json_node &a, const basic_json_node &b) {
+    return a.compare(b) > 0;
+  }
+  friend bool operator<=(const basic_json_node &a, const basic_json_node &b) {
+    return a.compare(b) <= 0;
+  }
+  friend bool operator>=(const basic_json_node &a, const basic_json_node &b) {
+    return a.compare(b) >= 0;
+  }
+
+ private:
+  bool is_number() const {
+    return m_type == json_value_type::number_int ||
+           m_type == json_value_type::number_double;
+  }
+
+  /*
+    Get the cached structural hash, or 0 if it is unset
+  */
+  size_t cached_hash() const { return m_hash.load(std::memory_order_acquire); }
+
+  void copy_hash(const basic_json_node &other) {
+    m_hash.store(other.m_hash.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  }
+
+  /*
+    Deep equality with an explicit stack of the pairs of arrays/objects being
+    compared instead of recursion
+  */
+  bool equals(const basic_json_node &other) const {
+    detail::small_stack<compare_frame> frames;
+    const basic_json_node *a = this;
+    const basic_json_node *b = &other;
+    while (a != nullptr) {
+      if (!equals_value(*a, *b, &frames)) {
+        return false;
+      }
+      a = nullptr;
+      while (a == nullptr && !frames.empty()) {
+        compare_frame &f = frames.back();
+        if (f.a->m_type == json_value_type::array) {
+          if (f.index < f.a->m_value.array->size()) {
+            a = (*f.a->m_value.array)[f.index];
+            b = (*f.b->m_value.array)[f.index++];
+            continue;
+          }
+        } else if (f.it != f.a->m_value.object->values_end()) {
+          auto child = f.b->m_value.object->find(f.it.key());
+          if (child == nullptr) {
+            return false;
+          }
+          a = *f.it++;
+          b = *child;
+          continue;
         }
+        frames.pop_back();
       }
-      s += "]";
-      return s;
     }
-    if (m_type == json_value_type::object) {
-      std::string s{"{"};
-      size_t sz = (*m_value.object).size();
-      int i = 0;
-      for (auto key : *m_value.object) {
-        s += '\"' + key + '\"';
-        s += ":";
-        s += (*m_value.object)[key]->to_string();
-        if (i != sz - 1) {
-          s += ",";
+    return true;
+  }
+
+  /*
+    Compare two values without their children: a pair of non-empty
+    arrays/objects that may be equal is pushed to frames
+  */
+  static bool equals_value(const basic_json_node &a, const basic_json_node &b,
+                           detail::small_stack<compare_frame> *frames) {
+    if (&a == &b) {
+      return true;
+    }
+    if (a.is_number() && b.is_number()) {
+      return a.compare_number(b) == 0;
+    }
+    if (a.m_type != b.m_type) {
+      return false;
+    }
+    size_t h = a.cached_hash();
+    size_t other_h = b.cached_hash();
+    if (h != 0 && other_h != 0 && h != other_h) {
+      return false;
+    }
+    switch (a.m_type) {
+      case json_value_type::object:
+        if (a.m_value.object == b.m_value.object) {
+          return true;
+        }
+        if (a.m_value.object->size() != b.m_value.object->size()) {
+          return false;
+        }
+        frames->push_back(
+            compare_frame{&a, &b, 0, a.m_value.object->values_begin()});
+        return true;
+      case json_value_type::array:
+        if (a.m_value.array == b.m_value.array) {
+          return true;
+        }
+        if (a.m_value.array->size() != b.m_value.array->size()) {
+          return false;
         }
-        i++;
+        frames->push_back(compare_frame{&a, &b, 0, {}});
+        return true;
+      case json_value_type::string:
+        return a.m_value.str == b.m_value.str ||
+               *a.m_value.str == *b.m_value.str;
+      case json_value_type::boolean:
+        return a.m_value.boolean == b.m_value.boolean;
+      default:
+        return true;
+    }
+  }
+
+  /*
+    Total ordering with an explicit stack of the pairs of arrays/objects
+    being compared instead of recursion
+  */
+  int compare(const basic_json_node &other) const {
+    detail::small_stack<order_frame> frames;
+    const basic_json_node *a = this;
+    const basic_json_node *b = &other;
+    while (a != nullptr) {
+      int res = compare_value(*a, *b, &frames);
+      if (res != 0) {
+        return res;
+      }
+      a = nullptr;
+      while (a == nullptr && !frames.empty()) {
+        order_frame &f = frames.back();
+        size_t i = f.index++;
+        if (f.a->m_type == json_value_type::array) {
+          auto &array = *f.a->m_value.array;
+          auto &other_array = *f.b->m_value.array;
+          if (i < array.size() && i < other_array.size()) {
+            a = array[i];
+            b = other_array[i];
+            continue;
+          }
+          res = compare_size(array.size(), other_array.size());
+        } else {
+          if (i < f.keys.size() && i < f.other_keys.size()) {
+            res = f.keys[i]->compare(*f.other_keys[i]);
+            if (res != 0) {
+              return res < 0 ? -1 : 1;
+            }
+            a = *f.a->m_value.object->find(*f.keys[i]);
+            b = *f.b->m_value.object->find(*f.other_keys[i]);
+            continue;
+          }
+          res = compare_size(f.keys.size(), f.other_keys.size());
+        }
+        if (res != 0) {
+          return res;
+        }
+        frames.pop_back();
+      }
+    }
+    return 0;
+  }
+
+  /*
+    Order two values without their children: a pair of arrays/objects is
+    pushed to frames and compared as equal until its children are compared
+  */
+  static int compare_value(const basic_json_node &a, const basic_json_node &b,
+                           detail::small_stack<order_frame> *frames) {
+    if (&a == &b) {
+      return 0;
+    }
+    if (a.is_number() && b.is_number()) {
+      return a.compare_number(b);
+    }
+    if (a.type_rank() != b.type_rank()) {
+      return a.type_rank() < b.type_rank() ? -1 : 1;
+    }
+    switch (a.m_type) {
+      case json_value_type::object:
+        frames->push_back(
+            order_frame{&a, &b, 0, a.sorted_keys(), b.sorted_keys()});
+        return 0;
+      case json_value_type::array:
+        frames->push_back(order_frame{&a, &b, 0, {}, {}});
+        return 0;
+      case json_value_type::string: {
+        int res = a.m_value.str->compare(*b.m_value.str);
+        return res == 0 ? 0 : (res < 0 ? -1 : 1);
       }
-      s += "}";
-      return s;
+      case json_value_type::boolean:
+        return a.m_value.boolean == b.m_value.boolean
+                   ? 0
+                   : (a.m_value.boolean ? 1 : -1);
+      default:
+        return 0;
     }
-    if (m_type == json_value_type::indeterminate) {
-      throw json_type_error(
-          "JSON node has an indeterminate child. Access of the previously "
-          "non-existent element of object or array creates indeterminate "
-          "node.");
+  }
+
+  static int compare_size(size_t a, size_t b) {
+    return a == b ? 0 : (a < b ? -1 : 1);
+  }
+
+  /*
+    Compare numbers exactly, without converting large integers to double
+  */
+  int compare_number(const basic_json_node &other) const {
+    if (m_type == json_value_type::number_int &&
+        other.m_type == json_value_type::number_int) {
+      json_int_t a = number_int();
+      json_int_t b = other.number_int();
+      return a == b ? 0 : (a < b ? -1 : 1);
     }
-    throw json_type_error("invalid type");
+    if (m_type == json_value_type::number_double &&
+        other.m_type == json_value_type::number_double) {
+      json_double_t a = number_double();
+      json_double_t b = other.number_double();
+      return a == b ? 0 : (a < b ? -1 : 1);
+    }
+    if (m_type == json_value_type::number_double) {
+      return -other.compare_number(*this);
+    }
+    json_int_t a = number_int();
+    json_double_t b = other.number_double();
+    // every integer value lies in [-2^(n-1), 2^(n-1)) for n-bit integers
+    const json_double_t limit =
+        -static_cast<json_double_t>(std::numeric_limits<json_int_t>::min());
+    if (b >= limit) {
+      return -1;
+    }
+    if (b < -limit) {
+      return 1;
+    }
+    json_int_t b_integral = static_cast<json_int_t>(b);
+    if (a != b_integral) {
+      return a < b_integral ? -1 : 1;
+    }
+    json_double_t fraction = b - static_cast<json_double_t>(b_integral);
+    return fraction == 0.0 ? 0 : (fraction > 0.0 ? -1 : 1);
   }
 
- public:
-  using json_object_t = ordered_map<std::string, json_node *>;
-  using json_array_t = std::vector<json_node *>;
-  using json_string_t = std::string;
-  using json_int_t = int64_t;
-  using json_double_t = double;
-  using json_boolean_t = bool;
+  int type_rank() const {
+    switch (m_type) {
+      case json_value_type::null:
+        return 0;
+      case json_value_type::boolean:
+        return 1;
+      case json_value_type::number_int:
+      case json_value_type::number_double:
+        return 2;
+      case json_value_type::string:
+        return 3;
+      case json_value_type::array:
+        return 4;
+      case json_value_type::object:
+        return 5;
+      default:
+        return 6;
+    }
+  }
+
+  std::vector<const json_string_t *> sorted_keys() const {
+    std::vector<const json_string_t *> keys;
+    keys.reserve(m_value.object->size());
+    for (auto &key : *m_value.object) {
+      keys.push_back(&key);
+    }
+    std::sort(keys.begin(), keys.end(),
+              [](const json_string_t *a, const json_string_t *b) {
+                return *a < *b;
+              });
+    return keys;
+  }
 
  public:
   /*
@@ -242,7 +937,7 @@ class json_node {
       default:
         break;
     }
-    throw json_type_error("invalid type");
+    MINIJSON_THROW(json_type_error("invalid type"));
   }
 
   /*
@@ -252,8 +947,8 @@ class json_node {
     if (m_type == json_value_type::boolean) {
       return m_value.boolean;
     }
-    throw json_type_error(
-        "trying to access boolean value from a non-boolean JSON node");
+    MINIJSON_THROW(json_type_error(
+        "trying to access boolean value from a non-boolean JSON node"));
   }
 
   /*
@@ -263,8 +958,8 @@ class json_node {
     if (m_type == json_value_type::string) {
       return *m_value.str;
     }
-    throw json_type_error(
-        "trying to access string value from a non-string JSON node");
+    MINIJSON_THROW(json_type_error(
+        "trying to access string value from a non-string JSON node"));
   }
 
   /*
@@ -272,10 +967,10 @@ class json_node {
   */
   const json_int_t get_integer() const {
     if (m_type == json_value_type::number_int) {
-      return m_value.number_int;
+      return number_int();
     }
-    throw json_type_error(
-        "trying to access integer value from a non-integer JSON node");
+    MINIJSON_THROW(json_type_error(
+        "trying to access integer value from a non-integer JSON node"));
   }
 
   /*
@@ -283,55 +978,126 @@ class json_node {
   */
   const json_double_t get_double() const {
     if (m_type == json_value_type::number_double) {
-      return m_value.number_double;
+      return number_double();
+    }
+    MINIJSON_THROW(json_type_error(
+        "trying to access double value from a non-double JSON node"));
+  }
+
+  /*
+    Get the decimal text of the current number value: the text in the parsed
+    JSON string if it was parsed with lazy_numbers, or else the text that
+    to_string() writes
+  */
+  json_string_t get_number_text() const {
+    if (m_number_text) {
+      return *m_value.str;
+    }
+    if (!is_number()) {
+      MINIJSON_THROW(json_type_error(
+          "trying to access number text from a non-number JSON node"));
     }
-    throw json_type_error(
-        "trying to access double value from a non-double JSON node");
+    std::string s;
+    detail::serializer<basic_json_node>::write_number(*this, &s);
+    return json_string_t(s.data(), s.size());
   }
 
   /*
-    Get value associated with key from object
+    Get value associated with key from object, adding an indeterminate value
+    if the key does not exist
   */
-  json_node &operator[](json_string_t key) const {
+  basic_json_node &operator[](json_string_t key) {
     if (m_type == json_value_type::object) {
+      detach();
       if (m_value.object->count(key) == 0) {
-        (*m_value.object)[key] = new json_node(json_value_type::indeterminate);
+        (*m_value.object)[key] = create_node(json_value_type::indeterminate);
       }
       auto val = (*m_value.object)[key];
       return *val;
     }
-    throw json_type_error(
-        "trying to access object value from a non-object JSON node");
+    MINIJSON_THROW(json_type_error(
+        "trying to access object value from a non-object JSON node"));
   }
 
   /*
-    Get value at index from array
+    Get value at index from array, padding the array with indeterminate values
+    up to the index
   */
-  json_node &operator[](size_t index) const {
+  basic_json_node &operator[](size_t index) {
     if (m_type == json_value_type::array) {
       if (index < 0) {
-        throw std::out_of_range("invalid negative index value");
+        MINIJSON_THROW(std::out_of_range("invalid negative index value"));
       }
+      detach();
       if ((index >= m_value.array->size())) {
-        m_value.array->resize(index + 1);
-        (*m_value.array)[index] = new json_node(json_value_type::indeterminate);
+        // every slot up to index must hold a node, not only the last one
+        while (m_value.array->size() <= index) {
+          m_value.array->push_back(
+              create_node(json_value_type::indeterminate));
+        }
       }
       auto val = (*m_value.array)[index];
       return *val;
     }
-    throw json_type_error(
-        "trying to access array value from a non-array JSON node");
+    MINIJSON_THROW(json_type_error(
+        "trying to access array value from a non-array JSON node"));
+  }
+
+  /*
+    Get value associated with key from a const object. The value stays shared
+    with its copies; it throws std::out_of_range if the key does not exist.
+  */
+  const basic_json_node &operator[](const json_string_t &key) const {
+    return at(key);
+  }
+
+  /*
+    Get value at index from a const array. The value stays shared with its
+    copies; it throws std::out_of_range if the index is invalid.
+  */
+  const basic_json_node &operator[](size_t index) const { return at(index); }
+
+  /*
+    Get value associated with key from object without modifying the node. It
+    throws std::out_of_range if the key does not exist.
+  */
+  const basic_json_node &at(const json_string_t &key) const {
+    if (m_type == json_value_type::object) {
+      auto val = m_value.object->find(key);
+      if (val == nullptr) {
+        MINIJSON_THROW(std::out_of_range(
+            std::string("key not found: ").append(key.data(), key.size())));
+      }
+      return **val;
+    }
+    MINIJSON_THROW(json_type_error(
+        "trying to access object value from a non-object JSON node"));
+  }
+
+  /*
+    Get value at index from array without modifying the node. It throws
+    std::out_of_range if the index is invalid.
+  */
+  const basic_json_node &at(size_t index) const {
+    if (m_type == json_value_type::array) {
+      if (index >= m_value.array->size()) {
+        MINIJSON_THROW(std::out_of_range("invalid index"));
+      }
+      return *(*m_value.array)[index];
+    }
+    MINIJSON_THROW(json_type_error(
+        "trying to access array value from a non-array JSON node"));
   }
 
  public:
   struct iterator {
     using iterator_category = std::forward_iterator_tag;
     using difference_type = std::ptrdiff_t;
-    using value_type = const json_node &;
-    using pointer = json_node *;
-    using reference = json_node &;
-    iterator(pointer ptr, json_array_t::iterator array_iterator = {},
-             json_object_t::values_iterator object_iterator = {})
+    using value_type = const basic_json_node &;
+    using pointer = basic_json_node *;
+    using reference = basic_json_node &;
+    iterator(pointer ptr, typename json_array_t::iterator array_iterator = {},
+             typename json_object_t::values_iterator object_iterator = {})
         : m_ptr(ptr),
           m_array_iterator(array_iterator),
           m_object_iterator(object_iterator) {}
@@ -341,8 +1107,8 @@ class json_node {
       } else if (m_ptr->m_type == json_value_type::object) {
         return *(*m_object_iterator);
       }
-      throw json_type_error(
-          "json_node iterator not supported for non object or array types");
+      MINIJSON_THROW(json_type_error(
+          "json_node iterator not supported for non object or array types"));
     }
     pointer operator->() {
       if (m_ptr->m_type == json_value_type::array) {
@@ -350,12 +1116,11 @@ class json_node {
       } else if (m_ptr->m_type == json_value_type::object) {
         return *m_object_iterator;
       }
-      throw json_type_error(
-          "json_node iterator not supported for non object or array types");
+      MINIJSON_THROW(json_type_error(
+          "json_node iterator not supported for non object or array types"));
     }
 
     iterator &operator++() {
-      auto j = *m_ptr;
       if (m_ptr->m_type == json_value_type::array) {
         m_array_iterator++;
       } else if (m_ptr->m_type == json_value_type::object) {
@@ -386,41 +1151,43 @@ class json_node {
       if (m_ptr->m_type == json_value_type::object) {
         return m_object_iterator.key();
       }
-      throw json_type_error(
-          "iterator::key() is only supported for object type");
+      MINIJSON_THROW(json_type_error(
+          "iterator::key() is only supported for object type"));
     }
     pointer value() {
       if (m_ptr->m_type == json_value_type::object) {
         return m_object_iterator.value();
       }
-      throw json_type_error(
-          "iterator::value() is only supported for object type");
+      MINIJSON_THROW(json_type_error(
+          "iterator::value() is only supported for object type"));
     }
 
    private:
     pointer m_ptr;
-    json_array_t::iterator m_array_iterator;
-    json_object_t::values_iterator m_object_iterator;
+    typename json_array_t::iterator m_array_iterator;
+    typename json_object_t::values_iterator m_object_iterator;
   };
 
   iterator begin() {
+    detach();
     if (m_type == json_value_type::array) {
       return iterator(this, m_value.array->begin());
     } else if (m_type == json_value_type::object) {
       return iterator(this, {}, m_value.object->values_begin());
     }
-    throw json_type_error(
-        "json_node iterator not supported for non object or array types");
+    MINIJSON_THROW(json_type_error(
+        "json_node iterator not supported for non object or array types"));
     return iterator(nullptr);
   }
   iterator end() {
+    detach();
     if (m_type == json_value_type::array) {
       return iterator(this, m_value.array->end());
     } else if (m_type == json_value_type::object) {
       return iterator(this, {}, m_value.object->values_end());
     }
-    throw json_type_error(
-        "json_node iterator not supported for non object or array types");
+    MINIJSON_THROW(json_type_error(
+        "json_node iterator not supported for non object or array types"));
     return iterator(nullptr);
   }
 
@@ -429,10 +1196,10 @@ class json_node {
     List of convenient constructors
   */
 
-  json_node(json_value_type t) : m_type(t) {
+  basic_json_node(json_value_type t) : m_type(t) {
     switch (t) {
       case json_value_type::string:
-        m_value.str = new json_string_t;
+        m_value.str = create_value<json_string_t>();
         break;
       case json_value_type::boolean:
         m_value.boolean = true;
@@ -444,10 +1211,10 @@ class json_node {
         m_value.number_double = 0.0;
         break;
       case json_value_type::object:
-        m_value.object = new json_object_t;
+        m_value.object = create_value<json_object_t>();
         break;
       case json_value_type::array:
-        m_value.array = new json_array_t;
+        m_value.array = create_value<json_array_t>();
         break;
       case json_value_type::null:
         break;
@@ -458,96 +1225,317 @@ class json_node {
     }
     test_invariant();
   }
-  json_node(json_boolean_t b) {
+  basic_json_node(json_boolean_t b) {
     m_value.boolean = b;
     m_type = json_value_type::boolean;
     test_invariant();
   }
-  json_node(json_int_t num) {
+  basic_json_node(json_int_t num) {
     m_value.number_int = num;
     m_type = json_value_type::number_int;
     test_invariant();
   }
-  json_node(int num) {
+  template <typename T = json_int_t,
+            typename std::enable_if<!std::is_same<T, int>::value,
+                                    int>::type = 0>
+  basic_json_node(int num) {
     m_value.number_int = num;
     m_type = json_value_type::number_int;
     test_invariant();
   }
-  json_node(json_double_t num) {
+  basic_json_node(json_double_t num) {
     m_value.number_double = num;
     m_type = json_value_type::number_double;
     test_invariant();
   }
-  json_node(const char *s) {
-    m_value.str = new std::string(s);
+  template <typename T = json_double_t,
+            typename std::enable_if<!std::is_same<T, double>::value,
+                                    int>::type = 0>
+  basic_json_node(double num) {
+    m_value.number_double = static_cast<json_double_t>(num);
+    m_type = json_value_type::number_double;
+    test_invariant();
+  }
+  basic_json_node(const char *s) {
+    m_value.str = create_value<json_string_t>(s);
     m_type = json_value_type::string;
     test_invariant();
   }
-  json_node(const json_string_t &s) {
-    m_value.str = new std::string(s);
+  basic_json_node(const json_string_t &s) {
+    m_value.str = create_value<json_string_t>(s);
     m_type = json_value_type::string;
     test_invariant();
   }
-  json_node(std::nullptr_t n) { test_invariant(); }
-  json_node(std::initializer_list<json_node> l) {
+  basic_json_node(std::nullptr_t n) { test_invariant(); }
+  basic_json_node(std::initializer_list<basic_json_node> l) {
     bool is_object = is_initializer_object(l);
     size_t sz = l.size();
     if (is_object) {
       m_type = json_value_type::object;
-      m_value.object = new json_object_t;
+      m_value.object = create_value<json_object_t>();
+      m_value.object->reserve(sz);
       for (auto it = l.begin(); it != l.end(); it++) {
-        const std::string &key = (*(it->m_value.array))[0]->get_string();
-        json_node *value = (*(it->m_value.array))[1];
-        (*m_value.object)[key] = new json_node(json_value_type::indeterminate);
-        *(*m_value.object)[key] = *value;
+        const json_string_t &key = *(*(it->m_value.array))[0]->m_value.str;
+        const basic_json_node &value = *(*(it->m_value.array))[1];
+        insert(key, value);
       }
     } else {
       m_type = json_value_type::array;
-      m_value.array = new json_array_t(sz);
-      for (int i = 0; i < sz; i++) {
-        (*m_value.array)[i] = new json_node(json_value_type::indeterminate);
-      }
-      size_t idx = 0;
-      for (auto it = l.begin(); it != l.end(); idx++) {
-        *(*m_value.array)[idx] = *it;
-        it++;
+      m_value.array = create_value<json_array_t>();
+      m_value.array->reserve(sz);
+      for (auto it = l.begin(); it != l.end(); it++) {
+        push_back(*it);
       }
     }
     test_invariant();
   }
 
+
+ public:
+  /*
+    Builder methods for JSON of array type. A null or indeterminate node is
+    turned into an empty array first. Values passed as rvalue are moved into
+    the array instead of being deep-copied.
+  */
+  void push_back(basic_json_node &&value) { emplace_back(std::move(value)); }
+  void push_back(const basic_json_node &value) { emplace_back(value); }
+  template <typename... Args>
+  basic_json_node &emplace_back(Args &&...args) {
+    prepare_container(json_value_type::array);
+    detach();
+    node_ptr node(create_node(std::forward<Args>(args)...));
+    m_value.array->push_back(node.get());
+    return *node.release();
+  }
+
+  /*
+    Builder methods for JSON of object type. A null or indeterminate node is
+    turned into an empty object first. The value replaces any existing value
+    stored under the same key.
+  */
+  basic_json_node &insert(const json_string_t &key, basic_json_node &&value) {
+    return emplace(key, std::move(value));
+  }
+  basic_json_node &insert(const json_string_t &key,
+                          const basic_json_node &value) {
+    return emplace(key, value);
+  }
+  template <typename... Args>
+  basic_json_node &emplace(const json_string_t &key, Args &&...args) {
+    prepare_container(json_value_type::object);
+    detach();
+    node_ptr node(create_node(std::forward<Args>(args)...));
+    auto res = m_value.object->emplace(key, node.get());
+    if (!res.second) {
+      destroy_node(*res.first);  // free the json node about to be replaced
+      *res.first = node.get();
+    }
+    return *node.release();
+  }
+
+  /*
+    Reserve storage for n elements of JSON of object or array type
+  */
+  void reserve(size_t n) {
+    detach();
+    if (m_type == json_value_type::array) {
+      m_value.array->reserve(n);
+      return;
+    }
+    if (m_type == json_value_type::object) {
+      m_value.object->reserve(n);
+      return;
+    }
+    MINIJSON_THROW(json_type_error(
+        "trying to reserve storage for a non-object or non-array JSON node"));
+  }
+
+ private:
+  /*
+    Make sure the current node is a container of the given type. Null and
+    indeterminate nodes are initialized as an empty container.
+   */
+  void prepare_container(json_value_type t) {
+    if (m_type == json_value_type::null ||
+        m_type == json_value_type::indeterminate) {
+      t == json_value_type::array ? set_array() : set_object();
+    }
+    if (m_type == t) {
+      return;
+    }
+    if (t == json_value_type::array) {
+      MINIJSON_THROW(
+          json_type_error("trying to add value to a non-array JSON node"));
+    }
+    MINIJSON_THROW(
+        json_type_error("trying to add key-pair to a non-object JSON node"));
+  }
+
  public:
   /*
     delete methods for JSON of object or array type
   */
-  size_t erase(const std::string &key) {
+  size_t erase(const json_string_t &key) {
     if (m_type == json_value_type::object) {
+      detach();
       if (m_value.object->count(key) == 0) {
         return 0;
       }
-      delete (*m_value.object)[key];  // free the json node about to be deleted
+      // free the json node about to be deleted
+      destroy_node((*m_value.object)[key]);
       return m_value.object->erase(key);
     }
-    throw json_type_error(
-        "trying to delete key-pair from a non-object JSON node");
+    MINIJSON_THROW(json_type_error(
+        "trying to delete key-pair from a non-object JSON node"));
   }
-  json_array_t::iterator erase(size_t index) {
+  typename json_array_t::iterator erase(size_t index) {
     if (m_type == json_value_type::array) {
       if (index >= m_value.array->size()) {
-        throw std::out_of_range("invalid index");
+        MINIJSON_THROW(std::out_of_range("invalid index"));
       }
-      delete *(m_value.array->begin() +
-               index);  // free the json node about to be deleted
+      detach();
+      // free the json node about to be deleted
+      destroy_node(*(m_value.array->begin() + index));
       return m_value.array->erase(m_value.array->begin() + index);
     }
-    throw json_type_error("trying to delete value from a non-array JSON node");
+    MINIJSON_THROW(
+        json_type_error("trying to delete value from a non-array JSON node"));
+  }
+
+  /*
+    Remove a member from object or an element from array and return its
+    value. The value is moved out, so none of its descendants are copied. It
+    throws std::out_of_range if the key or the index does not exist.
+  */
+  basic_json_node extract(const json_string_t &key) {
+    node_ptr node(take_member(key));
+    return std::move(*node);
+  }
+  basic_json_node extract(size_t index) {
+    node_ptr node(take_element(index));
+    return std::move(*node);
+  }
+
+  /*
+    Move the member other_key of other into this object under key, replacing
+    any member stored under the same key. The node holding the value changes
+    hands, so no JSON node is copied or allocated; other may be another
+    document, whose value is copied only if its allocator is unequal.
+    A null or indeterminate node is turned into an empty object first. The
+    moved value must not contain this node.
+  */
+  void splice(const json_string_t &key, basic_json_node &other,
+              const json_string_t &other_key) {
+    prepare_container(json_value_type::object);
+    basic_json_node *node = adopt(other.take_member(other_key));
+    detach();
+    auto res = m_value.object->emplace(key, node);
+    if (!res.second) {
+      destroy_node(*res.first);
+      *res.first = node;
+    }
+  }
+
+  /*
+    Move the element index of other into this array so that it ends up at
+    position pos. The node holding the value changes hands, so no JSON node
+    is copied or allocated unless other has an unequal allocator. A null or
+    indeterminate node is turned into an empty array first. The moved value
+    must not contain this node.
+  */
+  void splice(size_t pos, basic_json_node &other, size_t index) {
+    prepare_container(json_value_type::array);
+    size_t size = m_value.array->size() - (this == &other ? 1 : 0);
+    if (pos > size) {
+      MINIJSON_THROW(std::out_of_range("invalid index"));
+    }
+    basic_json_node *node = adopt(other.take_element(index));
+    detach();
+    m_value.array->insert(m_value.array->begin() + pos, node);
+  }
+
+ private:
+  /*
+    Unlink the node of a member/element; the caller becomes its owner
+  */
+  basic_json_node *take_member(const json_string_t &key) {
+    if (m_type != json_value_type::object) {
+      MINIJSON_THROW(json_type_error(
+          "trying to extract key-pair from a non-object JSON node"));
+    }
+    if (m_value.object->find(key) == nullptr) {
+      MINIJSON_THROW(std::out_of_range(
+          std::string("key not found: ").append(key.data(), key.size())));
+    }
+    detach();
+    basic_json_node *node = *m_value.object->find(key);
+    m_value.object->erase(key);
+    return node;
+  }
+  basic_json_node *take_element(size_t index) {
+    if (m_type != json_value_type::array) {
+      MINIJSON_THROW(json_type_error(
+          "trying to extract value from a non-array JSON node"));
+    }
+    if (index >= m_value.array->size()) {
+      MINIJSON_THROW(std::out_of_range("invalid index"));
+    }
+    detach();
+    basic_json_node *node = (*m_value.array)[index];
+    m_value.array->erase(m_value.array->begin() + index);
+    return node;
+  }
+
+ public:
+  /*
+    Apply JSON Patch (RFC 6902) document in place. The patch is atomic: if one
+    of its operations fails, json_patch_error is thrown and the node is left
+    unchanged. Values of a patch passed as rvalue are moved instead of copied.
+  */
+  void apply_patch(basic_json_node &&patch) {
+    detail::patcher<basic_json_node>(this).apply_patch(&patch);
+  }
+  void apply_patch(const basic_json_node &patch) { apply_patch(patch.share()); }
+  void apply_patch(const std::string &patch);
+  void apply_patch(const char *patch) { apply_patch(std::string(patch)); }
+
+  /*
+    Apply JSON Merge Patch (RFC 7396) document in place. Values of a patch
+    passed as rvalue are moved instead of copied.
+  */
+  void apply_merge_patch(basic_json_node &&patch) {
+    detail::patcher<basic_json_node>(this).apply_merge_patch(&patch);
+  }
+  void apply_merge_patch(const basic_json_node &patch) {
+    apply_merge_patch(patch.share());
+  }
+  void apply_merge_patch(const std::string &patch);
+  void apply_merge_patch(const char *patch) {
+    apply_merge_patch(std::string(patch));
+  }
+
+  /*
+    Deep merge other into this node: objects are merged member by member,
+    arrays are replaced or concatenated and other values conflict, as chosen
+    by options. A null value in this node is replaced as if it were absent;
+    unlike JSON Merge Patch, a null in other is a value like any other.
+    Members and elements of other passed as rvalue are moved instead of
+    copied, so none of their descendants are copied.
+  */
+  void merge(basic_json_node &&other,
+             const merge_options &options = merge_options()) {
+    detail::merger<basic_json_node>(options).merge(this, &other);
+  }
+  void merge(const basic_json_node &other,
+             const merge_options &options = merge_options()) {
+    merge(other.share(), options);
   }
 
  private:
   /*
     Check if the initializer list contains an JSON of object type
   */
-  bool is_initializer_object(const std::initializer_list<json_node> &l) {
+  bool is_initializer_object(const std::initializer_list<basic_json_node> &l) {
     bool is_object = true;
     for (auto it = l.begin(); it != l.end(); it++) {
       if (it->m_type != json_value_type::array) {
@@ -578,14 +1566,14 @@ class json_node {
     Initialize the current array value
    */
   void set_array() {
-    m_value.array = new json_array_t;
+    m_value.array = create_value<json_array_t>();
     m_type = json_value_type::array;
   }
   /*
     Initialize the current string value
    */
   void set_string() {
-    m_value.str = new json_string_t;
+    m_value.str = create_value<json_string_t>();
     m_type = json_value_type::string;
   }
   /*
@@ -602,16 +1590,63 @@ class json_node {
     m_value.number_double = d;
     m_type = json_value_type::number_double;
   }
+  /*
+    Initialize the current number value with its text, which is converted
+    whenever the value is read
+   */
+  void set_number_text(const char *begin, const char *end, bool is_integer) {
+    m_value.str =
+        create_value<json_string_t>(begin, static_cast<size_t>(end - begin));
+    m_type = is_integer ? json_value_type::number_int
+                        : json_value_type::number_double;
+    m_number_text = true;
+  }
+
+  /*
+    Check if the node owns a string value: a string, or the text of a number
+   */
+  bool has_string() const {
+    return m_type == json_value_type::string || m_number_text;
+  }
+
+  json_int_t number_int() const {
+    if (!m_number_text) {
+      return m_value.number_int;
+    }
+    const json_string_t &text = *m_value.str;
+    return detail::convert_integer<json_int_t>(text.data(),
+                                               text.data() + text.size());
+  }
+
+  json_double_t number_double() const {
+    if (!m_number_text) {
+      return m_value.number_double;
+    }
+    const json_string_t &text = *m_value.str;
+    double d = 0;
+    parse_error_code error;
+    detail::scan_number(text.data(), text.data() + text.size(), &d, &error);
+    return static_cast<json_double_t>(d);
+  }
   /*
     Initialize the current object value
    */
   void set_object() {
-    m_value.object = new json_object_t;
+    m_value.object = create_value<json_object_t>();
     m_type = json_value_type::object;
   }
 
  public:
-  friend class detail::parser<json_node>;
+  friend class detail::parser<basic_json_node>;
+  friend class detail::patcher<basic_json_node>;
+  friend class detail::path_evaluator<basic_json_node>;
+  friend class detail::schema_program<basic_json_node>;
+  friend class detail::differ<basic_json_node>;
+  friend class detail::merger<basic_json_node>;
+  friend class detail::serializer<basic_json_node>;
+  template <typename, typename>
+  friend class detail::canonical_serializer;
+  friend class frozen_json;
 
  private:
   /*
@@ -625,9 +1660,9 @@ class json_node {
     - null
   */
   union json_value {
-    json_object_t *object;
-    json_array_t *array;
-    json_string_t *str;
+    shared_object_t *object;
+    shared_array_t *array;
+    shared_string_t *str;
     json_int_t number_int;
     json_double_t number_double;
     json_boolean_t boolean;
@@ -638,6 +1673,126 @@ class json_node {
     json_value &operator=(json_value &&other) = default;
   };
 
+  /*
+    An object/array value that is no longer owned by any JSON node
+   */
+  struct garbage {
+    json_value_type type;
+    json_value value;
+    allocator_type allocator;  // of the value
+  };
+
+  /*
+    Reclaimer deleting dropped object/array values in the background when
+    deferred free is enabled. It is never destroyed so that JSON nodes can
+    still be released during static destruction.
+   */
+  static detail::reclaimer<garbage> &reclaimer() {
+    static auto *instance = new detail::reclaimer<garbage>(&delete_tree);
+    return *instance;
+  }
+
+ private:
+  /*
+    Allocate and construct a JSON node or an object/array/string value with
+    the allocator of this node, rebound to T
+   */
+  template <typename T, typename... Args>
+  T *create(Args &&...args) const {
+    using allocator_t = typename Traits::template allocator_type<T>;
+    using alloc_traits = std::allocator_traits<allocator_t>;
+    allocator_t allocator(m_allocator);
+    T *p = alloc_traits::allocate(allocator, 1);
+    MINIJSON_STATS(detail::record_allocation(sizeof(T)));
+    struct guard {
+      allocator_t &allocator;
+      T *p;
+      ~guard() {
+        if (p != nullptr) {
+          alloc_traits::deallocate(allocator, p, 1);
+        }
+      }
+    } g{allocator, p};  // frees the memory if the constructor throws
+    alloc_traits::construct(allocator, p, std::forward<Args>(args)...);
+    g.p = nullptr;
+    return p;
+  }
+
+  /*
+    Destroy and deallocate what create() returned with an allocator equal to
+    node_allocator. Null is ignored.
+   */
+  template <typename T>
+  static void destroy(T *p, const allocator_type &node_allocator) {
+    using allocator_t = typename Traits::template allocator_type<T>;
+    using alloc_traits = std::allocator_traits<allocator_t>;
+    if (p == nullptr) {
+      return;
+    }
+    allocator_t allocator(node_allocator);
+    alloc_traits::destroy(allocator, p);
+    alloc_traits::deallocate(allocator, p, 1);
+  }
+
+  /*
+    Create an object/array/string value. The container is constructed with
+    the allocator of this node if it accepts it (std::uses_allocator), so
+    that its storage comes from the same allocator as the nodes.
+   */
+  template <typename T, typename... Args>
+  detail::shared_value<T> *create_value(Args &&...args) const {
+    return create_container<T>(std::uses_allocator<T, allocator_type>(),
+                               std::forward<Args>(args)...);
+  }
+  template <typename T, typename... Args>
+  detail::shared_value<T> *create_container(std::true_type,
+                                            Args &&...args) const {
+    return create<detail::shared_value<T>>(std::forward<Args>(args)...,
+                                           m_allocator);
+  }
+  template <typename T, typename... Args>
+  detail::shared_value<T> *create_container(std::false_type,
+                                            Args &&...args) const {
+    return create<detail::shared_value<T>>(std::forward<Args>(args)...);
+  }
+
+  /*
+    Create a child node, which takes the allocator of this node. A value
+    given with a node of an unequal allocator is copied into the new node.
+   */
+  basic_json_node *create_node() const {
+    return create<basic_json_node>(m_allocator);
+  }
+  template <typename... Args>
+  basic_json_node *create_node(Args &&...args) const {
+    node_ptr node(create_node());
+    *node = basic_json_node(std::forward<Args>(args)...);
+    return node.release();
+  }
+  static void destroy_node(basic_json_node *j) {
+    if (j != nullptr) {
+      allocator_type allocator(j->m_allocator);
+      destroy(j, allocator);
+    }
+  }
+
+  /*
+    Take the ownership of a node unlinked from another document. A node of
+    an unequal allocator is replaced by a copy made with this node's one.
+   */
+  basic_json_node *adopt(basic_json_node *node) const {
+    if (node->m_allocator == m_allocator) {
+      return node;
+    }
+    node_ptr other(node);
+    return create_node(std::move(*node));
+  }
+
+  struct node_deleter {
+    void operator()(basic_json_node *j) const { destroy_node(j); }
+  };
+  using node_ptr = std::unique_ptr<basic_json_node, node_deleter>;
+
  private:
   void test_invariant() const {
     if (m_type == json_value_type::array) {
@@ -646,7 +1801,7 @@ class json_node {
     if (m_type == json_value_type::object) {
       assert(m_value.object != nullptr);
     }
-    if (m_type == json_value_type::string) {
+    if (has_string()) {
       assert(m_value.str != nullptr);
     }
   }
@@ -654,16 +1809,307 @@ class json_node {
  private:
   json_value m_value = {};
   json_value_type m_type = json_value_type::null;
+  bool m_number_text = false;  // the number is kept as text in m_value.str
+  allocator_type m_allocator;  // of the values and the children of the node
+  mutable std::atomic<size_t> m_hash{0};  // cached structural hash, 0 if unset
+};
+
+/*
+  The JSON node with the default traits
+*/
+using json_node = basic_json_node<default_json_traits>;
+
+/*
+  A parser that can parse many JSON strings in a row. Its internal stack and
+  scratch buffers are kept between calls, so parsing a stream of similar
+  documents allocates nothing but the JSON nodes themselves once the buffers
+  have grown large enough. A parser must not be used by several threads at
+  the same time.
+*/
+template <typename JSONNode>
+class basic_parser {
+ public:
+  explicit basic_parser(const parse_options &options = parse_options())
+      : m_options(options) {}
+
+  /*
+    Parse JSON string into JSON node without throwing exceptions on invalid
+    input. The returned result holds the kind of error and its byte offset;
+    result is only assigned if parsing succeeds. The document is built with
+    the allocator of result.
+  */
+  parse_result parse(const std::string &s, JSONNode *result) {
+    JSONNode j(result->get_allocator());
+    parse_result res = m_parser.parse(s, &j, m_options);
+    if (res) {
+      *result = std::move(j);
+    }
+    return res;
+  }
+
+  /*
+    Parse JSON string into JSON node. It will throw json_parse_error if the
+    JSON string format is invalid.
+  */
+  JSONNode parse(const std::string &s) {
+    JSONNode j;
+    parse_result res = parse(s, &j);
+    if (!res) {
+      MINIJSON_THROW(json_parse_error(res));
+    }
+    return j;
+  }
+
+  /*
+    Parse JSON string into JSON node, building only the fields selected by
+    the mask, without throwing exceptions on invalid input
+  */
+  parse_result parse(const std::string &s, const field_mask &mask,
+                     JSONNode *result) {
+    JSONNode j(result->get_allocator());
+    parse_result res = m_parser.parse(s, mask, &j, m_options);
+    if (res) {
+      *result = std::move(j);
+    }
+    return res;
+  }
+
+  /*
+    Parse JSON string into JSON node, building only the fields selected by
+    the mask. It will throw json_parse_error if the JSON string format is
+    invalid, including in the skipped parts.
+  */
+  JSONNode parse(const std::string &s, const field_mask &mask) {
+    JSONNode j;
+    parse_result res = parse(s, mask, &j);
+    if (!res) {
+      MINIJSON_THROW(json_parse_error(res));
+    }
+    return j;
+  }
+
+  /*
+    Parse JSON string into JSON node and validate it against the schema while
+    parsing, without throwing exceptions on invalid input. A violation is
+    reported as parse_error_code::schema_violation at the offset of the
+    rejected value, or of the key of a member that the schema does not allow.
+  */
+  parse_result parse(const std::string &s,
+                     const basic_json_schema<JSONNode> &schema,
+                     JSONNode *result) {
+    JSONNode j(result->get_allocator());
+    parse_result res = m_parser.parse(s, schema.m_program, &j, m_options);
+    if (res) {
+      *result = std::move(j);
+    }
+    return res;
+  }
+
+  /*
+    Parse JSON string into JSON node and validate it against the schema while
+    parsing. It will throw json_parse_error if the JSON string format is
+    invalid or the value does not match the schema.
+  */
+  JSONNode parse(const std::string &s,
+                 const basic_json_schema<JSONNode> &schema) {
+    JSONNode j;
+    parse_result res = parse(s, schema, &j);
+    if (!res) {
+      MINIJSON_THROW(json_parse_error(res));
+    }
+    return j;
+  }
+
+  const parse_options &options() const { return m_options; }
+  void set_options(const parse_options &options) { m_options = options; }
+
+ private:
+  parse_options m_options;
+  detail::parser<JSONNode> m_parser;
 };
 
+using parser = basic_parser<json_node>;
+
+using json_path = basic_json_path<json_node>;
+
+using json_schema = basic_json_schema<json_node>;
+
+namespace detail {
+/*
+  Get the parser used by parse() on the calling thread
+*/
+template <typename JSONNode>
+inline basic_parser<JSONNode> &thread_parser() {
+  static thread_local basic_parser<JSONNode> instance;
+  return instance;
+}
+}  // namespace detail
+
+/*
+  Parse JSON string into JSON node (Deserialization) without throwing
+  exceptions on invalid input. The returned result holds the kind of error and
+  its byte offset; result is only assigned if parsing succeeds. The buffers of
+  a thread local parser are reused between calls.
+*/
+template <typename JSONNode>
+inline parse_result parse(const std::string &s, JSONNode *result,
+                          const parse_options &options = parse_options()) {
+  basic_parser<JSONNode> &p = detail::thread_parser<JSONNode>();
+  p.set_options(options);
+  return p.parse(s, result);
+}
+
+/*
+  Parse JSON string into JSON node (Deserialization). It will throw
+  json_parse_error if the JSON string format is invalid. Nodes with other
+  traits are parsed with parse<basic_json_node<Traits>>(s).
+*/
+template <typename JSONNode = json_node>
+inline JSONNode parse(const std::string &s,
+                      const parse_options &options = parse_options()) {
+  JSONNode j;
+  parse_result res = parse(s, &j, options);
+  if (!res) {
+    MINIJSON_THROW(json_parse_error(res));
+  }
+  return j;
+}
+
+/*
+  Check that the buffer holds a valid JSON value without building JSON nodes.
+  It follows the same grammar and reports the same errors and offsets as
+  parse(), and allocates no memory unless arrays/objects are nested more than
+  1024 levels deep. Strings are scanned and checked as UTF-8 with SSE2/AVX2.
+*/
+inline parse_result validate(const char *data, size_t size,
+                             const parse_options &options = parse_options()) {
+  const char *end = data + size;
+  parse_error_code error;
+  const char *p = detail::skip_value(data, end, options.max_depth, &error);
+  parse_result res;
+  if (error == parse_error_code::none && p == end) {
+    return res;
+  }
+  res.code = error == parse_error_code::none
+                 ? parse_error_code::trailing_characters
+                 : error;
+  res.offset = static_cast<size_t>(p - data);
+  return res;
+}
+
+inline parse_result validate(const std::string &s,
+                             const parse_options &options = parse_options()) {
+  return validate(s.data(), s.size(), options);
+}
+
+/*
+  Parse JSON string into JSON node, building only the fields selected by the
+  mask (projection), without throwing exceptions on invalid input. Parse time
+  and memory scale with the selected fields rather than with the document.
+*/
+template <typename JSONNode>
+inline parse_result parse(const std::string &s, const field_mask &mask,
+                          JSONNode *result,
+                          const parse_options &options = parse_options()) {
+  basic_parser<JSONNode> &p = detail::thread_parser<JSONNode>();
+  p.set_options(options);
+  return p.parse(s, mask, result);
+}
+
+/*
+  Parse JSON string into JSON node, building only the fields selected by the
+  mask (projection). It will throw json_parse_error if the JSON string format
+  is invalid, including in the skipped parts.
+*/
+template <typename JSONNode = json_node>
+inline JSONNode parse(const std::string &s, const field_mask &mask,
+                      const parse_options &options = parse_options()) {
+  JSONNode j;
+  parse_result res = parse(s, mask, &j, options);
+  if (!res) {
+    MINIJSON_THROW(json_parse_error(res));
+  }
+  return j;
+}
+
+/*
+  Parse JSON string into JSON node and validate it against the schema in the
+  same pass, without throwing exceptions on invalid input. Values are checked
+  as soon as they are complete, so a document is rejected at its first
+  violation without being parsed further; the violation is reported as
+  parse_error_code::schema_violation. schema.validate() on the node gives
+  the same verdict with the path and the reason.
+*/
+template <typename JSONNode>
+inline parse_result parse(const std::string &s,
+                          const basic_json_schema<JSONNode> &schema,
+                          JSONNode *result,
+                          const parse_options &options = parse_options()) {
+  basic_parser<JSONNode> &p = detail::thread_parser<JSONNode>();
+  p.set_options(options);
+  return p.parse(s, schema, result);
+}
+
 /*
-  Parse JSON string into JSON node (Deserialization)
+  Parse JSON string into JSON node and validate it against the schema in the
+  same pass. It will throw json_parse_error if the JSON string format is
+  invalid or the value does not match the schema.
 */
-inline json_node parse(const std::string &s) {
-  json_node j;
-  detail::parser<json_node> parser{&j, s};
-  parser.parse();
+template <typename JSONNode>
+inline JSONNode parse(const std::string &s,
+                      const basic_json_schema<JSONNode> &schema,
+                      const parse_options &options = parse_options()) {
+  JSONNode j;
+  parse_result res = parse(s, schema, &j, options);
+  if (!res) {
+    MINIJSON_THROW(json_parse_error(res));
+  }
   return j;
 }
 
+template <typename JSONNode>
+inline basic_json_schema<JSONNode>::basic_json_schema(const std::string &schema)
+    : basic_json_schema(parse<JSONNode>(schema)) {}
+
+/*
+  Compute the JSON Patch (RFC 6902) document that turns source into target.
+  Subtrees that are shared between source and target or that have equal
+  structural hashes are skipped without being compared recursively. Set verify
+  to true to confirm equal hashes by comparing the subtrees, in case of a hash
+  collision. Values in the patch are shared with target instead of being
+  copied.
+*/
+template <typename Traits>
+inline basic_json_node<Traits> diff(const basic_json_node<Traits> &source,
+                                    const basic_json_node<Traits> &target,
+                                    bool verify = false) {
+  basic_json_node<Traits> patch(json_value_type::array);
+  detail::differ<basic_json_node<Traits>>(&patch, verify).diff(source, target);
+  return patch;
+}
+
+template <typename Traits>
+inline void basic_json_node<Traits>::apply_patch(const std::string &patch) {
+  apply_patch(parse<basic_json_node>(patch));
+}
+
+template <typename Traits>
+inline void basic_json_node<Traits>::apply_merge_patch(
+    const std::string &patch) {
+  apply_merge_patch(parse<basic_json_node>(patch));
+}
+
 }  // namespace miniJSON
+
+namespace std {
+/*
+  Hash of JSON node based on its cached structural hash, so that JSON nodes
+  can be used as keys in unordered containers
+*/
+template <typename Traits>
+struct hash<miniJSON::basic_json_node<Traits>> {
+  size_t operator()(const miniJSON::basic_json_node<Traits> &j) const {
+    return j.structural_hash();
+  }
+};
+}  // namespace std
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+
+namespace miniJSON {
+/*
+  Options controlling how JSON strings are parsed
+*/
+struct parse_options {
+  // Maximum nesting depth of arrays and objects. Deeper input is rejected
+  // with parse_error_code::depth_exceeded. Parsing, serialization,
+  // comparison, hashing, copying and destruction walk the tree with explicit
+  // stacks; diff(), merge(), patches, JSON paths, schema validation and
+  // freeze() recurse once per nesting level, so keep the limit within the
+  // call stack when they are used on untrusted input.
+  size_t max_depth = 512;
+  // Keep the text of numbers and convert it only when get_integer() or
+  // get_double() is called. to_string() writes the text exactly as it was
+  // parsed and get_number_text() returns it, so no precision is lost. Numbers
+  // with a fraction or an exponent are double numbers even if they are
+  // integral, as are integers out of the range of json_int_t.
+  bool lazy_numbers = false;
+};
+
+/*
+  Options controlling how JSON nodes are serialized
+*/
+struct serialize_options {
+  // Escape all non-ASCII characters as \uXXXX so that the output is pure
+  // ASCII
+  bool ensure_ascii = false;
+  // Number of spaces to indent each nesting level with; every element and
+  // member is written on its own line. 0 writes compact output.
+  size_t indent = 0;
+};
+
+/*
+  Options controlling how json_formatter rewrites JSON strings
+*/
+struct format_options {
+  // Number of spaces to indent each nesting level with; every element and
+  // member is written on its own line. 0 writes minified output.
+  size_t indent = 0;
+};
+
+/*
+  How merge() combines two arrays found at the same place
+*/
+enum class merge_array_policy {
+  replace,  // the merged array replaces the existing one
+  concat    // the merged elements are appended to the existing ones
+};
+
+/*
+  How merge() resolves a value that exists in both JSON nodes and that cannot
+  be merged recursively, e.g. two different numbers
+*/
+enum class merge_conflict_policy {
+  overwrite,  // the merged value wins
+  keep,       // the existing value wins
+  error       // json_merge_error is thrown and nothing is modified
+};
+
+/*
+  Options controlling how merge() combines JSON nodes
+*/
+struct merge_options {
+  merge_array_policy arrays = merge_array_policy::replace;
+  merge_conflict_policy conflicts = merge_conflict_policy::overwrite;
+};
+}  // namespace miniJSON
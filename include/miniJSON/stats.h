@@ -0,0 +1,161 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "./json_types.h"
+
+/*
+  Instrumentation of parsing, allocation and serialization is compiled out
+  unless MINIJSON_ENABLE_STATS is defined before including miniJSON. It must
+  be defined the same way in every translation unit of a program.
+*/
+#ifdef MINIJSON_ENABLE_STATS
+#define MINIJSON_STATS(statement) statement
+#else
+#define MINIJSON_STATS(statement)
+#endif
+
+namespace miniJSON {
+/*
+  Counters and timings recorded by the instrumentation. All times are in
+  nanoseconds.
+*/
+struct json_stats {
+  uint64_t bytes_parsed = 0;      // size of the parsed JSON strings
+  uint64_t nodes[8] = {};         // parsed values by json_value_type
+  uint64_t allocations = 0;       // JSON nodes and object/array/string values
+  uint64_t bytes_allocated = 0;   // total size of these allocations
+  size_t max_depth = 0;           // deepest nesting of arrays and objects
+  uint64_t string_parse_ns = 0;   // decoding strings and object keys
+  uint64_t number_parse_ns = 0;   // converting numbers
+  uint64_t serialize_ns = 0;      // json_node::to_string()
+  uint64_t bytes_serialized = 0;  // size of the serialized JSON strings
+
+  /*
+    Get the number of parsed values of a type
+  */
+  uint64_t node_count(json_value_type type) const {
+    return nodes[static_cast<size_t>(type)];
+  }
+
+  json_stats &operator+=(const json_stats &other) {
+    bytes_parsed += other.bytes_parsed;
+    for (size_t i = 0; i < 8; i++) {
+      nodes[i] += other.nodes[i];
+    }
+    allocations += other.allocations;
+    bytes_allocated += other.bytes_allocated;
+    max_depth = std::max(max_depth, other.max_depth);
+    string_parse_ns += other.string_parse_ns;
+    number_parse_ns += other.number_parse_ns;
+    serialize_ns += other.serialize_ns;
+    bytes_serialized += other.bytes_serialized;
+    return *this;
+  }
+};
+
+/*
+  Receives the statistics of every parse and json_node::to_string() call, e.g.
+  to forward them to a metrics system. It is called on the thread that did the
+  work, so an implementation must be thread safe if several threads use
+  miniJSON.
+*/
+class stats_hook {
+ public:
+  virtual ~stats_hook() = default;
+  virtual void on_parse(const json_stats & /* stats */) {}
+  virtual void on_serialize(const json_stats & /* stats */) {}
+};
+
+namespace detail {
+/*
+  Statistics of the calling thread
+*/
+inline json_stats &stats() {
+  static thread_local json_stats instance;
+  return instance;
+}
+
+inline std::atomic<stats_hook *> &hook() {
+  static std::atomic<stats_hook *> instance{nullptr};
+  return instance;
+}
+
+inline void record_allocation(size_t bytes) {
+  stats().allocations++;
+  stats().bytes_allocated += bytes;
+}
+
+/*
+  Add the time spent in the enclosing scope to a counter
+*/
+class stats_timer {
+ public:
+  explicit stats_timer(uint64_t *counter)
+      : m_counter(counter), m_start(std::chrono::steady_clock::now()) {}
+  ~stats_timer() {
+    *m_counter += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - m_start)
+                      .count();
+  }
+
+ private:
+  uint64_t *m_counter;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+/*
+  Collect the statistics of a single parse/serialize operation separately,
+  then add them to the statistics of the thread and pass them to the hook
+*/
+class stats_scope {
+ public:
+  enum class operation { parse, serialize };
+
+  explicit stats_scope(operation op) : m_operation(op), m_saved(stats()) {
+    stats() = json_stats();
+  }
+  ~stats_scope() {
+    json_stats current = stats();
+    stats() = m_saved;
+    stats() += current;
+    stats_hook *h = hook().load(std::memory_order_acquire);
+    if (h == nullptr) {
+      return;
+    }
+    if (m_operation == operation::parse) {
+      h->on_parse(current);
+    } else {
+      h->on_serialize(current);
+    }
+  }
+
+ private:
+  operation m_operation;
+  json_stats m_saved;
+};
+}  // namespace detail
+
+/*
+  Get the statistics accumulated by the calling thread. They stay zero unless
+  MINIJSON_ENABLE_STATS is defined.
+*/
+inline const json_stats &thread_stats() { return detail::stats(); }
+
+/*
+  Reset the statistics of the calling thread
+*/
+inline void reset_thread_stats() { detail::stats() = json_stats(); }
+
+/*
+  Install the hook receiving the statistics of every operation, or remove it
+  with nullptr. The hook must outlive its installation.
+*/
+inline void set_stats_hook(stats_hook *h) {
+  detail::hook().store(h, std::memory_order_release);
+}
+}  // namespace miniJSON
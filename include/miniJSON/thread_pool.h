@@ -0,0 +1,165 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace miniJSON {
+/*
+  Runs tasks, e.g. the parsing tasks of parse_batch() and parse_async(). Any
+  callable that runs the task it is given, now or later on any thread, can
+  be used; thread_pool::get_executor() returns one for a thread pool.
+*/
+using executor = std::function<void(std::function<void()>)>;
+
+/*
+  A work-stealing thread pool. Every worker thread has its own queue: tasks
+  submitted by a worker go to its own queue and are taken from the back,
+  tasks submitted by other threads are spread over the queues round-robin.
+  An idle worker steals from the front of the other queues before it sleeps.
+  The destructor runs all submitted tasks before joining the workers.
+*/
+class thread_pool {
+ public:
+  using task_type = std::function<void()>;
+
+  /*
+    Start the given number of worker threads; 0 starts one per hardware
+    thread
+  */
+  explicit thread_pool(size_t threads = 0) {
+    if (threads == 0) {
+      threads = std::thread::hardware_concurrency();
+      threads = threads == 0 ? 1 : threads;
+    }
+    for (size_t i = 0; i < threads; i++) {
+      m_queues.emplace_back(new task_queue());
+    }
+    for (size_t i = 0; i < threads; i++) {
+      m_threads.emplace_back(&thread_pool::run, this, i);
+    }
+  }
+  thread_pool(const thread_pool &other) = delete;
+  thread_pool &operator=(const thread_pool &other) = delete;
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_work_cv.notify_all();
+    for (auto &thread : m_threads) {
+      thread.join();
+    }
+  }
+
+ public:
+  /*
+    Queue a task to run on one of the worker threads
+  */
+  void submit(task_type task) {
+    size_t index = current_worker() == this
+                       ? current_index()
+                       : m_next.fetch_add(1, std::memory_order_relaxed) %
+                             m_queues.size();
+    m_pending.fetch_add(1, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+      m_queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+      // pairs with the predicate check of sleeping workers
+      std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_work_cv.notify_one();
+  }
+
+  /*
+    Get an executor that submits tasks to the thread pool. The thread pool
+    must outlive it.
+  */
+  executor get_executor() {
+    return [this](task_type task) { submit(std::move(task)); };
+  }
+
+  /*
+    Get the number of worker threads
+  */
+  size_t size() const { return m_threads.size(); }
+
+ private:
+  struct task_queue {
+    std::mutex mutex;
+    std::deque<task_type> tasks;
+  };
+
+  static thread_pool *&current_worker() {
+    static thread_local thread_pool *pool = nullptr;
+    return pool;
+  }
+
+  static size_t &current_index() {
+    static thread_local size_t index = 0;
+    return index;
+  }
+
+  void run(size_t index) {
+    current_worker() = this;
+    current_index() = index;
+    task_type task;
+    while (true) {
+      if (take(index, &task)) {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_work_cv.wait(lock, [this] {
+        return m_stopping || m_pending.load(std::memory_order_acquire) != 0;
+      });
+      if (m_stopping && m_pending.load(std::memory_order_acquire) == 0) {
+        return;
+      }
+    }
+  }
+
+  /*
+    Take a task from the back of the own queue, or else steal one from the
+    front of another queue
+  */
+  bool take(size_t index, task_type *task) {
+    for (size_t i = 0; i < m_queues.size(); i++) {
+      task_queue &queue = *m_queues[(index + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) {
+        continue;
+      }
+      if (i == 0) {
+        *task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        *task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      m_pending.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  std::vector<std::unique_ptr<task_queue>> m_queues;  // one per worker
+  std::vector<std::thread> m_threads;
+  std::atomic<size_t> m_next{0};     // queue of the next outside submission
+  std::atomic<size_t> m_pending{0};  // queued tasks that are not taken yet
+  std::mutex m_mutex;                // guards m_stopping and sleeping
+  std::condition_variable m_work_cv;
+  bool m_stopping = false;
+};
+}  // namespace miniJSON
@@ -0,0 +1,40 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#pragma once
+#include <cstddef>
+
+/*
+  Counters of the global operator new/delete replaced in allocation_test.cpp.
+  Only the calls made by the thread owning an active allocation_counter are
+  counted.
+*/
+struct allocation_counts {
+  size_t allocations = 0;
+  size_t deallocations = 0;
+  size_t bytes = 0;
+};
+
+inline allocation_counts *&active_allocation_counts() {
+  static thread_local allocation_counts *counts = nullptr;
+  return counts;
+}
+
+/*
+  Count the allocations of the calling thread during its lifetime
+*/
+class allocation_counter {
+ public:
+  allocation_counter() : m_previous(active_allocation_counts()) {
+    active_allocation_counts() = &m_counts;
+  }
+  ~allocation_counter() { active_allocation_counts() = m_previous; }
+  allocation_counter(const allocation_counter &) = delete;
+  allocation_counter &operator=(const allocation_counter &) = delete;
+
+  size_t allocations() const { return m_counts.allocations; }
+  size_t deallocations() const { return m_counts.deallocations; }
+  size_t bytes() const { return m_counts.bytes; }
+
+ private:
+  allocation_counts m_counts;
+  allocation_counts *m_previous;
+};
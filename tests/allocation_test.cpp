@@ -0,0 +1,168 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "./alloc-utils.h"
+#include "miniJSON/miniJSON.h"
+
+/*
+  Replacements of the global allocation functions for the whole test program.
+  They count the calls of the thread owning an active allocation_counter.
+*/
+void *operator new(size_t size) {
+  allocation_counts *counts = active_allocation_counts();
+  if (counts != nullptr) {
+    counts->allocations++;
+    counts->bytes += size;
+  }
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  allocation_counts *counts = active_allocation_counts();
+  if (counts != nullptr) {
+    counts->allocations++;
+    counts->bytes += size;
+  }
+  return std::malloc(size == 0 ? 1 : size);
+}
+void operator delete(void *p) noexcept {
+  allocation_counts *counts = active_allocation_counts();
+  if (counts != nullptr && p != nullptr) {
+    counts->deallocations++;
+  }
+  std::free(p);
+}
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  operator delete(p);
+}
+
+namespace {
+const char *document = R"({"id":12345,"name":"widget","tags":["a","b","c"],)"
+                       R"("price":9.75,"stock":{"warehouse":"north",)"
+                       R"("count":42,"available":true},"notes":null})";
+}  // namespace
+
+/*
+  Allocation budgets of common operations on fixed inputs. Counts that depend
+  on the standard library containers are upper bounds, the others are exact.
+*/
+TEST(AllocationTest, Parse) {
+  miniJSON::parse(document);  // grow the buffers of the thread local parser
+  {
+    // 12 child nodes, 2 objects, 1 array and 5 strings, plus the storage of
+    // the containers
+    allocation_counter c;
+    {
+      auto json = miniJSON::parse(document);
+      EXPECT_LE(c.allocations(), 42);
+    }
+    EXPECT_EQ(c.deallocations(), c.allocations());
+  }
+  {
+    // a reused parser allocates nothing but the JSON tree
+    miniJSON::parser parser;
+    parser.parse(document);
+    allocation_counter c;
+    auto json = parser.parse(document);
+    EXPECT_LE(c.allocations(), 42);
+  }
+  {
+    // 1000 nodes and the array with its storage
+    std::string s = "[";
+    for (int i = 0; i < 1000; i++) {
+      s += (i == 0 ? "" : ",") + std::to_string(i);
+    }
+    s += "]";
+    allocation_counter c;
+    auto json = miniJSON::parse(s);
+    EXPECT_LE(c.allocations(), 1013);
+  }
+  {
+    // a failed parse leaks nothing
+    allocation_counter c;
+    miniJSON::json_node json;
+    EXPECT_FALSE(miniJSON::parse(R"({"a":[1,2,{"b":nul}]})", &json));
+    EXPECT_EQ(c.deallocations(), c.allocations());
+  }
+}
+
+TEST(AllocationTest, Iterate) {
+  auto json = miniJSON::parse(document);
+  allocation_counter c;
+  size_t n = 0;
+  for (auto &j : json) {
+    n += j.get_type() == miniJSON::json_value_type::null;
+  }
+  for (auto it = json.begin(); it != json.end(); it++) {
+    n += it.value()->get_type() == miniJSON::json_value_type::null;
+  }
+  for (auto &j : json["tags"]) {
+    n += j.get_string().size();
+  }
+  EXPECT_EQ(n, 2 + 3);
+  EXPECT_EQ(c.allocations(), 0);
+}
+
+TEST(AllocationTest, Lookup) {
+  auto json = miniJSON::parse(document);
+  auto frozen = json.freeze();
+  allocation_counter c;
+  EXPECT_EQ(json.at("stock").at("count").get_integer(), 42);
+  EXPECT_EQ(json.at("tags").at(1).get_type(),
+            miniJSON::json_value_type::string);
+  EXPECT_EQ(json["stock"]["available"].get_boolean(), true);
+  EXPECT_EQ(json["tags"][2].get_type(), miniJSON::json_value_type::string);
+  EXPECT_EQ(frozen.root()["stock"]["count"].get_integer(), 42);
+  EXPECT_EQ(frozen.root()["tags"][0].get_string(), "a");
+  EXPECT_EQ(json.structural_hash(), json.structural_hash());
+  EXPECT_TRUE(json == json.share());
+  EXPECT_EQ(c.allocations(), 0);
+}
+
+TEST(AllocationTest, Copy) {
+  auto json = miniJSON::parse(document);
+  {
+    // shared copies are O(1) until one of them is modified
+    allocation_counter c;
+    auto copy = json.share();
+    EXPECT_EQ(c.allocations(), 0);
+    // the first write clones the modified path only: the root object
+    // (1 object and 6 nodes) and the stock object (1 object and 3 nodes),
+    // plus the storage of the two maps
+    copy["stock"]["count"] = 43;
+    EXPECT_LE(c.allocations(), 24);
+  }
+  {
+    allocation_counter c;
+    miniJSON::json_node copy = json;
+    EXPECT_LE(c.allocations(), 34);
+  }
+}
+
+TEST(AllocationTest, Serialize) {
+  auto json = miniJSON::parse(document);
+  {
+    // the output buffer only grows geometrically
+    allocation_counter c;
+    std::string s = json.to_string();
+    EXPECT_LE(c.allocations(), 4);
+  }
+  {
+    miniJSON::json_node array(miniJSON::json_value_type::array);
+    for (int i = 0; i < 1000; i++) {
+      array.emplace_back(i);
+    }
+    allocation_counter c;
+    std::string s = array.to_string();
+    EXPECT_LE(c.allocations(), 10);
+  }
+}
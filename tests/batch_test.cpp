@@ -0,0 +1,124 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "miniJSON/batch.h"
+
+namespace {
+std::vector<std::string> documents(size_t n) {
+  std::vector<std::string> inputs;
+  for (size_t i = 0; i < n; i++) {
+    if (i % 7 == 3) {
+      inputs.push_back(R"({"id": )" + std::to_string(i) + ", ]");
+    } else {
+      inputs.push_back(R"({"id": )" + std::to_string(i) +
+                       R"(, "tags": ["a", "b"]})");
+    }
+  }
+  return inputs;
+}
+}  // namespace
+
+TEST(BatchTest, ParseBatch) {
+  auto inputs = documents(1000);
+  miniJSON::thread_pool pool(4);
+  EXPECT_EQ(pool.size(), 4);
+  std::vector<miniJSON::json_node> results;
+  auto errors = miniJSON::parse_batch(inputs, &results, pool);
+  ASSERT_EQ(errors.size(), inputs.size());
+  ASSERT_EQ(results.size(), inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    miniJSON::json_node expected;
+    auto expected_error = miniJSON::parse(inputs[i], &expected);
+    EXPECT_EQ(errors[i].code, expected_error.code) << i;
+    EXPECT_EQ(errors[i].offset, expected_error.offset) << i;
+    EXPECT_EQ(results[i], expected) << i;
+  }
+
+  // an executor that runs tasks inline, and an empty batch
+  miniJSON::executor inline_executor = [](std::function<void()> task) {
+    task();
+  };
+  errors = miniJSON::parse_batch(inputs, &results, inline_executor);
+  EXPECT_EQ(results[11].at("id").get_integer(), 11);
+  EXPECT_FALSE(errors[3]);
+  errors = miniJSON::parse_batch(std::vector<std::string>(), &results, pool);
+  EXPECT_TRUE(errors.empty());
+  EXPECT_TRUE(results.empty());
+
+  // an executor that never runs tasks: the calling thread parses everything
+  miniJSON::executor idle_executor = [](std::function<void()>) {};
+  errors = miniJSON::parse_batch(inputs, &results, idle_executor);
+  EXPECT_EQ(results[999].at("id").get_integer(), 999);
+}
+
+TEST(BatchTest, NestedBatch) {
+  // batches parsed from the workers of the same pool cannot deadlock
+  miniJSON::thread_pool pool(2);
+  auto inputs = documents(100);
+  std::vector<std::future<size_t>> futures;
+  for (int i = 0; i < 8; i++) {
+    auto promise = std::make_shared<std::promise<size_t>>();
+    futures.push_back(promise->get_future());
+    pool.submit([&pool, &inputs, promise] {
+      std::vector<miniJSON::json_node> results;
+      auto errors = miniJSON::parse_batch(inputs, &results, pool);
+      size_t valid = 0;
+      for (auto &error : errors) {
+        valid += error ? 1 : 0;
+      }
+      promise->set_value(valid);
+    });
+  }
+  for (auto &future : futures) {
+    EXPECT_EQ(future.get(), 86);
+  }
+}
+
+TEST(BatchTest, ParseAsync) {
+  miniJSON::thread_pool pool(3);
+  auto exec = pool.get_executor();
+  std::vector<std::future<miniJSON::json_node>> futures;
+  for (int i = 0; i < 100; i++) {
+    futures.push_back(
+        miniJSON::parse_async("[" + std::to_string(i) + "]", exec));
+  }
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(futures[i].get()[0].get_integer(), i);
+  }
+  auto invalid = miniJSON::parse_async("[1,", exec);
+  try {
+    invalid.get();
+    FAIL();
+  } catch (const miniJSON::json_parse_error &e) {
+    EXPECT_EQ(e.result().code, miniJSON::parse_error_code::unexpected_end);
+    EXPECT_EQ(e.result().offset, 3);
+  }
+
+  // completion callbacks
+  std::atomic<int> sum{0};
+  std::atomic<int> failed{0};
+  {
+    miniJSON::thread_pool local_pool(2);
+    for (int i = 0; i < 50; i++) {
+      miniJSON::parse_async(
+          i == 7 ? std::string("tru") : std::to_string(i),
+          local_pool.get_executor(),
+          [&sum, &failed](const miniJSON::parse_result &result,
+                          miniJSON::json_node &&json) {
+            if (result) {
+              sum += static_cast<int>(json.get_integer());
+            } else {
+              failed++;
+              EXPECT_EQ(json.get_type(), miniJSON::json_value_type::null);
+            }
+          });
+    }
+  }  // the pool runs the remaining tasks before it is destroyed
+  EXPECT_EQ(sum, 50 * 49 / 2 - 7);
+  EXPECT_EQ(failed, 1);
+}
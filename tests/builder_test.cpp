@@ -0,0 +1,83 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(BuilderTest, Array) {
+  {
+    // null node becomes an array
+    miniJSON::json_node json;
+    json.push_back(1);
+    json.push_back("abc");
+    json.emplace_back(miniJSON::json_value_type::object);
+    json.emplace_back(nullptr);
+    EXPECT_EQ(json.to_string(), R"([1,"abc",{},null])");
+  }
+  {
+    // moved subtree leaves the source as null
+    miniJSON::json_node json(miniJSON::json_value_type::array);
+    json.reserve(2);
+    auto sub = miniJSON::parse(R"({"a":[1,2,3]})");
+    json.push_back(std::move(sub));
+    EXPECT_EQ(sub.get_type(), miniJSON::json_value_type::null);
+    EXPECT_EQ(json.to_string(), R"([{"a":[1,2,3]}])");
+  }
+  {
+    // emplace_back returns the inserted node
+    miniJSON::json_node json;
+    auto &node = json.emplace_back();
+    node.push_back(true);
+    EXPECT_EQ(json.to_string(), R"([[true]])");
+  }
+  {
+    // pushing into a non-array node
+    auto json = miniJSON::parse(R"({"a":1})");
+    EXPECT_THROW({ json.push_back(1); }, miniJSON::json_type_error);
+  }
+  {
+    // accessing past the end fills every gap with indeterminate nodes
+    auto json = miniJSON::parse("[1]");
+    json[3] = 4;
+    EXPECT_EQ(json[1].get_type(), miniJSON::json_value_type::indeterminate);
+    EXPECT_EQ(json[2].get_type(), miniJSON::json_value_type::indeterminate);
+    json[1] = 2;
+    json[2] = 3;
+    EXPECT_EQ(json.to_string(), R"([1,2,3,4])");
+  }
+}
+
+TEST(BuilderTest, Object) {
+  {
+    // null node becomes an object
+    miniJSON::json_node json;
+    json.insert("name", "Alicia");
+    json.emplace("age", 32);
+    json.reserve(4);
+    EXPECT_EQ(json.to_string(), R"({"name":"Alicia","age":32})");
+  }
+  {
+    // existing value is replaced and insertion order is kept
+    miniJSON::json_node json = {{"name", "Alicia"}, {"age", 32}};
+    json.insert("name", miniJSON::parse(R"(["David"])"));
+    EXPECT_EQ(json.to_string(), R"({"name":["David"],"age":32})");
+  }
+  {
+    // moved subtree leaves the source as null
+    miniJSON::json_node json;
+    auto sub = miniJSON::parse(R"([{"a":1},{"b":2}])");
+    auto &node = json.insert("items", std::move(sub));
+    node.push_back(3);
+    EXPECT_EQ(sub.get_type(), miniJSON::json_value_type::null);
+    EXPECT_EQ(json.to_string(), R"({"items":[{"a":1},{"b":2},3]})");
+  }
+  {
+    // inserting into a non-object node
+    auto json = miniJSON::parse("[1]");
+    EXPECT_THROW({ json.insert("a", 1); }, miniJSON::json_type_error);
+    EXPECT_THROW({ miniJSON::json_node(1).reserve(1); },
+                 miniJSON::json_type_error);
+  }
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+namespace {
+std::string to_hex(const std::array<uint8_t, 32> &digest) {
+  std::string s;
+  char buf[3];
+  for (uint8_t b : digest) {
+    snprintf(buf, sizeof(buf), "%02x", b);
+    s += buf;
+  }
+  return s;
+}
+
+std::string canonical_number(double d) {
+  return miniJSON::json_node(d).to_canonical_string();
+}
+}  // namespace
+
+TEST(CanonicalTest, Example) {
+  // the example of RFC 8785 section 3.2.2
+  auto json = miniJSON::parse(R"({
+    "numbers": [333333333.33333329, 1E30, 4.50, 2e-3,
+                0.000000000000000000000000001],
+    "string": "\u20ac$\u000F\u000aA'\u0042\u0022\u005c\\\"\/",
+    "literals": [null, true, false]
+  })");
+  EXPECT_EQ(json.to_canonical_string(),
+            R"({"literals":[null,true,false],)"
+            R"("numbers":[333333333.3333333,1e+30,4.5,0.002,1e-27],)"
+            "\"string\":\"\xe2\x82\xac$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}");
+}
+
+TEST(CanonicalTest, Numbers) {
+  EXPECT_EQ(canonical_number(0.0), "0");
+  EXPECT_EQ(canonical_number(-0.0), "0");
+  EXPECT_EQ(canonical_number(1.0), "1");
+  EXPECT_EQ(canonical_number(-1.5), "-1.5");
+  EXPECT_EQ(canonical_number(0.1), "0.1");
+  EXPECT_EQ(canonical_number(1e-6), "0.000001");
+  EXPECT_EQ(canonical_number(1e-7), "1e-7");
+  EXPECT_EQ(canonical_number(1.5e-7), "1.5e-7");
+  EXPECT_EQ(canonical_number(1e20), "100000000000000000000");
+  EXPECT_EQ(canonical_number(1e21), "1e+21");
+  EXPECT_EQ(canonical_number(123.456e18), "123456000000000000000");
+  EXPECT_EQ(canonical_number(5e-324), "5e-324");
+  EXPECT_EQ(canonical_number(1.7976931348623157e308),
+            "1.7976931348623157e+308");
+  EXPECT_EQ(canonical_number(295147905179352830000.0),
+            "295147905179352830000");
+  EXPECT_EQ(canonical_number(-9007199254740992.0), "-9007199254740992");
+  // integers are written as doubles
+  EXPECT_EQ(miniJSON::json_node(42).to_canonical_string(), "42");
+  EXPECT_EQ(miniJSON::json_node(static_cast<int64_t>(9007199254740993))
+                .to_canonical_string(),
+            "9007199254740992");
+  EXPECT_THROW(canonical_number(std::nan("")), miniJSON::json_type_error);
+  EXPECT_THROW(canonical_number(std::numeric_limits<double>::infinity()),
+               miniJSON::json_type_error);
+}
+
+TEST(CanonicalTest, Order) {
+  // the example of RFC 8785 section 3.2.3: members are sorted by UTF-16 code
+  // units, so the emoji goes before U+FB33
+  auto json = miniJSON::parse(R"({
+    "€": "Euro Sign",
+    "\r": "Carriage Return",
+    "דּ": "Hebrew Letter Dalet With Dagesh",
+    "1": "One",
+    "😀": "Emoji: Grinning Face",
+    "\u0080": "Control",
+    "ö": "Latin Small Letter O With Diaeresis"
+  })");
+  std::vector<std::string> values;
+  auto canonical = miniJSON::parse(json.to_canonical_string());
+  for (auto it = canonical.begin(); it != canonical.end(); it++) {
+    values.push_back(it.value()->get_string());
+  }
+  EXPECT_EQ(values, (std::vector<std::string>{
+                        "Carriage Return", "One", "Control",
+                        "Latin Small Letter O With Diaeresis", "Euro Sign",
+                        "Emoji: Grinning Face",
+                        "Hebrew Letter Dalet With Dagesh"}));
+  // shorter keys go first and nested objects are sorted too
+  auto nested =
+      miniJSON::parse(R"({"ab": {"b": 1, "a": 2}, "a": [{"y": 0, "x": 1}]})");
+  EXPECT_EQ(nested.to_canonical_string(),
+            R"({"a":[{"x":1,"y":0}],"ab":{"a":2,"b":1}})");
+}
+
+TEST(CanonicalTest, Equivalence) {
+  auto a = miniJSON::parse(R"({"id": 1, "tags": ["x", "y"], "w": 2.50})");
+  auto b = miniJSON::parse(R"({"w": 2.5, "tags": ["x", "y"], "id": 1.0})");
+  auto c = miniJSON::parse(R"({"w": 2.5, "tags": ["y", "x"], "id": 1.0})");
+  EXPECT_EQ(a.to_canonical_string(), b.to_canonical_string());
+  EXPECT_EQ(a.content_hash(), b.content_hash());
+  EXPECT_NE(a.content_hash(), c.content_hash());
+
+  // numbers kept as text are written canonically too
+  miniJSON::parse_options options;
+  options.lazy_numbers = true;
+  auto lazy = miniJSON::parse(
+      R"({"w": 25e-1, "id": 1.000, "tags": ["x", "y"]})", options);
+  EXPECT_EQ(lazy.content_hash(), a.content_hash());
+}
+
+TEST(CanonicalTest, ContentHash) {
+  EXPECT_EQ(to_hex(miniJSON::json_node("abc").content_hash()),
+            "6cc43f858fbb763301637b5af970e2a46b46f461f27e5a0f41e009c59b827b25");
+  EXPECT_EQ(to_hex(miniJSON::parse(R"({"b": true, "a": [1, 2.5, null]})")
+                       .content_hash()),
+            "5bfed00731eb76e3e9217d76fb62e4e7e9c588f33fb29cd3234a5204672b3f47");
+  EXPECT_EQ(to_hex(miniJSON::parse("[]").content_hash()),
+            "4f53cda18c2baa0c0354bb5f9a3ecbe5ed12ab4d8e11ba873c2f11161202b945");
+
+  // larger than the buffer of the serializer
+  miniJSON::json_node json(miniJSON::json_value_type::array);
+  for (int i = 0; i < 2000; i++) {
+    json.push_back(std::to_string(i).c_str());
+  }
+  EXPECT_EQ(to_hex(json.content_hash()),
+            "b1f95fab12d9597ccfa2f6300c84edee44c1d26249ba5c1c27b6f3c9d0fa6a67");
+  std::string s;
+  size_t chunks = 0;
+  json.to_canonical([&s, &chunks](const char *data, size_t size) {
+    s.append(data, size);
+    chunks++;
+  });
+  EXPECT_EQ(s, json.to_canonical_string());
+  EXPECT_EQ(s.size(), 12891);
+  EXPECT_GT(chunks, 1);
+}
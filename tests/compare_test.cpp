@@ -0,0 +1,139 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(CompareTest, Equality) {
+  {
+    auto a = miniJSON::parse(R"({"a":[1,2.5,"x"],"b":{"c":null,"d":true}})");
+    auto b = miniJSON::parse(R"({"b":{"d":true,"c":null},"a":[1.0,2.5,"x"]})");
+    EXPECT_TRUE(a == b);
+    EXPECT_FALSE(a != b);
+    b["b"]["d"] = false;
+    EXPECT_FALSE(a == b);
+    EXPECT_TRUE(a != b);
+  }
+  {
+    // integer and double numbers
+    EXPECT_EQ(miniJSON::json_node(1), miniJSON::json_node(1.0));
+    EXPECT_NE(miniJSON::json_node(1), miniJSON::json_node(1.5));
+    // 2^53 + 1 cannot be represented as double
+    EXPECT_NE(miniJSON::json_node(int64_t{9007199254740993}),
+              miniJSON::json_node(9007199254740992.0));
+    EXPECT_NE(miniJSON::json_node(std::numeric_limits<int64_t>::max()),
+              miniJSON::json_node(9223372036854775808.0));
+  }
+  {
+    // comparing with implicitly created nodes
+    auto json = miniJSON::parse(R"({"name":"Alicia","age":32,"job":null})");
+    EXPECT_TRUE(json["name"] == "Alicia");
+    EXPECT_TRUE(json["age"] == 32);
+    EXPECT_TRUE(json["job"] == nullptr);
+    EXPECT_TRUE(json.at("age") != "32");
+  }
+  {
+    // different types and sizes
+    EXPECT_NE(miniJSON::parse("[1,2]"), miniJSON::parse("[1,2,3]"));
+    EXPECT_NE(miniJSON::parse(R"({"a":1})"), miniJSON::parse(R"({"b":1})"));
+    EXPECT_NE(miniJSON::parse("[]"), miniJSON::parse("{}"));
+    EXPECT_NE(miniJSON::parse("0"), miniJSON::parse("false"));
+  }
+  {
+    // shared copies
+    auto json = miniJSON::parse(R"({"a":[1,2]})");
+    auto copy = json.share();
+    EXPECT_EQ(json, copy);
+    copy["a"][0] = 3;
+    EXPECT_NE(json, copy);
+  }
+}
+
+TEST(CompareTest, Ordering) {
+  {
+    std::vector<std::string> ordered = {
+        "null",    "false",    "true",      "-1.5",       "-1",
+        "0",       "0.5",      "1",         "2",          R"("")",
+        R"("a")",  R"("ab")",  R"("b")",    "[]",         "[1]",
+        "[1,2]",   "[2]",      "{}",        R"({"a":1})", R"({"a":2})",
+        R"({"b":0})"};
+    for (size_t i = 0; i < ordered.size(); i++) {
+      for (size_t j = 0; j < ordered.size(); j++) {
+        auto a = miniJSON::parse(ordered[i]);
+        auto b = miniJSON::parse(ordered[j]);
+        EXPECT_EQ(a < b, i < j) << ordered[i] << " " << ordered[j];
+        EXPECT_EQ(a >= b, i >= j) << ordered[i] << " " << ordered[j];
+        EXPECT_EQ(a > b, i > j) << ordered[i] << " " << ordered[j];
+        EXPECT_EQ(a <= b, i <= j) << ordered[i] << " " << ordered[j];
+      }
+    }
+  }
+  {
+    // object members are compared by sorted keys
+    EXPECT_FALSE(miniJSON::parse(R"({"b":1,"a":2})") <
+                 miniJSON::parse(R"({"a":2,"b":1})"));
+    EXPECT_TRUE(miniJSON::parse(R"({"b":1,"a":1})") <
+                miniJSON::parse(R"({"a":2,"b":1})"));
+    // integer and double numbers
+    EXPECT_TRUE(miniJSON::parse("-3") < miniJSON::parse("-2.5"));
+    EXPECT_TRUE(miniJSON::parse("-2.5") < miniJSON::parse("-2"));
+    EXPECT_FALSE(miniJSON::parse("2.0") < miniJSON::parse("2"));
+  }
+}
+
+TEST(CompareTest, Hash) {
+  {
+    // equal nodes have equal hashes
+    std::hash<miniJSON::json_node> hasher;
+    auto a = miniJSON::parse(R"({"a":[1,2],"b":"c"})");
+    auto b = miniJSON::parse(R"({"b":"c","a":[1.0,2.0]})");
+    EXPECT_EQ(hasher(a), hasher(b));
+    EXPECT_EQ(a.structural_hash(false), b.structural_hash(false));
+  }
+  {
+    // json node as key of unordered containers
+    std::unordered_set<miniJSON::json_node> set;
+    set.insert(miniJSON::parse(R"({"id":1,"tags":["a","b"]})"));
+    set.insert(miniJSON::parse(R"({"tags":["a","b"],"id":1.0})"));
+    set.insert(miniJSON::parse(R"({"id":2,"tags":["a","b"]})"));
+    EXPECT_EQ(set.size(), 2);
+    EXPECT_EQ(set.count(miniJSON::parse(R"({"id":2,"tags":["a","b"]})")), 1);
+
+    std::unordered_map<miniJSON::json_node, int> cache;
+    cache[miniJSON::parse("[1,2,3]")] = 6;
+    EXPECT_EQ(cache.at(miniJSON::parse("[1,2,3]")), 6);
+  }
+  {
+    // cached hashes are dropped on the path to a modified descendant
+    auto a = miniJSON::parse(R"({"x":{"y":[1,2]}})");
+    auto b = miniJSON::parse(R"({"x":{"y":[1,3]}})");
+    std::hash<miniJSON::json_node> hasher;
+    EXPECT_NE(hasher(a), hasher(b));
+    EXPECT_NE(a, b);
+    a["x"]["y"][1] = 3;
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(hasher(a), hasher(b));
+    std::unordered_set<miniJSON::json_node> set = {b};
+    EXPECT_EQ(set.count(a), 1);
+  }
+  {
+    // modifying or moving another document keeps the memoized hashes: a
+    // change made through a held reference, which bypasses the path from the
+    // root, shows that the hash is not computed again
+    auto a = miniJSON::parse(R"({"x":{"y":[1,2]}})");
+    auto b = miniJSON::parse(R"({"x":{"y":[1,2]}})");
+    miniJSON::json_node &y = a["x"]["y"];
+    size_t h = a.structural_hash();
+    y.push_back(3);
+    b["x"]["y"][1] = 3;
+    miniJSON::json_node c = std::move(b);
+    c = miniJSON::parse("[]");
+    EXPECT_EQ(a.structural_hash(), h);
+    EXPECT_NE(miniJSON::parse(a.to_string()).structural_hash(), h);
+  }
+}
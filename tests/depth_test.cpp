@@ -0,0 +1,76 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(DepthTest, DeepNesting) {
+  {
+    // nesting up to the maximum depth is accepted
+    miniJSON::parse_options options;
+    options.max_depth = 4;
+    auto json = miniJSON::parse(R"([{"a":[{}]}])", options);
+    EXPECT_EQ(json.to_string(), R"([{"a":[{}]}])");
+    EXPECT_EQ(miniJSON::parse("[[[[]]]]", options).to_string(), "[[[[]]]]");
+  }
+  {
+    // deeper nesting is rejected at the offending bracket
+    miniJSON::parse_options options;
+    options.max_depth = 4;
+    miniJSON::json_node json;
+    auto res = miniJSON::parse(R"([{"a":[{"b":[]}]}])", &json, options);
+    EXPECT_EQ(res.code, miniJSON::parse_error_code::depth_exceeded);
+    EXPECT_EQ(res.offset, 12);
+    EXPECT_THROW(miniJSON::parse("[[[[[1]]]]]", options),
+                 miniJSON::json_parse_error);
+  }
+  {
+    // hostile input does not overflow the stack
+    std::string s(1000000, '[');
+    miniJSON::json_node json;
+    auto res = miniJSON::parse(s, &json);
+    EXPECT_EQ(res.code, miniJSON::parse_error_code::depth_exceeded);
+    EXPECT_EQ(res.offset, miniJSON::parse_options().max_depth);
+  }
+  {
+    // a custom depth limit well beyond the call stack capacity
+    size_t depth = 10000;
+    std::string s = std::string(depth, '[') + std::string(depth, ']');
+    miniJSON::parse_options options;
+    options.max_depth = depth;
+    miniJSON::json_node json;
+    EXPECT_TRUE(miniJSON::parse(s, &json, options));
+    EXPECT_EQ(json.get_type(), miniJSON::json_value_type::array);
+  }
+  {
+    // documents deeper than the call stack allows are walked iteratively
+    size_t depth = 100000;
+    std::string s = std::string(depth, '[') + "{\"a\":1}" +
+                    std::string(depth, ']');
+    miniJSON::parse_options options;
+    options.max_depth = depth + 1;
+    auto json = miniJSON::parse(s, options);
+    EXPECT_EQ(json.to_string(), s);
+    EXPECT_EQ(json.to_canonical_string(), s);
+
+    miniJSON::json_node copy = json;
+    EXPECT_EQ(copy, json);
+    EXPECT_EQ(copy.structural_hash(false), json.structural_hash());
+    EXPECT_FALSE(copy < json || json < copy);
+    copy = miniJSON::parse(std::string(depth, '[') + "{\"a\":2}" +
+                               std::string(depth, ']'),
+                           options);
+    EXPECT_NE(copy, json);
+    EXPECT_NE(copy.structural_hash(), json.structural_hash());
+    EXPECT_TRUE(json < copy);
+  }
+}
+
+TEST(DepthTest, DuplicateKeys) {
+  {
+    // the last member wins
+    auto json = miniJSON::parse(R"({"a":[1,2],"b":2,"a":{"c":3}})");
+    EXPECT_EQ(json.to_string(), R"({"a":{"c":3},"b":2})");
+  }
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+namespace {
+/*
+  Build an array nested depth levels deep without using the parser
+*/
+miniJSON::json_node nested_array(size_t depth) {
+  miniJSON::json_node root(miniJSON::json_value_type::array);
+  miniJSON::json_node *node = &root;
+  for (size_t i = 0; i < depth; i++) {
+    node = &node->emplace_back(miniJSON::json_value_type::array);
+  }
+  return root;
+}
+}  // namespace
+
+TEST(DestroyTest, DeepTree) {
+  {
+    // deleting deep trees does not overflow the call stack
+    auto json = nested_array(1000000);
+    json = nullptr;
+    EXPECT_EQ(json.to_string(), "null");
+  }
+  {
+    size_t depth = 200000;
+    std::string s = std::string(depth, '[') + R"({"a":"b"})" +
+                    std::string(depth, ']');
+    miniJSON::parse_options options;
+    options.max_depth = depth + 1;
+    miniJSON::json_node json;
+    EXPECT_TRUE(miniJSON::parse(s, &json, options));
+  }
+}
+
+TEST(DestroyTest, SharedSubtrees) {
+  {
+    // subtrees still shared with other nodes survive deletion of the tree
+    miniJSON::json_node users;
+    {
+      auto json = miniJSON::parse(
+          R"({"users":[{"name":"Alicia","tags":["a","b"]}],"count":1})");
+      users = json["users"].share();
+      auto copy = json.share();
+      copy["count"] = 2;
+    }
+    EXPECT_EQ(users.to_string(), R"([{"name":"Alicia","tags":["a","b"]}])");
+    EXPECT_FALSE(users.is_shared());
+  }
+}
+
+TEST(DestroyTest, DeferredFree) {
+  miniJSON::json_node::set_deferred_free(true);
+  {
+    // dropped trees are freed by the background thread
+    std::vector<miniJSON::json_node> documents;
+    for (int i = 0; i < 100; i++) {
+      documents.push_back(miniJSON::parse(
+          R"({"id":)" + std::to_string(i) + R"(,"items":[1,2,{"a":[3]}]})"));
+    }
+    auto kept = documents[42]["items"].share();
+    documents.clear();
+    documents.push_back(nested_array(100000));
+    documents[0] = miniJSON::parse("[1,2,3]");
+    miniJSON::json_node::flush_deferred_free();
+    EXPECT_EQ(kept.to_string(), R"([1,2,{"a":[3]}])");
+    EXPECT_EQ(documents[0].to_string(), "[1,2,3]");
+  }
+  miniJSON::json_node::set_deferred_free(false);
+  {
+    // trees are freed inline again after disabling deferred free
+    auto json = miniJSON::parse(R"({"a":[1,2]})");
+    json = nested_array(10);
+    json = nullptr;
+  }
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(DiffTest, StructuralHash) {
+  {
+    // equal values have equal hashes
+    auto a = miniJSON::parse(R"({"a":[1,2.5,"x"],"b":{"c":null,"d":true}})");
+    auto b = miniJSON::parse(R"({"b":{"d":true,"c":null},"a":[1.0,2.5,"x"]})");
+    EXPECT_EQ(a.structural_hash(), b.structural_hash());
+  }
+  {
+    // different values have different hashes
+    std::vector<std::string> values = {"null", "true",  "false", "0",
+                                       "1",    "1.5",   R"("1")", "[]",
+                                       "{}",   "[1,2]", "[2,1]",  R"({"a":1})"};
+    for (size_t i = 0; i < values.size(); i++) {
+      for (size_t j = i + 1; j < values.size(); j++) {
+        EXPECT_NE(miniJSON::parse(values[i]).structural_hash(),
+                  miniJSON::parse(values[j]).structural_hash());
+      }
+    }
+  }
+  {
+    // cached hash is dropped on modification
+    auto json = miniJSON::parse(R"({"a":{"b":[1,2]}})");
+    size_t h = json.structural_hash();
+    json["a"]["b"][1] = 3;
+    EXPECT_NE(json.structural_hash(), h);
+    json["a"]["b"][1] = 2;
+    EXPECT_EQ(json.structural_hash(), h);
+    json["a"]["b"].push_back(3);
+    EXPECT_NE(json.structural_hash(), h);
+    json["a"]["b"].erase(2);
+    EXPECT_EQ(json.structural_hash(), h);
+    json.apply_patch(R"([{"op":"add","path":"/a/c","value":1}])");
+    EXPECT_NE(json.structural_hash(), h);
+  }
+  {
+    // cached hashes of the ancestors are dropped on the path to a modified
+    // descendant, and the other documents keep theirs
+    auto v1 = miniJSON::parse(R"({"items":{"x":5},"n":[[1]]})");
+    auto v2 = v1;
+    size_t h = v2.structural_hash();
+    EXPECT_EQ(v1.structural_hash(), h);
+    v2["items"]["x"] = 6;
+    EXPECT_NE(v2.structural_hash(), h);
+    EXPECT_EQ(miniJSON::diff(v1, v2).to_string(),
+              R"([{"op":"replace","path":"/items/x","value":6}])");
+    v2["items"]["x"] = 5;
+    EXPECT_EQ(v2.structural_hash(), h);
+    v2["n"][0] = miniJSON::json_node(2);
+    EXPECT_NE(v2.structural_hash(), h);
+    EXPECT_EQ(v1.structural_hash(), h);
+    EXPECT_EQ(miniJSON::diff(v1, v2).to_string(),
+              R"([{"op":"replace","path":"/n/0","value":2}])");
+  }
+}
+
+TEST(DiffTest, Diff) {
+  std::vector<std::vector<std::string>> cases = {
+      // source, target, expected patch
+      {R"({"a":1})", R"({"a":1})", R"([])"},
+      {R"({"a":1})", R"({"a":1.0})", R"([])"},
+      {R"(1)", R"("a")", R"([{"op":"replace","path":"","value":"a"}])"},
+      {R"({"a":1,"b":2})", R"({"a":1,"c":3})",
+       R"([{"op":"remove","path":"/b"},{"op":"add","path":"/c","value":3}])"},
+      {R"({"a":{"b/c":[1,2]}})", R"({"a":{"b/c":[1,3]}})",
+       R"([{"op":"replace","path":"/a/b~1c/1","value":3}])"},
+      {R"([1,2,3,4])", R"([1,4])",
+       R"([{"op":"remove","path":"/1"},{"op":"remove","path":"/1"}])"},
+      {R"([1,4])", R"([1,2,3,4])",
+       R"([{"op":"add","path":"/1","value":2},{"op":"add","path":"/2","value":3}])"},
+      {R"([1,2,3])", R"([0,2,5,6])",
+       R"([{"op":"replace","path":"/0","value":0},{"op":"replace","path":"/2","value":5},{"op":"add","path":"/3","value":6}])"},
+      {R"({"a":[{"b":1}]})", R"({"a":{"b":1}})",
+       R"([{"op":"replace","path":"/a","value":{"b":1}}])"},
+  };
+  for (auto &c : cases) {
+    auto source = miniJSON::parse(c[0]);
+    auto target = miniJSON::parse(c[1]);
+    auto patch = miniJSON::diff(source, target);
+    EXPECT_EQ(patch.to_string(), c[2]);
+    // confirming equal hashes by comparison gives the same patch
+    EXPECT_EQ(miniJSON::diff(source, target, true).to_string(), c[2]);
+    source.apply_patch(patch);
+    EXPECT_EQ(source.structural_hash(), target.structural_hash());
+  }
+}
+
+TEST(DiffTest, SharedDocument) {
+  {
+    // a new version derived from a shared copy only differs on the
+    // modified paths
+    auto v1 = miniJSON::parse(
+        R"({"users":[{"name":"Alicia","age":32},{"name":"David","age":27}],"meta":{"count":2}})");
+    auto v2 = v1.share();
+    v2["users"][1]["age"] = 28;
+    v2["meta"]["updated"] = true;
+    auto patch = miniJSON::diff(v1, v2);
+    EXPECT_EQ(
+        patch.to_string(),
+        R"([{"op":"replace","path":"/users/1/age","value":28},{"op":"add","path":"/meta/updated","value":true}])");
+    v1.apply_patch(std::move(patch));
+    EXPECT_EQ(v1.to_string(), v2.to_string());
+  }
+}
@@ -0,0 +1,159 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+namespace {
+const char *document = " {\"a\" : [1, -2.5e3 , {\"b\":null}, [ ] ],\n"
+                       "  \"c\":{ }, \"d\" : \"\\u00e9\\ud83d\\ude00\xc3\xa9 \","
+                       " \"e\" : [true,false] } ";
+
+/*
+  Format the input split into chunks of the given size
+*/
+miniJSON::parse_result format_chunks(const std::string &input, size_t size,
+                                     const miniJSON::format_options &options,
+                                     std::string *out) {
+  out->clear();
+  miniJSON::json_formatter formatter(
+      [out](const char *data, size_t n) { out->append(data, n); }, options);
+  for (size_t i = 0; i < input.size(); i += size) {
+    formatter.write(input.data() + i, std::min(size, input.size() - i));
+  }
+  return formatter.finish();
+}
+}  // namespace
+
+TEST(FormatterTest, Minify) {
+  std::string out;
+  ASSERT_TRUE(miniJSON::format(document, &out));
+  // strings and numbers are copied as they are
+  EXPECT_EQ(out,
+            "{\"a\":[1,-2.5e3,{\"b\":null},[]],\"c\":{},"
+            "\"d\":\"\\u00e9\\ud83d\\ude00\xc3\xa9 \",\"e\":[true,false]}");
+  EXPECT_EQ(miniJSON::parse(out), miniJSON::parse(document));
+
+  std::vector<std::string> filenames = {
+      "../tests/data/random-parse-data-1.json",
+      "../tests/data/random-parse-data-2.json"};
+  for (auto &filename : filenames) {
+    std::ifstream in_file(filename);
+    std::stringstream ss;
+    ss << in_file.rdbuf();
+    ASSERT_TRUE(miniJSON::format(ss.str(), &out));
+    EXPECT_EQ(out, ss.str());
+  }
+}
+
+TEST(FormatterTest, Indent) {
+  miniJSON::format_options options;
+  options.indent = 2;
+  std::string out;
+  ASSERT_TRUE(miniJSON::format(R"({"a":[1,{"b":null},[]],"c":{},"d":"e"})",
+                               &out, options));
+  // the same layout as json_node::to_string() with the same indent
+  EXPECT_EQ(out, R"({
+  "a": [
+    1,
+    {
+      "b": null
+    },
+    []
+  ],
+  "c": {},
+  "d": "e"
+})");
+  ASSERT_TRUE(miniJSON::format("[ 1 ]", &out, options));
+  EXPECT_EQ(out, "[\n  1\n]");
+  ASSERT_TRUE(miniJSON::format(" \"a\" ", &out, options));
+  EXPECT_EQ(out, "\"a\"");
+}
+
+TEST(FormatterTest, Chunks) {
+  miniJSON::format_options options;
+  options.indent = 4;
+  std::string expected;
+  ASSERT_TRUE(miniJSON::format(document, &expected, options));
+  // the input can be split anywhere, even inside tokens
+  for (size_t size = 1; size <= 8; size++) {
+    std::string out;
+    EXPECT_TRUE(format_chunks(document, size, options, &out)) << size;
+    EXPECT_EQ(out, expected) << size;
+  }
+}
+
+TEST(FormatterTest, Errors) {
+  std::vector<std::string> inputs = {
+      "",
+      "  ",
+      "[",
+      "[1,",
+      "[1,]",
+      "[1 2]",
+      R"({"a":1)",
+      R"({"a":1,})",
+      R"({a:1})",
+      R"({"a" 1})",
+      "tru",
+      "[1, nul]",
+      "1.",
+      "[1.]",
+      "-",
+      R"("abc)",
+      "\"a\tb\"",
+      R"("\x")",
+      R"("\u12")",
+      R"("\ud800")",
+      R"("\ud800A")",
+      R"("\)",
+      R"("\u00)",
+      "\"\xff\"",
+      "\"\xe4\xb8\"",
+      "\"\xe4\xb8",
+      "\"\xed\xa0\x80\"",
+      "[1] 2",
+      "]",
+  };
+  miniJSON::parse_options deep;
+  deep.max_depth = 2;
+  for (auto &input : inputs) {
+    miniJSON::json_node json;
+    auto expected = miniJSON::parse(input, &json);
+    // the same error at any chunk size
+    for (size_t size : {1, 2, 3, 100}) {
+      std::string out;
+      auto res = format_chunks(input, size, miniJSON::format_options(), &out);
+      EXPECT_EQ(res.code, expected.code) << input << " " << size;
+      EXPECT_EQ(res.offset, expected.offset) << input << " " << size;
+    }
+  }
+  {
+    std::string out;
+    miniJSON::json_formatter formatter(
+        [&out](const char *data, size_t n) { out.append(data, n); },
+        miniJSON::format_options(), deep);
+    auto res = formatter.write("[[1], [[2]]]");
+    EXPECT_EQ(res.code, miniJSON::parse_error_code::depth_exceeded);
+    EXPECT_EQ(res.offset, 7);
+    // later chunks are ignored
+    EXPECT_FALSE(formatter.write("]"));
+    EXPECT_FALSE(formatter.finish());
+    // and the formatter is ready for the next document
+    out.clear();
+    EXPECT_TRUE(formatter.write("[[1]]"));
+    EXPECT_TRUE(formatter.finish());
+    EXPECT_EQ(out, "[[1]]");
+  }
+  {
+    // out is left alone on error
+    std::string out = "unchanged";
+    EXPECT_FALSE(miniJSON::format("[1,", &out));
+    EXPECT_EQ(out, "unchanged");
+  }
+}
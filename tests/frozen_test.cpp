@@ -0,0 +1,86 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(FrozenTest, Read) {
+  auto json = miniJSON::parse(
+      R"({"name":"Alicia","age":32,"height":1.7,"admin":false,"job":null,"friends":[{"name":"David"},{"name":"Michael"}],"z":{},"a":[]})");
+  auto frozen = json.freeze();
+  auto root = frozen.root();
+  {
+    EXPECT_EQ(root.get_type(), miniJSON::json_value_type::object);
+    EXPECT_EQ(root.size(), 8);
+    EXPECT_EQ(root["name"].get_string(), "Alicia");
+    EXPECT_EQ(root["age"].get_integer(), 32);
+    EXPECT_EQ(root["height"].get_double(), 1.7);
+    EXPECT_FALSE(root["admin"].get_boolean());
+    EXPECT_EQ(root["job"].get_type(), miniJSON::json_value_type::null);
+    EXPECT_EQ(root["friends"][1]["name"].get_string(), "Michael");
+    EXPECT_EQ(root["friends"].size(), 2);
+    EXPECT_EQ(root["z"].size(), 0);
+    // members keep their insertion order
+    EXPECT_EQ(root.key(0), "name");
+    EXPECT_EQ(root.key(7), "a");
+    EXPECT_EQ(root[7].size(), 0);
+    EXPECT_EQ(frozen.root().to_string(), json.to_string());
+  }
+  {
+    // lookups never modify the document
+    EXPECT_FALSE(root.contains("missing"));
+    miniJSON::frozen_json::value v;
+    EXPECT_TRUE(root.find("age", &v));
+    EXPECT_EQ(v.get_integer(), 32);
+    EXPECT_THROW(root.at("missing"), std::out_of_range);
+    EXPECT_THROW(root["friends"][2], std::out_of_range);
+    EXPECT_THROW(root["name"].get_integer(), miniJSON::json_type_error);
+    EXPECT_THROW(root["name"]["first"], miniJSON::json_type_error);
+    EXPECT_EQ(frozen.root().to_string(), json.to_string());
+  }
+  {
+    // the frozen document does not change with the JSON node
+    json["name"] = "Gloria";
+    EXPECT_EQ(root["name"].get_string(), "Alicia");
+    // values stay valid while a copy of the document is alive
+    miniJSON::frozen_json::value friends;
+    {
+      auto copy = frozen;
+      friends = copy.root()["friends"];
+    }
+    EXPECT_EQ(friends.to_string(), R"([{"name":"David"},{"name":"Michael"}])");
+  }
+}
+
+TEST(FrozenTest, ConcurrentRead) {
+  miniJSON::json_node json(miniJSON::json_value_type::object);
+  for (int i = 0; i < 1000; i++) {
+    json.insert("key" + std::to_string(i), {i, std::to_string(i)});
+  }
+  auto frozen = json.freeze();
+  std::vector<std::thread> threads;
+  std::vector<int> found(8);
+  for (size_t t = 0; t < found.size(); t++) {
+    threads.emplace_back([&frozen, &found, t] {
+      auto root = frozen.root();
+      for (int i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(i);
+        miniJSON::frozen_json::value v;
+        if (root.find(key, &v) && v[0].get_integer() == i &&
+            v[1].get_string() == std::to_string(i)) {
+          found[t]++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int n : found) {
+    EXPECT_EQ(n, 1000);
+  }
+}
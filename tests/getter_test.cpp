@@ -1,6 +1,7 @@
 // Copyright (c) 2024 Zhichen (Joshua) Wen
 #include <gtest/gtest.h>
 
+#include <cstdint>
 #include <string>
 
 #include "./test-utils.h"
@@ -51,6 +52,14 @@ TEST(GetterTest, Number) {
     auto json = miniJSON::parse(R"(67.12)");
     EXPECT_TRUE(double_equal(json.get_double(), 67.12));
   }
+  {
+    // integers are exact in the whole range, not rounded through double
+    auto json = miniJSON::parse(
+        "[9007199254740993, 9223372036854775807, -9223372036854775808]");
+    EXPECT_EQ(json[0].get_integer(), 9007199254740993);
+    EXPECT_EQ(json[1].get_integer(), INT64_MAX);
+    EXPECT_EQ(json[2].get_integer(), INT64_MIN);
+  }
   {
     // trying to access unmatched data type value
     EXPECT_THROW(
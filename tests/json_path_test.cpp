@@ -0,0 +1,189 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+namespace {
+const char *store = R"({
+  "orders": [
+    {"id": 1, "items": [{"sku": "a1", "qty": 5}, {"sku": "a2", "qty": 12}]},
+    {"id": 2, "items": [{"sku": "b1", "qty": 20, "tags": ["x"]}]},
+    {"id": 3, "items": []}
+  ],
+  "owner": {"name": "Alicia", "id": 9},
+  "total": 37.5
+})";
+
+/*
+  Serialize the results of select
+*/
+std::vector<std::string> select(const std::string &expression,
+                                const miniJSON::json_node &root) {
+  std::vector<std::string> res;
+  for (auto j : miniJSON::json_path(expression).select(root)) {
+    res.push_back(j->to_string());
+  }
+  return res;
+}
+
+/*
+  Serialize the results of stream
+*/
+std::vector<std::string> stream(const std::string &expression,
+                                const std::string &input) {
+  std::vector<std::string> res;
+  auto result = miniJSON::json_path(expression).stream(
+      input,
+      [&res](const miniJSON::json_node &j) { res.push_back(j.to_string()); });
+  EXPECT_TRUE(result) << result.message();
+  return res;
+}
+}  // namespace
+
+TEST(JsonPathTest, Select) {
+  using v = std::vector<std::string>;
+  auto json = miniJSON::parse(store);
+  EXPECT_EQ(select("$", json), v{json.to_string()});
+  EXPECT_EQ(select("$.owner.name", json), v{R"("Alicia")"});
+  EXPECT_EQ(select("$['owner'][\"id\"]", json), v{"9"});
+  EXPECT_EQ(select("$.orders[1].id", json), v{"2"});
+  EXPECT_EQ(select("$.orders[*].id", json), (v{"1", "2", "3"}));
+  EXPECT_EQ(select("$.owner.*", json), (v{R"("Alicia")", "9"}));
+  EXPECT_EQ(select("$.orders[5]", json), v{});
+  EXPECT_EQ(select("$.missing.name", json), v{});
+  EXPECT_EQ(select("$.total[0]", json), v{});
+
+  // descendants are found in document order
+  EXPECT_EQ(select("$..id", json), (v{"1", "2", "3", "9"}));
+  EXPECT_EQ(select("$..items[0].sku", json), (v{R"("a1")", R"("b1")"}));
+  EXPECT_EQ(select("$..tags..*", json), v{R"("x")"});
+  EXPECT_EQ(select("$..[1].sku", json), v{R"("a2")"});
+
+  // results point into the tree
+  auto results = miniJSON::json_path("$.owner").select(json);
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(results[0], &json.at("owner"));
+}
+
+TEST(JsonPathTest, Filter) {
+  using v = std::vector<std::string>;
+  auto json = miniJSON::parse(store);
+  EXPECT_EQ(select("$.orders[*].items[?(@.qty > 10)].sku", json),
+            (v{R"("a2")", R"("b1")"}));
+  EXPECT_EQ(select("$..items[?(@.qty <= 5 || @.tags)].sku", json),
+            (v{R"("a1")", R"("b1")"}));
+  EXPECT_EQ(select("$..[?(@.qty >= 12 && (@.sku == 'b1'))].qty", json),
+            v{"20"});
+  EXPECT_EQ(select("$.orders[?(@.items[0].sku != \"a1\")].id", json),
+            (v{"2", "3"}));
+  EXPECT_EQ(select("$.orders[?(@.id < 2.5)].id", json), (v{"1", "2"}));
+  // values compare deeply, missing values are equal to each other
+  EXPECT_EQ(select("$.orders[?(@.items[0] == @.items[0])].id", json),
+            (v{"1", "2", "3"}));
+  EXPECT_EQ(select("$.*[?(@ == 'Alicia')]", json), v{R"("Alicia")"});
+
+  // ordering comparisons of missing values or different types are false
+  EXPECT_EQ(select("$..[?(@.tags < 1)]", json), v{});
+  EXPECT_EQ(select("$.orders[?(@.id > 'a')]", json), v{});
+  EXPECT_EQ(select("$.orders[?(@.id > -1e3)].id", json),
+            (v{"1", "2", "3"}));
+  EXPECT_EQ(select("$..[?(@.missing == null)]", json), v{});
+
+  // integers and doubles compare exactly, not through double
+  auto big = miniJSON::parse("[9007199254740992, 9007199254740993]");
+  EXPECT_EQ(select("$[?(@ > 9007199254740992.0)]", big),
+            v{"9007199254740993"});
+  EXPECT_EQ(select("$[?(@ == 9007199254740992.0)]", big),
+            v{"9007199254740992"});
+  EXPECT_EQ(select("$[?(@ < 9007199254740993)]", big), v{"9007199254740992"});
+}
+
+TEST(JsonPathTest, Stream) {
+  std::string expressions[] = {"$",
+                               "$.owner.name",
+                               "$.orders[*].id",
+                               "$..id",
+                               "$..items[0].sku",
+                               "$.orders[*].items[?(@.qty > 10)].sku",
+                               "$..[?(@.qty >= 12 && @.sku == 'b1')].qty",
+                               "$.orders[?(@.items[0].qty == 20)]",
+                               "$..*",
+                               "$.missing"};
+  auto json = miniJSON::parse(store);
+  for (auto &expression : expressions) {
+    EXPECT_EQ(stream(expression, store), select(expression, json))
+        << expression;
+  }
+  EXPECT_EQ(stream("$[1]", " [1, [2], {\"a\": 3}] "),
+            std::vector<std::string>{"[2]"});
+  EXPECT_EQ(stream("$.a", "1"), std::vector<std::string>{});
+
+  // every member with a duplicate key is visited, unlike in the parsed tree
+  const char *duplicate = R"({"a": 1, "b": {"a": 2}, "a": [3]})";
+  EXPECT_EQ(stream("$.a", duplicate), (std::vector<std::string>{"1", "[3]"}));
+  EXPECT_EQ(select("$.a", miniJSON::parse(duplicate)),
+            std::vector<std::string>{"[3]"});
+  EXPECT_EQ(stream("$..a", duplicate),
+            (std::vector<std::string>{"1", "2", "[3]"}));
+}
+
+TEST(JsonPathTest, StreamErrors) {
+  using miniJSON::parse_error_code;
+  miniJSON::json_path path("$.a");
+  std::vector<std::string> matches;
+  auto callback = [&matches](const miniJSON::json_node &j) {
+    matches.push_back(j.to_string());
+  };
+  struct {
+    const char *input;
+    parse_error_code code;
+    size_t offset;
+  } cases[] = {
+      {R"({"b": [1, 2,], "a": 1})", parse_error_code::unexpected_character, 12},
+      {R"({"a": [1, 2,]})", parse_error_code::unexpected_character, 12},
+      {R"({"b": 1 "a": 1})", parse_error_code::expected_comma_or_end, 8},
+      {R"({"b" 1})", parse_error_code::expected_colon, 5},
+      {R"({1: 1})", parse_error_code::expected_key, 1},
+      {R"({"a": 1)", parse_error_code::unexpected_end, 7},
+      {R"({"a": 1} x)", parse_error_code::trailing_characters, 9},
+      {"", parse_error_code::unexpected_end, 0},
+  };
+  for (auto &c : cases) {
+    auto result = path.stream(c.input, callback);
+    EXPECT_EQ(result.code, c.code) << c.input;
+    EXPECT_EQ(result.offset, c.offset) << c.input;
+  }
+
+  // matches before the error are reported
+  matches.clear();
+  EXPECT_FALSE(path.stream(R"({"a": 1, "b": tru})", callback));
+  EXPECT_EQ(matches, std::vector<std::string>{"1"});
+
+  // the depth limit applies to the whole input
+  miniJSON::parse_options options;
+  options.max_depth = 3;
+  auto result = path.stream(R"({"a": [[1]]})", callback, options);
+  EXPECT_TRUE(result);
+  result = path.stream(R"({"a": [[[1]]]})", callback, options);
+  EXPECT_EQ(result.code, parse_error_code::depth_exceeded);
+  EXPECT_EQ(result.offset, 8);
+  result = path.stream(R"({"b": [[[1]]]})", callback, options);
+  EXPECT_EQ(result.code, parse_error_code::depth_exceeded);
+  EXPECT_EQ(result.offset, 8);
+}
+
+TEST(JsonPathTest, CompileErrors) {
+  const char *invalid[] = {"",        "a.b",          "$.",
+                           "$[",      "$[-1]",        "$['a'",
+                           "$.a b",   "$[?(@.a)",     "$[?(@.a ==)]",
+                           "$[?(1)]", "$[?(@.a = 1)]", "$[?(@.a == x)]"};
+  for (auto expression : invalid) {
+    EXPECT_THROW(miniJSON::json_path path(expression),
+                 miniJSON::json_path_error)
+        << expression;
+  }
+  EXPECT_EQ(miniJSON::json_path("$.a").expression(), "$.a");
+}
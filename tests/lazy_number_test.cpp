@@ -0,0 +1,109 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+namespace {
+miniJSON::json_node parse_lazy(const std::string &s) {
+  miniJSON::parse_options options;
+  options.lazy_numbers = true;
+  return miniJSON::parse(s, options);
+}
+}  // namespace
+
+TEST(LazyNumberTest, Passthrough) {
+  std::vector<std::string> inputs = {
+      "[12345678901234567890123,-98765432109876543210]",
+      "[0.10000000000000000001,1.0,1e2,-0.0,2.50E-3]",
+      R"({"a":{"b":[123456789012345678,3.14159265358979323846264338]}})",
+      "[0,-1,7]",
+  };
+  for (auto &input : inputs) {
+    EXPECT_EQ(parse_lazy(input).to_string(), input);
+  }
+  miniJSON::serialize_options options;
+  options.indent = 2;
+  EXPECT_EQ(parse_lazy("[1.50]").to_string(options), "[\n  1.50\n]");
+}
+
+TEST(LazyNumberTest, Values) {
+  using miniJSON::json_value_type;
+  auto json = parse_lazy(
+      "[42, -7, 1.0, 2.5e1, 123456789012345678, 9223372036854775808, "
+      "12345678901234567890123, 1000000000000000000, 9223372036854775807, "
+      "-9223372036854775808, -9223372036854775809]");
+  EXPECT_EQ(json[0].get_type(), json_value_type::number_int);
+  EXPECT_EQ(json[0].get_integer(), 42);
+  EXPECT_EQ(json[1].get_integer(), -7);
+  // the type follows the text
+  EXPECT_EQ(json[2].get_type(), json_value_type::number_double);
+  EXPECT_EQ(json[2].get_double(), 1.0);
+  EXPECT_EQ(json[3].get_double(), 25.0);
+  // converted exactly, without going through double
+  EXPECT_EQ(json[4].get_integer(), 123456789012345678);
+  // integers that do not fit json_int_t are doubles
+  EXPECT_EQ(json[5].get_type(), json_value_type::number_double);
+  EXPECT_EQ(json[5].get_double(), 9223372036854775808.0);
+  EXPECT_EQ(json[6].get_double(), 12345678901234567890123.0);
+  EXPECT_EQ(json[6].get_number_text(), "12345678901234567890123");
+  EXPECT_EQ(json[7].get_integer(), 1000000000000000000);
+  EXPECT_EQ(json[7], miniJSON::parse("1000000000000000000"));
+  EXPECT_EQ(json[8].get_integer(), std::numeric_limits<int64_t>::max());
+  EXPECT_EQ(json[9].get_integer(), std::numeric_limits<int64_t>::min());
+  EXPECT_EQ(json[10].get_type(), json_value_type::number_double);
+  EXPECT_THROW(json[0].get_double(), miniJSON::json_type_error);
+
+  // nodes that were not parsed lazily have text too
+  EXPECT_EQ(miniJSON::json_node(12).get_number_text(), "12");
+  EXPECT_EQ(miniJSON::json_node(0.5).get_number_text(), "0.5");
+  EXPECT_THROW(miniJSON::json_node("12").get_number_text(),
+               miniJSON::json_type_error);
+}
+
+TEST(LazyNumberTest, SameAsEager) {
+  const char *input =
+      R"({"a": [1, -2, 3.5, 1e2, 0.25], "b": {"c": 1234567}})";
+  auto lazy = parse_lazy(input);
+  auto eager = miniJSON::parse(input);
+  EXPECT_EQ(lazy, eager);
+  std::hash<miniJSON::json_node> hash;
+  EXPECT_EQ(hash(lazy), hash(eager));
+  // frozen documents hold the converted values
+  auto frozen = lazy.freeze();
+  EXPECT_EQ(frozen.root()["b"]["c"].get_integer(), 1234567);
+  EXPECT_EQ(frozen.root()["a"][4].get_double(), 0.25);
+  EXPECT_EQ(miniJSON::json_path("$.a[?(@ > 2)]").select(lazy).size(), 2);
+
+  // copies share the text and are freed with the last owner
+  auto copy = lazy;
+  miniJSON::json_node assigned;
+  assigned = lazy["a"][2];
+  lazy = miniJSON::json_node();
+  EXPECT_EQ(copy, eager);
+  EXPECT_EQ(assigned.get_double(), 3.5);
+  assigned = 4;
+  EXPECT_EQ(assigned.to_string(), "4");
+  copy["a"][0] = 5;
+  EXPECT_EQ(copy["a"].to_string(), "[5,-2,3.5,1e2,0.25]");
+}
+
+TEST(LazyNumberTest, Errors) {
+  std::vector<std::string> inputs = {"1.",  "-",     "1e",   "[1.e3]", "-a",
+                                     ".5",  "1.5e+", "[01]", "1-2",    "0x10",
+                                     "1e5.", "[1 2]", "2.5E-1"};
+  miniJSON::parse_options options;
+  options.lazy_numbers = true;
+  for (auto &input : inputs) {
+    miniJSON::json_node eager, lazy;
+    auto expected = miniJSON::parse(input, &eager);
+    auto res = miniJSON::parse(input, &lazy, options);
+    EXPECT_EQ(res.code, expected.code) << input;
+    EXPECT_EQ(res.offset, expected.offset) << input;
+  }
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "miniJSON/literals.h"
+
+/*
+  Checks for the compile-time JSON literals. This file is compiled as C++20,
+  so it is built as a separate test program.
+*/
+
+using namespace miniJSON::literals;  // NOLINT(build/namespaces)
+using miniJSON::json_value_type;
+
+namespace {
+constexpr miniJSON::static_json config = R"({
+  "name": "service",
+  "retries": 3,
+  "timeout": 2.5,
+  "verbose": false,
+  "proxy": null,
+  "hosts": ["a.example", "b.example"],
+  "limits": {"rps": 1e3, "burst": -20, "ratio": 0.125}
+})"_json;
+
+// reads are constant expressions
+static_assert(config.get_type() == json_value_type::object);
+static_assert(config.size() == 7);
+static_assert(config["name"].get_string() == "service");
+static_assert(config["retries"].get_integer() == 3);
+static_assert(config["timeout"].get_double() == 2.5);
+static_assert(!config["verbose"].get_boolean());
+static_assert(config["proxy"].get_type() == json_value_type::null);
+static_assert(config["hosts"][1].get_string() == "b.example");
+static_assert(config["limits"]["rps"].get_integer() == 1000);
+static_assert(config["limits"]["burst"].get_integer() == -20);
+static_assert(config.key(6) == "limits");
+static_assert(config.contains("hosts") && !config.contains("host"));
+}  // namespace
+
+TEST(LiteralsTest, Values) {
+  EXPECT_EQ(config["hosts"].size(), 2);
+  EXPECT_EQ(config["limits"]["ratio"].get_double(), 0.125);
+  EXPECT_EQ(config[5][0].get_string(), "a.example");
+  miniJSON::static_json hosts = config;
+  EXPECT_TRUE(config.find("hosts", &hosts));
+  EXPECT_FALSE(config.find("missing", &hosts));
+  EXPECT_EQ(hosts.size(), 2);
+
+  EXPECT_THROW(config["missing"], std::out_of_range);
+  EXPECT_THROW(config["hosts"][2], std::out_of_range);
+  EXPECT_THROW(config["name"].get_integer(), miniJSON::json_type_error);
+  EXPECT_THROW(config["retries"].size(), miniJSON::json_type_error);
+
+  // the same literal is the same document
+  auto again = R"({"a": ["x"]})"_json;
+  EXPECT_EQ(again["a"][0].get_string().data(),
+            R"({"a": ["x"]})"_json["a"][0].get_string().data());
+}
+
+TEST(LiteralsTest, SameAsParse) {
+  EXPECT_EQ(config.to_json_node(), miniJSON::parse(config.to_string()));
+  std::string escaped = R"(["\"\\\/\b\f\n\r\t", "é中😀", "é😀"])";
+  auto strings = R"(["\"\\\/\b\f\n\r\t", "é中😀", "é😀"])"_json;
+  auto parsed = miniJSON::parse(escaped);
+  EXPECT_EQ(strings.to_json_node(), parsed);
+  EXPECT_EQ(strings[0].get_string(), "\"\\/\b\f\n\r\t");
+  EXPECT_EQ(std::string(strings[1].get_string()), parsed[1].get_string());
+
+  auto numbers = R"([0, -0, 12, -9223372036854775808,
+      9223372036854775807, 0.1, 1.5e-3, 1e2, 2.0, 1E400, 123456789.123456789,
+      1e-400, -7.25e-10])"_json;
+  auto expected = miniJSON::parse(R"([0, -0, 12, -9223372036854775808,
+      9223372036854775807, 0.1, 1.5e-3, 1e2, 2.0, 1E400, 123456789.123456789,
+      1e-400, -7.25e-10])");
+  ASSERT_EQ(numbers.size(), 13);
+  for (size_t i = 0; i < numbers.size(); i++) {
+    EXPECT_EQ(numbers[i].get_type(), expected[i].get_type()) << i;
+  }
+  EXPECT_EQ(numbers[3].get_integer(), INT64_MIN);
+  EXPECT_EQ(numbers[4].get_integer(), INT64_MAX);
+  EXPECT_EQ(numbers[5].get_double(), 0.1);
+  EXPECT_EQ(numbers[6].get_double(), 1.5e-3);
+  EXPECT_EQ(numbers[7].get_integer(), 100);
+  EXPECT_EQ(numbers[8].get_integer(), 2);
+  EXPECT_EQ(numbers[9].get_double(), expected[9].get_double());
+  EXPECT_NEAR(numbers[10].get_double(), 123456789.123456789, 1e-7);
+  EXPECT_EQ(numbers[11].get_integer(), 0);
+  EXPECT_EQ(numbers[12].get_double(), -7.25e-10);
+
+  // correctly rounded like strtod, halfway cases to even
+  auto rounded = R"([1.7976931348623157e308, 1.7976931348623158e308,
+      1.7976931348623159e308,
+      1.00000000000000011102230246251565404236316680908203125,
+      1.00000000000000011102230246251565404236316680908203126,
+      2.2250738585072011e-308, 4.9e-324, 2.4703282292062327e-324,
+      2.4703282292062328e-324, 0.1000000000000000055511151231257827,
+      12345678901234567890, 9007199254740993, -123.456e-7,
+      3.14159265358979323846264338327950288419716939937510582097494])"_json;
+  auto runtime = miniJSON::parse(R"([1.7976931348623157e308,
+      1.7976931348623158e308, 1.7976931348623159e308,
+      1.00000000000000011102230246251565404236316680908203125,
+      1.00000000000000011102230246251565404236316680908203126,
+      2.2250738585072011e-308, 4.9e-324, 2.4703282292062327e-324,
+      2.4703282292062328e-324, 0.1000000000000000055511151231257827,
+      12345678901234567890, 9007199254740993, -123.456e-7,
+      3.14159265358979323846264338327950288419716939937510582097494])");
+  ASSERT_EQ(rounded.size(), 14);
+  for (size_t i = 0; i < rounded.size(); i++) {
+    EXPECT_EQ(rounded[i].to_json_node(), runtime.at(i)) << i;
+    EXPECT_EQ(rounded[i].get_type(), runtime.at(i).get_type()) << i;
+  }
+  EXPECT_EQ(rounded.to_json_node(), runtime);
+  EXPECT_EQ(rounded[0].get_double(), 1.7976931348623157e308);
+  EXPECT_EQ(rounded[1].get_double(), std::numeric_limits<double>::max());
+  EXPECT_EQ(rounded[3].get_integer(), 1);
+  EXPECT_EQ(rounded[4].get_double(), 1.0000000000000002);
+  EXPECT_EQ(rounded[6].get_double(), 4.9e-324);
+  EXPECT_EQ(rounded[7].get_integer(), 0);
+  EXPECT_EQ(rounded[8].get_double(), 4.9e-324);
+  EXPECT_EQ(rounded[11].get_integer(), 9007199254740993);
+
+  // duplicate keys keep the last member, as parse() does
+  auto duplicate = R"({"a": 1, "b": 2, "a": 3})"_json;
+  EXPECT_EQ(duplicate["a"].get_integer(), 3);
+  EXPECT_EQ(duplicate.to_json_node().to_string(),
+            miniJSON::parse(R"({"a": 1, "b": 2, "a": 3})").to_string());
+  EXPECT_EQ(R"( "top" )"_json.to_string(), R"("top")");
+  EXPECT_EQ(R"([[], {}, [[]]])"_json.to_string(), "[[],{},[[]]]");
+}
@@ -0,0 +1,13 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include "miniJSON/literals.h"
+
+/*
+  A malformed JSON literal must not compile. The build of this file is
+  expected to fail.
+*/
+
+using namespace miniJSON::literals;  // NOLINT(build/namespaces)
+
+constexpr miniJSON::static_json config = R"({"retries": 3,})"_json;
+
+int main() { return static_cast<int>(config["retries"].get_integer()); }
@@ -0,0 +1,160 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(MergeTest, Merge) {
+  auto defaults = miniJSON::parse(R"({
+    "name": "service",
+    "limits": {"rps": 100, "burst": 10},
+    "hosts": ["a"],
+    "proxy": null
+  })");
+  auto layer = miniJSON::parse(R"({
+    "limits": {"rps": 200, "timeout": 2.5},
+    "hosts": ["b", "c"],
+    "proxy": {"url": "http://p"},
+    "debug": null
+  })");
+
+  auto config = defaults;
+  config.merge(layer);
+  EXPECT_EQ(config, miniJSON::parse(R"({
+    "name": "service",
+    "limits": {"rps": 200, "burst": 10, "timeout": 2.5},
+    "hosts": ["b", "c"],
+    "proxy": {"url": "http://p"},
+    "debug": null
+  })"));
+  EXPECT_EQ(layer.at("hosts").at(0).get_string(), "b");  // merged by copy
+
+  // arrays concatenated, existing values kept
+  config = defaults;
+  miniJSON::merge_options options;
+  options.arrays = miniJSON::merge_array_policy::concat;
+  options.conflicts = miniJSON::merge_conflict_policy::keep;
+  config.merge(layer, options);
+  EXPECT_EQ(config.at("limits").at("rps").get_integer(), 100);
+  EXPECT_EQ(config.at("limits").at("timeout").get_double(), 2.5);
+  EXPECT_EQ(config.at("hosts").to_string(), R"(["a","b","c"])");
+  // a null value is replaced as if it were absent
+  EXPECT_EQ(config.at("proxy").to_string(), R"({"url":"http://p"})");
+
+  // merging into an empty node
+  miniJSON::json_node empty;
+  empty.merge(layer, options);
+  EXPECT_EQ(empty, layer);
+  miniJSON::json_node scalar(3);
+  scalar.merge(layer);
+  EXPECT_EQ(scalar, layer);
+}
+
+TEST(MergeTest, Conflicts) {
+  auto base = miniJSON::parse(R"({"a": {"b": 1, "c": [1]}, "d": "x"})");
+  miniJSON::merge_options options;
+  options.conflicts = miniJSON::merge_conflict_policy::error;
+
+  // equal values and new members do not conflict
+  auto json = base;
+  json.merge(miniJSON::parse(R"({"a": {"b": 1, "e": 2}, "d": "x"})"), options);
+  EXPECT_EQ(json.at("a").at("e").get_integer(), 2);
+
+  json = base;
+  try {
+    json.merge(miniJSON::parse(R"({"a": {"e": 2, "c/~": 3, "c": [2]}})"),
+               options);
+    FAIL();
+  } catch (const miniJSON::json_merge_error &e) {
+    EXPECT_STREQ(e.what(), "json merge error: conflicting values at \"/a/c\"");
+  }
+  EXPECT_EQ(json, base);  // nothing is modified
+  EXPECT_THROW(json.merge(miniJSON::parse(R"({"d": {"x": 1}})"), options),
+               miniJSON::json_merge_error);
+  EXPECT_EQ(json, base);
+
+  // concatenated arrays do not conflict
+  options.arrays = miniJSON::merge_array_policy::concat;
+  json.merge(miniJSON::parse(R"({"a": {"c": [2]}})"), options);
+  EXPECT_EQ(json.at("a").at("c").to_string(), "[1,2]");
+}
+
+TEST(MergeTest, MoveSemantics) {
+  auto target = miniJSON::parse(R"({"keep": 1, "list": [{"x": 1}]})");
+  auto source = miniJSON::parse(
+      R"({"tree": {"deep": {"leaf": "value"}}, "list": [{"y": [2]}]})");
+  const miniJSON::json_node *deep = &source.at("tree").at("deep");
+  const miniJSON::json_node *element = &source.at("list").at(0).at("y");
+
+  miniJSON::merge_options options;
+  options.arrays = miniJSON::merge_array_policy::concat;
+  target.merge(std::move(source), options);
+  // the descendants are taken over, not copied
+  EXPECT_EQ(&target.at("tree").at("deep"), deep);
+  EXPECT_EQ(&target.at("list").at(1).at("y"), element);
+  EXPECT_EQ(target.to_string(),
+            R"({"keep":1,"list":[{"x":1},{"y":[2]}],)"
+            R"("tree":{"deep":{"leaf":"value"}}})");
+
+  // moving from a shared copy leaves the other copy alone
+  auto original = miniJSON::parse(R"({"a": {"b": [1, 2]}, "c": 3})");
+  auto copy = original.share();
+  miniJSON::json_node merged;
+  merged.merge(std::move(copy));
+  EXPECT_EQ(merged, original);
+  EXPECT_EQ(original.to_string(), R"({"a":{"b":[1,2]},"c":3})");
+}
+
+TEST(MergeTest, ExtractAndSplice) {
+  auto doc = miniJSON::parse(
+      R"({"user": {"name": "Ann", "roles": ["a", "b"]}, "ids": [1, 2, 3]})");
+  const miniJSON::json_node *roles = &doc.at("user").at("roles");
+
+  // extract moves the value out
+  auto user = doc.extract("user");
+  EXPECT_EQ(&user.at("roles"), roles);
+  EXPECT_EQ(doc.to_string(), R"({"ids":[1,2,3]})");
+  EXPECT_EQ(doc["ids"].extract(1).get_integer(), 2);
+  EXPECT_EQ(doc.at("ids").to_string(), "[1,3]");
+  EXPECT_THROW(doc.extract("user"), std::out_of_range);
+  EXPECT_THROW(doc["ids"].extract(2), std::out_of_range);
+  EXPECT_THROW(doc["ids"].extract("x"), miniJSON::json_type_error);
+  EXPECT_THROW(doc.extract(0), miniJSON::json_type_error);
+
+  // splice moves the node between documents
+  miniJSON::json_node other;
+  other.splice("profile", user, "roles");
+  EXPECT_EQ(&other.at("profile"), roles);
+  EXPECT_EQ(user.to_string(), R"({"name":"Ann"})");
+  other.splice("profile", user, "name");  // replaces the existing member
+  EXPECT_EQ(other.to_string(), R"({"profile":"Ann"})");
+  EXPECT_THROW(other.splice("x", user, "name"), std::out_of_range);
+  EXPECT_THROW(doc["ids"].splice("x", other, "profile"),
+               miniJSON::json_type_error);
+  EXPECT_EQ(other.to_string(), R"({"profile":"Ann"})");
+
+  // elements of arrays, within and between arrays
+  auto list = miniJSON::parse("[0, 1, 2, 3]");
+  list.splice(0, list, 3);
+  EXPECT_EQ(list.to_string(), "[3,0,1,2]");
+  list.splice(3, list, 0);
+  EXPECT_EQ(list.to_string(), "[0,1,2,3]");
+  EXPECT_THROW(list.splice(4, list, 0), std::out_of_range);
+  miniJSON::json_node target;
+  target.splice(0, list, 2);
+  target.splice(1, list, 0);
+  EXPECT_EQ(target.to_string(), "[2,0]");
+  EXPECT_EQ(list.to_string(), "[1,3]");
+  EXPECT_THROW(target.splice(3, list, 0), std::out_of_range);
+  EXPECT_EQ(list.to_string(), "[1,3]");
+
+  // shared copies are not affected
+  auto original = miniJSON::parse(R"({"a": [1], "b": {"c": 2}})");
+  auto copy = original.share();
+  auto b = copy.extract("b");
+  b.splice("a", copy, "a");
+  EXPECT_EQ(b.to_string(), R"({"c":2,"a":[1]})");
+  EXPECT_EQ(copy.to_string(), "{}");
+  EXPECT_EQ(original.to_string(), R"({"a":[1],"b":{"c":2}})");
+}
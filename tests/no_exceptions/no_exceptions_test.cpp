@@ -0,0 +1,45 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <cstdio>
+#include <string>
+
+#include "miniJSON/miniJSON.h"
+
+/*
+  Checks for the exception-free parsing API. This file is compiled with
+  -fno-exceptions, so it is a plain program instead of a gtest suite.
+*/
+
+static int failures = 0;
+
+#define EXPECT(condition)                                                    \
+  do {                                                                       \
+    if (!(condition)) {                                                      \
+      std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition);   \
+      failures++;                                                            \
+    }                                                                        \
+  } while (0)
+
+int main() {
+  {
+    miniJSON::json_node json;
+    auto res = miniJSON::parse(R"({"a":[1,2,{"b":null}]})", &json);
+    EXPECT(res);
+    EXPECT(json["a"][2]["b"].get_type() == miniJSON::json_value_type::null);
+    EXPECT(json.to_string() == R"({"a":[1,2,{"b":null}]})");
+  }
+  {
+    miniJSON::json_node json = 1;
+    auto res = miniJSON::parse(R"({"a":[1,2,{"b":nul}]})", &json);
+    EXPECT(!res);
+    EXPECT(res.code == miniJSON::parse_error_code::invalid_literal);
+    EXPECT(res.offset == 15);
+    EXPECT(json.get_integer() == 1);
+  }
+  {
+    miniJSON::json_node json;
+    auto res = miniJSON::parse("[1,2", &json);
+    EXPECT(res.code == miniJSON::parse_error_code::unexpected_end);
+    EXPECT(res.offset == 4);
+  }
+  return failures == 0 ? 0 : 1;
+}
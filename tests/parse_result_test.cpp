@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(ParseResultTest, Success) {
+  {
+    miniJSON::json_node json;
+    auto res = miniJSON::parse(R"({"a":[true,null,"b",1.5]})", &json);
+    EXPECT_TRUE(res);
+    EXPECT_EQ(res.code, miniJSON::parse_error_code::none);
+    EXPECT_EQ(json.to_string(), R"({"a":[true,null,"b",1.5]})");
+  }
+}
+
+TEST(ParseResultTest, Error) {
+  using code = miniJSON::parse_error_code;
+  struct error_case {
+    std::string json;
+    miniJSON::parse_error_code code;
+    size_t offset;
+  };
+  std::vector<error_case> cases = {
+      {"", code::unexpected_end, 0},
+      {"  ", code::unexpected_end, 2},
+      {"[", code::unexpected_end, 1},
+      {"[1,", code::unexpected_end, 3},
+      {R"({"a":1)", code::unexpected_end, 6},
+      {R"({"a":1,)", code::unexpected_end, 7},
+      {"tru", code::invalid_literal, 0},
+      {"[1, nul]", code::invalid_literal, 4},
+      {"]", code::unexpected_character, 0},
+      {"[1,]", code::unexpected_character, 3},
+      {"[1 2]", code::expected_comma_or_end, 3},
+      {R"({"a":1 "b":2})", code::expected_comma_or_end, 7},
+      {R"({a:1})", code::expected_key, 1},
+      {R"({"a" 1})", code::expected_colon, 5},
+      {"--1.2", code::invalid_number, 0},
+      {"-1..2", code::invalid_number, 3},
+      {"-1.", code::invalid_number, 3},
+      {R"("abc\xdef")", code::invalid_escape, 5},
+      {R"("abc)", code::unterminated_string, 4},
+      {"null .", code::trailing_characters, 5},
+  };
+  for (auto &c : cases) {
+    miniJSON::json_node json = 1;
+    auto res = miniJSON::parse(c.json, &json);
+    EXPECT_FALSE(res) << c.json;
+    EXPECT_EQ(res.code, c.code) << c.json << ": " << res.message();
+    EXPECT_EQ(res.offset, c.offset) << c.json;
+    // result is not assigned on failure
+    EXPECT_EQ(json.get_integer(), 1);
+  }
+}
+
+TEST(ParseResultTest, Exception) {
+  {
+    // exception carries the kind of error and its offset
+    try {
+      miniJSON::parse(R"({"a":[1,2,{"b":nul}]})");
+      FAIL();
+    } catch (const miniJSON::json_parse_error &e) {
+      EXPECT_EQ(e.result().code, miniJSON::parse_error_code::invalid_literal);
+      EXPECT_EQ(e.result().offset, 15);
+      EXPECT_EQ(std::string(e.what()),
+                "json parse error: invalid literal at offset 15");
+    }
+  }
+}
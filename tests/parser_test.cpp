@@ -0,0 +1,52 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(ParserTest, Reuse) {
+  {
+    // parse several documents in a row with the same parser
+    miniJSON::parser parser;
+    std::vector<std::string> documents = {
+        R"({"id":1,"tags":["a","b"],"score":1.5})",
+        R"([[1,[2,[3]]],{"k":"v"}])",
+        R"("text")",
+        R"({"id":2,"tags":[],"score":-3})",
+    };
+    for (int round = 0; round < 3; round++) {
+      for (auto &document : documents) {
+        EXPECT_EQ(parser.parse(document).to_string(), document);
+      }
+    }
+  }
+  {
+    // the state of a failed parse does not leak into the next one
+    miniJSON::parser parser;
+    miniJSON::json_node json;
+    auto res = parser.parse(R"({"a":[1,2,{"b":nul}]})", &json);
+    EXPECT_EQ(res.code, miniJSON::parse_error_code::invalid_literal);
+    EXPECT_EQ(res.offset, 15);
+    res = parser.parse(R"({"a":[1,2,{"b":null}]})", &json);
+    EXPECT_TRUE(res);
+    EXPECT_EQ(json.to_string(), R"({"a":[1,2,{"b":null}]})");
+    res = parser.parse("[1,", &json);
+    EXPECT_EQ(res.code, miniJSON::parse_error_code::unexpected_end);
+    EXPECT_EQ(json.to_string(), R"({"a":[1,2,{"b":null}]})");
+  }
+  {
+    // options are kept by the parser
+    miniJSON::parse_options options;
+    options.max_depth = 2;
+    miniJSON::parser parser(options);
+    EXPECT_EQ(parser.options().max_depth, 2);
+    EXPECT_EQ(parser.parse("[[1]]").to_string(), "[[1]]");
+    EXPECT_THROW(parser.parse("[[[1]]]"), miniJSON::json_parse_error);
+    // while parse() uses the options of each call
+    EXPECT_EQ(miniJSON::parse("[[[1]]]").to_string(), "[[[1]]]");
+    miniJSON::json_node json;
+    EXPECT_FALSE(miniJSON::parse("[[[1]]]", &json, options));
+  }
+}
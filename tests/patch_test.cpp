@@ -0,0 +1,168 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(PatchTest, Operations) {
+  {
+    // add
+    auto json = miniJSON::parse(R"({"a":[1,3],"b":{}})");
+    json.apply_patch(R"([
+      {"op": "add", "path": "/a/1", "value": 2},
+      {"op": "add", "path": "/a/-", "value": 4},
+      {"op": "add", "path": "/b/c~1d", "value": {"e": null}},
+      {"op": "add", "path": "/a/0", "value": 0}
+    ])");
+    EXPECT_EQ(json.to_string(), R"({"a":[0,1,2,3,4],"b":{"c/d":{"e":null}}})");
+  }
+  {
+    // remove and replace
+    auto json = miniJSON::parse(R"({"a":[1,2,3],"b":"x","c~":true})");
+    json.apply_patch(R"([
+      {"op": "remove", "path": "/a/1"},
+      {"op": "remove", "path": "/b"},
+      {"op": "replace", "path": "/c~0", "value": false}
+    ])");
+    EXPECT_EQ(json.to_string(), R"({"a":[1,3],"c~":false})");
+  }
+  {
+    // move and copy
+    auto json = miniJSON::parse(R"({"a":{"b":[1,2]},"c":[]})");
+    json.apply_patch(R"([
+      {"op": "move", "from": "/a/b", "path": "/c/0"},
+      {"op": "copy", "from": "/c/0", "path": "/a/d"},
+      {"op": "add", "path": "/a/d/-", "value": 3}
+    ])");
+    EXPECT_EQ(json.to_string(), R"({"a":{"d":[1,2,3]},"c":[[1,2]]})");
+  }
+  {
+    // test, including integer and double values
+    auto json = miniJSON::parse(R"({"a":[1,{"b":"c"}],"d":2.0})");
+    json.apply_patch(R"([
+      {"op": "test", "path": "/a", "value": [1.0, {"b": "c"}]},
+      {"op": "test", "path": "/d", "value": 2}
+    ])");
+    EXPECT_THROW(
+        { json.apply_patch(R"([{"op":"test","path":"/d","value":3}])"); },
+        miniJSON::json_patch_error);
+  }
+  {
+    // replace the root
+    auto json = miniJSON::parse(R"({"a":{"b":1}})");
+    json.apply_patch(R"([{"op":"move","from":"/a","path":""}])");
+    EXPECT_EQ(json.to_string(), R"({"b":1})");
+    json.apply_patch(R"([{"op":"replace","path":"","value":[1]}])");
+    EXPECT_EQ(json.to_string(), R"([1])");
+  }
+  {
+    // values are moved out of a rvalue patch
+    miniJSON::json_node json = {{"a", 1}};
+    auto patch = miniJSON::parse(
+        R"([{"op":"add","path":"/b","value":{"c":[1,2,3]}}])");
+    json.apply_patch(std::move(patch));
+    EXPECT_EQ(json.to_string(), R"({"a":1,"b":{"c":[1,2,3]}})");
+  }
+  {
+    // a patch passed as lvalue is left unchanged
+    miniJSON::json_node json = {{"a", 1}};
+    auto patch = miniJSON::parse(R"([{"op":"add","path":"/b","value":[1]}])");
+    json.apply_patch(patch);
+    json["b"].push_back(2);
+    EXPECT_EQ(json.to_string(), R"({"a":1,"b":[1,2]})");
+    EXPECT_EQ(patch.to_string(), R"([{"op":"add","path":"/b","value":[1]}])");
+  }
+  {
+    // indices that overflow size_t do not wrap around
+    auto json = miniJSON::parse(R"([1,2])");
+    for (auto path : {"/18446744073709551616", "/18446744073709551617",
+                      "/184467440737095516160"}) {
+      auto op = miniJSON::parse(R"([{"op":"replace","value":3}])");
+      op[0]["path"] = path;
+      EXPECT_THROW(json.apply_patch(op), miniJSON::json_patch_error) << path;
+      op[0]["op"] = "remove";
+      EXPECT_THROW(json.apply_patch(op), miniJSON::json_patch_error) << path;
+    }
+    EXPECT_EQ(json.to_string(), "[1,2]");
+  }
+}
+
+TEST(PatchTest, Rollback) {
+  const std::string original = R"({"a":{"b":[1,2],"c":"x"},"d":[{"e":1}]})";
+  const char *patches[] = {
+      // failing test
+      R"([{"op":"add","path":"/a/z","value":1},
+          {"op":"remove","path":"/a/b/0"},
+          {"op":"test","path":"/a/c","value":"y"}])",
+      // path does not exist
+      R"([{"op":"replace","path":"/a/c","value":[]},
+          {"op":"remove","path":"/d/0/e"},
+          {"op":"add","path":"/x/y","value":1}])",
+      // move into its own child
+      R"([{"op":"move","from":"/a/b","path":"/d/0/b"},
+          {"op":"add","path":"/d/-","value":2},
+          {"op":"move","from":"/d","path":"/d/0"}])",
+      // root replaced before failure
+      R"([{"op":"move","from":"/a","path":""},
+          {"op":"copy","from":"/b","path":"/f"},
+          {"op":"add","path":"/f/3","value":1}])",
+      // invalid operations
+      R"([{"op":"remove","path":"/a/c"},{"op":"unknown","path":""}])",
+      R"([{"op":"add","path":"/a/b/01","value":1}])",
+      R"([{"op":"add","path":"a","value":1}])",
+      R"([{"op":"add","path":"/a/b/-"}])",
+      R"([{"op":"copy","from":"/q","path":"/r"}])",
+      R"([{"op":"remove","path":""}])",
+      R"([1])",
+      R"({"op":"add","path":"/a","value":1})",
+  };
+  for (auto patch : patches) {
+    auto json = miniJSON::parse(original);
+    EXPECT_THROW({ json.apply_patch(patch); }, miniJSON::json_patch_error);
+    EXPECT_EQ(json.to_string(), original);
+  }
+  {
+    // shared copies are not affected by a failed patch
+    auto json = miniJSON::parse(original);
+    auto copy = json.share();
+    EXPECT_THROW(
+        {
+          copy.apply_patch(R"([{"op":"remove","path":"/a/b/0"},
+                               {"op":"remove","path":"/a/b/5"}])");
+        },
+        miniJSON::json_patch_error);
+    EXPECT_EQ(json.to_string(), original);
+    EXPECT_EQ(copy.to_string(), original);
+  }
+}
+
+TEST(PatchTest, MergePatch) {
+  {
+    auto json = miniJSON::parse(
+        R"({"title":"Goodbye!","author":{"givenName":"John","familyName":"Doe"},"tags":["example","sample"],"content":"This will be unchanged"})");
+    json.apply_merge_patch(
+        R"({"title":"Hello!","phoneNumber":"+01-123-456-7890","author":{"familyName":null},"tags":["example"]})");
+    EXPECT_EQ(
+        json.to_string(),
+        R"({"title":"Hello!","author":{"givenName":"John"},"tags":["example"],"content":"This will be unchanged","phoneNumber":"+01-123-456-7890"})");
+  }
+  {
+    // non-object patch replaces the target
+    auto json = miniJSON::parse(R"({"a":"b"})");
+    json.apply_merge_patch(R"(["c"])");
+    EXPECT_EQ(json.to_string(), R"(["c"])");
+    json.apply_merge_patch(R"({"a":{"bb":{"ccc":null}}})");
+    EXPECT_EQ(json.to_string(), R"({"a":{"bb":{}}})");
+  }
+  {
+    // merging a json node
+    auto json = miniJSON::parse(R"({"a":1})");
+    miniJSON::json_node patch = {{"a", nullptr}, {"b", {1, 2}}};
+    json.apply_merge_patch(patch);
+    EXPECT_EQ(json.to_string(), R"({"b":[1,2]})");
+    json.apply_merge_patch(std::move(patch));
+    EXPECT_EQ(json.to_string(), R"({"b":[1,2]})");
+  }
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "./alloc-utils.h"
+#include "miniJSON/miniJSON.h"
+
+namespace {
+const char *user = R"({
+  "id": 7,
+  "name": {"first": "Alicia", "last": "Wen"},
+  "bio": "a long text that is never needed",
+  "items": [
+    {"sku": "a1", "qty": 5, "meta": {"x": [1, 2, 3]}},
+    "note",
+    {"qty": 2},
+    [{"sku": "n1"}]
+  ],
+  "stats": 3
+})";
+}  // namespace
+
+TEST(ProjectionTest, Fields) {
+  {
+    auto json = miniJSON::parse(user, miniJSON::field_mask{"/id", "/name"});
+    EXPECT_EQ(json.to_string(),
+              R"({"id":7,"name":{"first":"Alicia","last":"Wen"}})");
+  }
+  {
+    // ancestors only keep the selected members
+    auto json = miniJSON::parse(user, miniJSON::field_mask{"/name/last"});
+    EXPECT_EQ(json.to_string(), R"({"name":{"last":"Wen"}})");
+  }
+  {
+    // arrays are projected element by element, scalars are skipped
+    auto json = miniJSON::parse(user, miniJSON::field_mask{"/items/sku"});
+    EXPECT_EQ(json.to_string(),
+              R"({"items":[{"sku":"a1"},{},[{"sku":"n1"}]]})");
+  }
+  {
+    // a scalar where the mask expects an object is skipped
+    auto json = miniJSON::parse(user, miniJSON::field_mask{"/stats/count"});
+    EXPECT_EQ(json.to_string(), "{}");
+  }
+  {
+    // a field selected together with its descendants is parsed completely
+    miniJSON::field_mask mask;
+    mask.add("/items/meta/x").add("/items/meta").add("/missing");
+    auto json = miniJSON::parse(user, mask);
+    EXPECT_EQ(json.to_string(),
+              R"({"items":[{"meta":{"x":[1,2,3]}},{},[{}]]})");
+  }
+  {
+    // escaped keys in pointers and in the input
+    auto json = miniJSON::parse(R"({"a/b":1,"c~d":2,"e":3,"f":4})",
+                                miniJSON::field_mask{"/a~1b", "/c~0d", "/e"});
+    EXPECT_EQ(json.to_string(), R"({"a/b":1,"c~d":2,"e":3})");
+  }
+  {
+    // the empty pointer selects everything, no field selects nothing
+    EXPECT_EQ(miniJSON::parse(user, miniJSON::field_mask{""}),
+              miniJSON::parse(user));
+    EXPECT_EQ(miniJSON::parse(user, miniJSON::field_mask()).to_string(),
+              "{}");
+    EXPECT_EQ(miniJSON::parse("[1,2]", miniJSON::field_mask()).to_string(),
+              "[]");
+    EXPECT_EQ(miniJSON::parse("12", miniJSON::field_mask()).to_string(), "12");
+  }
+  EXPECT_THROW(miniJSON::field_mask{"a"}, miniJSON::json_path_error);
+  EXPECT_THROW(miniJSON::field_mask{"/a~2"}, miniJSON::json_path_error);
+}
+
+TEST(ProjectionTest, Errors) {
+  using miniJSON::parse_error_code;
+  miniJSON::field_mask mask{"/a"};
+  // skipped parts are validated as thoroughly as the rest
+  struct {
+    const char *input;
+    parse_error_code code;
+    size_t offset;
+  } cases[] = {
+      {R"({"b": [1, 2,], "a": 1})", parse_error_code::unexpected_character, 12},
+      {R"({"b": "\x", "a": 1})", parse_error_code::invalid_escape, 8},
+      {R"({"b": 1., "a": 1})", parse_error_code::invalid_number, 8},
+      {R"({"b": nul, "a": 1})", parse_error_code::invalid_literal, 6},
+      {R"({"b": {"c" 1}, "a": 1})", parse_error_code::expected_colon, 11},
+      {R"({"b": [1)", parse_error_code::unexpected_end, 8},
+      {R"({"a": 1, "b": 2} x)", parse_error_code::trailing_characters, 17},
+  };
+  for (auto &c : cases) {
+    miniJSON::json_node json;
+    auto result = miniJSON::parse(c.input, mask, &json);
+    EXPECT_EQ(result.code, c.code) << c.input;
+    EXPECT_EQ(result.offset, c.offset) << c.input;
+    EXPECT_EQ(json.get_type(), miniJSON::json_value_type::null);
+  }
+
+  // the depth limit applies to the skipped parts too
+  miniJSON::parse_options options;
+  options.max_depth = 2;
+  miniJSON::json_node json;
+  EXPECT_TRUE(miniJSON::parse(R"({"b": [1], "a": [2]})", mask, &json, options));
+  auto result =
+      miniJSON::parse(R"({"b": [[1]], "a": 1})", mask, &json, options);
+  EXPECT_EQ(result.code, parse_error_code::depth_exceeded);
+  EXPECT_EQ(result.offset, 7);
+}
+
+TEST(ProjectionTest, Allocations) {
+  std::string s = "{\"id\":1,\"rows\":[";
+  for (int i = 0; i < 100; i++) {
+    s += i == 0 ? "" : ",";
+    s += R"({"name":"a string long enough to be allocated","v":[1,2,3]})";
+  }
+  s += "]}";
+  miniJSON::parser parser;
+  miniJSON::field_mask mask{"/id"};
+  parser.parse(s, mask);  // grow the buffers of the parser
+  size_t full, projected;
+  miniJSON::json_node json;
+  {
+    allocation_counter counter;
+    parser.parse(s);
+    full = counter.allocations();
+  }
+  {
+    allocation_counter counter;
+    json = parser.parse(s, mask);
+    projected = counter.allocations();
+  }
+  EXPECT_EQ(json.to_string(), R"({"id":1})");
+  // the nodes, the object with its storage and the key of the member
+  EXPECT_GT(full, 100 * 6);
+  EXPECT_LE(projected, 5);
+}
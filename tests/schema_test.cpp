@@ -0,0 +1,227 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+namespace {
+const char *user_schema = R"({
+  "$schema": "https://json-schema.org/draft/2020-12/schema",
+  "title": "user",
+  "type": "object",
+  "required": ["id", "name"],
+  "properties": {
+    "id": {"type": "integer", "minimum": 1},
+    "name": {"type": "string", "minLength": 1, "maxLength": 8,
+             "pattern": "^[a-z]+$"},
+    "score": {"type": "number", "exclusiveMaximum": 100},
+    "tags": {"type": "array", "items": {"enum": ["a", "b", "c"]},
+             "maxItems": 3},
+    "meta": {"type": ["object", "null"], "additionalProperties": false,
+             "properties": {"v": {"const": 1}}}
+  }
+})";
+
+/*
+  Check that the document is rejected by validate() with the path and the
+  message, and by parse(s, schema) at the offset of the rejected value
+*/
+void expect_invalid(const miniJSON::json_schema &schema, const std::string &s,
+                    const std::string &path, const std::string &message,
+                    size_t offset) {
+  auto res = schema.validate(miniJSON::parse(s));
+  EXPECT_FALSE(res) << s;
+  EXPECT_EQ(res.path, path) << s;
+  EXPECT_EQ(res.message, message) << s;
+  miniJSON::json_node json(7);
+  auto error = miniJSON::parse(s, schema, &json);
+  EXPECT_EQ(error.code, miniJSON::parse_error_code::schema_violation) << s;
+  EXPECT_EQ(error.offset, offset) << s;
+  EXPECT_EQ(json.get_integer(), 7) << s;
+}
+}  // namespace
+
+TEST(SchemaTest, Validate) {
+  miniJSON::json_schema schema(user_schema);
+  for (auto s : {R"({"id": 1, "name": "ann"})",
+                 R"({"id": 2, "name": "bo", "score": 99.5, "tags": ["a"],
+                     "meta": {"v": 1}, "extra": [1, {}]})",
+                 R"({"id": 3.0, "name": "cy", "meta": null, "tags": []})"}) {
+    auto json = miniJSON::parse(s);
+    EXPECT_TRUE(schema.validate(json)) << schema.validate(json).message;
+    miniJSON::json_node parsed;
+    EXPECT_TRUE(miniJSON::parse(s, schema, &parsed)) << s;
+    EXPECT_EQ(parsed, json);
+  }
+
+  std::string s = R"({"id": 0, "name": "ann"})";
+  expect_invalid(schema, s, "/id", "must be >= 1", s.find('0'));
+  s = R"({"id": 1.5, "name": "ann"})";
+  expect_invalid(schema, s, "/id", "expected integer", s.find('1'));
+  s = R"({"id": "1", "name": "ann"})";
+  expect_invalid(schema, s, "/id", "expected integer", s.find("\"1"));
+  s = R"({"id": 1})";
+  expect_invalid(schema, s, "", "missing required property \"name\"", 0);
+  s = R"({"id": 1, "name": "Ann"})";
+  expect_invalid(schema, s, "/name", "must match the pattern \"^[a-z]+$\"",
+                 s.find("\"Ann"));
+  s = R"({"id": 1, "name": "abcdefghi"})";
+  expect_invalid(schema, s, "/name", "must have at most 8 characters",
+                 s.find("\"abc"));
+  s = R"({"id": 1, "name": "ann", "score": 100})";
+  expect_invalid(schema, s, "/score", "must be < 100", s.find("100"));
+  s = R"({"id": 1, "name": "ann", "tags": ["a", "d"]})";
+  expect_invalid(schema, s, "/tags/1", "must be one of the enum values",
+                 s.find("\"d"));
+  s = R"({"id": 1, "name": "ann", "tags": ["a", "b", "c", "a"]})";
+  expect_invalid(schema, s, "/tags", "must have at most 3 items",
+                 s.find('['));
+  s = R"({"id": 1, "name": "ann", "meta": {"v": 1, "w/x": 2}})";
+  expect_invalid(schema, s, "/meta/w~1x", "property \"w/x\" is not allowed",
+                 s.find("\"w/x"));
+  s = R"({"id": 1, "name": "ann", "meta": {"v": 2}})";
+  expect_invalid(schema, s, "/meta/v", "must be equal to the const value",
+                 s.find('2'));
+  s = R"({"id": 1, "name": "ann", "meta": []})";
+  expect_invalid(schema, s, "/meta", "expected null or object", s.find('['));
+  s = "[1]";
+  expect_invalid(schema, s, "", "expected object", 0);
+
+  // nodes built in code
+  miniJSON::json_node json = {{"id", 5}, {"name", "dee"}};
+  EXPECT_TRUE(schema.validate(json));
+  json["tags"] = {"a", "b", 3};
+  auto res = schema.validate(json);
+  EXPECT_EQ(res.path, "/tags/2");
+}
+
+TEST(SchemaTest, Keywords) {
+  {
+    miniJSON::json_schema schema(R"({"maxLength": 2, "minLength": 2})");
+    EXPECT_TRUE(schema.validate(miniJSON::parse(R"("é中")")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse(R"("é中x")")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse(R"("x")")));
+    // keywords for other types do not apply
+    EXPECT_TRUE(schema.validate(miniJSON::parse("[1, 2, 3]")));
+  }
+  {
+    miniJSON::json_schema schema(R"({"type": "integer", "maximum": 1e300})");
+    EXPECT_TRUE(schema.validate(miniJSON::parse("1e300")));
+    EXPECT_TRUE(schema.validate(miniJSON::parse("-4")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse("0.5")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse("1e301")));
+    EXPECT_EQ(schema.validate(miniJSON::parse("1e301")).message,
+              "must be <= 1e+300");
+  }
+  {
+    // integer bounds are compared exactly, not through double
+    miniJSON::json_schema schema(R"({"maximum": 9007199254740992,
+                                     "exclusiveMinimum": -9007199254740993})");
+    EXPECT_TRUE(schema.validate(miniJSON::parse("9007199254740992")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse("9007199254740993")));
+    EXPECT_TRUE(schema.validate(miniJSON::parse("-9007199254740992")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse("-9007199254740993")));
+    EXPECT_TRUE(schema.validate(miniJSON::parse("9007199254740992.0")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse("9007199254740994.0")));
+    miniJSON::json_node json;
+    EXPECT_FALSE(miniJSON::parse("9007199254740993", schema, &json));
+  }
+  {
+    miniJSON::json_schema schema(
+        R"({"minProperties": 1, "maxProperties": 2, "minItems": 1})");
+    EXPECT_FALSE(schema.validate(miniJSON::parse("{}")));
+    EXPECT_TRUE(schema.validate(miniJSON::parse(R"({"a": 1})")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse(R"({"a":1,"b":2,"c":3})")));
+    EXPECT_FALSE(schema.validate(miniJSON::parse("[]")));
+  }
+  {
+    // boolean schemas
+    miniJSON::json_schema any("true");
+    miniJSON::json_schema nothing("false");
+    miniJSON::json_schema empty_array(R"({"items": false})");
+    auto json = miniJSON::parse(R"({"a": [null]})");
+    EXPECT_TRUE(any.validate(json));
+    EXPECT_EQ(nothing.validate(json).message, "no value is allowed here");
+    EXPECT_TRUE(empty_array.validate(miniJSON::parse("[]")));
+    EXPECT_EQ(empty_array.validate(miniJSON::parse("[1]")).path, "/0");
+    miniJSON::json_node parsed;
+    EXPECT_EQ(miniJSON::parse(" [[], 1]", empty_array, &parsed).offset, 2);
+    EXPECT_EQ(miniJSON::parse(" 1", nothing, &parsed).offset, 1);
+    EXPECT_TRUE(miniJSON::parse(" []", empty_array, &parsed));
+  }
+}
+
+TEST(SchemaTest, ParseWithSchema) {
+  miniJSON::json_schema schema(user_schema);
+  // syntax errors before a violation are reported as such
+  miniJSON::json_node json;
+  auto res = miniJSON::parse(R"({"id": 1, "name": "ann", "tags": [1,)", schema,
+                             &json);
+  EXPECT_EQ(res.code, miniJSON::parse_error_code::schema_violation);
+  res = miniJSON::parse(R"({"id": 1, "name": "ann", "tags": ["a",)", schema,
+                        &json);
+  EXPECT_EQ(res.code, miniJSON::parse_error_code::unexpected_end);
+  res = miniJSON::parse(R"({"id": 1, "name": "ann"} x)", schema, &json);
+  EXPECT_EQ(res.code, miniJSON::parse_error_code::trailing_characters);
+
+  // the throwing overload, lazy numbers, and parsers reused without schema
+  EXPECT_THROW(miniJSON::parse("{}", schema), miniJSON::json_parse_error);
+  miniJSON::parse_options options;
+  options.lazy_numbers = true;
+  json = miniJSON::parse(R"({"id": 12, "name": "x", "score": 1e1})", schema,
+                         options);
+  EXPECT_EQ(json.at("id").get_number_text(), "12");
+  EXPECT_THROW(miniJSON::parse(R"({"id": 0.9, "name": "x"})", schema, options),
+               miniJSON::json_parse_error);
+  EXPECT_NO_THROW(miniJSON::parse("{}"));
+  miniJSON::parser parser;
+  EXPECT_FALSE(parser.parse("{}", schema, &json));
+  EXPECT_TRUE(parser.parse("{}", &json));
+  EXPECT_EQ(parser.parse(R"({"id": 4, "name": "abc"})", schema).at("id"), 4);
+
+  // parsing with the schema agrees with validating the parsed node
+  std::vector<std::string> inputs = {
+      R"({"id": 1, "name": "a", "tags": ["c", "b", "a"]})",
+      R"({"id": 1, "name": "a", "tags": ["c", "b", "a", "d"]})",
+      R"({"name": "a", "id": 9, "meta": {}})",
+      R"({"name": "a", "id": -9, "meta": {}})",
+      R"({"name": "a", "id": 9, "name": "A"})",
+      R"({"name": "a", "id": 9, "meta": {"v": 1.0}})",
+      R"({"name": "a", "id": 9, "meta": {"v": true}})",
+      R"({"name": "a", "id": 9, "score": -1e9})"};
+  for (auto &s : inputs) {
+    EXPECT_EQ(static_cast<bool>(miniJSON::parse(s, schema, &json)),
+              static_cast<bool>(schema.validate(miniJSON::parse(s))))
+        << s;
+  }
+}
+
+TEST(SchemaTest, InvalidSchema) {
+  using error = miniJSON::json_schema_error;
+  EXPECT_THROW(miniJSON::json_schema("3"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"type": "text"})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"type": ["string", 1]})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"properties": []})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"required": "id"})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"minimum": "1"})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"minLength": -1})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"maxItems": 1.5})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"items": [{}]})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"enum": 1})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"pattern": 1})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"pattern": "["})"), error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"items": {"pattern": "a{2,1}"}})"),
+               error);
+  EXPECT_THROW(miniJSON::json_schema(R"({"{": 1)"),
+               miniJSON::json_parse_error);
+  try {
+    miniJSON::json_schema(R"({"properties": {"a/b": {"anyOf": []}}})");
+    FAIL();
+  } catch (const error &e) {
+    EXPECT_STREQ(e.what(),
+                 "json schema error: #/properties/a~1b/anyOf: keyword is not "
+                 "supported");
+  }
+}
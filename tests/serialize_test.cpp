@@ -0,0 +1,74 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(SerializeTest, Escape) {
+  {
+    // characters that cannot appear in JSON strings as is
+    miniJSON::json_node json = std::string("q\"b\\s/\b\f\n\r\t\x01\x1f\0", 14);
+    EXPECT_EQ(json.to_string(),
+              R"("q\"b\\s/\b\f\n\r\t\u0001\u001f\u0000")");
+  }
+  {
+    // clean runs on both sides of escaped characters
+    for (size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 64}) {
+      std::string text(n, 'a');
+      miniJSON::json_node json = text + "\"" + text + "\n" + text;
+      EXPECT_EQ(json.to_string(),
+                '"' + text + R"(\")" + text + R"(\n)" + text + '"');
+    }
+  }
+  {
+    // object keys are escaped
+    miniJSON::json_node json = {{"a\"b", 1}, {"c\nd", "e\tf"}};
+    EXPECT_EQ(json.to_string(), R"({"a\"b":1,"c\nd":"e\tf"})");
+    EXPECT_EQ(miniJSON::parse(json.to_string()), json);
+  }
+}
+
+TEST(SerializeTest, EnsureASCII) {
+  miniJSON::serialize_options options;
+  options.ensure_ascii = true;
+  {
+    // non-ASCII characters are escaped, beyond the BMP as surrogate pairs
+    miniJSON::json_node json = "A\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80z";
+    EXPECT_EQ(json.to_string(), "\"A\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80z\"");
+    EXPECT_EQ(json.to_string(options), R"("A\u00e9\u4e2d\ud83d\ude00z")");
+    EXPECT_EQ(miniJSON::parse(json.to_string(options)), json);
+  }
+  {
+    // non-ASCII characters after long ASCII runs
+    std::string text(40, 'a');
+    miniJSON::json_node json = {{text + "\xc3\xa9", text + "\n\xc3\xa9"}};
+    EXPECT_EQ(json.to_string(options),
+              "{\"" + text + R"(\u00e9":")" + text + R"(\n\u00e9"})");
+  }
+  {
+    // bytes that are not well-formed UTF-8 are replaced
+    miniJSON::json_node json = "a\xff" "b\xe4\xb8";
+    EXPECT_EQ(json.to_string(options), R"("a\ufffdb\ufffd\ufffd")");
+  }
+}
+
+TEST(SerializeTest, Indent) {
+  miniJSON::serialize_options options;
+  options.indent = 2;
+  auto json = miniJSON::parse(R"({"a":[1,{"b":null},[]],"c":{},"d":"e"})");
+  const char *expected = R"({
+  "a": [
+    1,
+    {
+      "b": null
+    },
+    []
+  ],
+  "c": {},
+  "d": "e"
+})";
+  EXPECT_EQ(json.to_string(options), expected);
+  EXPECT_EQ(json.freeze().root().to_string(options), expected);
+  EXPECT_EQ(miniJSON::json_node(1).to_string(options), "1");
+}
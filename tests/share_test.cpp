@@ -0,0 +1,115 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(ShareTest, Copy) {
+  {
+    // shared copies point to the same value
+    auto json = miniJSON::parse(R"({"a":{"b":[1,2]},"c":"str"})");
+    auto copy = json.share();
+    EXPECT_TRUE(json.is_shared());
+    EXPECT_TRUE(copy.is_shared());
+    EXPECT_EQ(copy.to_string(), json.to_string());
+    EXPECT_EQ(&copy.at("a"), &json.at("a"));
+  }
+  {
+    // deep copy of a shared node does not share
+    auto json = miniJSON::parse(R"({"a":[1,2]})");
+    auto copy = json.share();
+    miniJSON::json_node deep = copy;
+    EXPECT_FALSE(deep.is_shared());
+    EXPECT_EQ(deep.to_string(), R"({"a":[1,2]})");
+  }
+  {
+    // scalar nodes are never shared
+    miniJSON::json_node json = 1;
+    auto copy = json.share();
+    EXPECT_FALSE(copy.is_shared());
+    EXPECT_EQ(copy.get_integer(), 1);
+  }
+  {
+    // dropping the original keeps the shared value alive
+    miniJSON::json_node copy;
+    {
+      auto json = miniJSON::parse(R"(["abc",{"d":null}])");
+      copy = json.share();
+    }
+    EXPECT_FALSE(copy.is_shared());
+    EXPECT_EQ(copy.to_string(), R"(["abc",{"d":null}])");
+  }
+}
+
+TEST(ShareTest, Mutation) {
+  {
+    // only the path to the modified node is cloned
+    auto json = miniJSON::parse(R"({"a":{"b":[1,2]},"c":{"d":true}})");
+    auto copy = json.share();
+    copy["a"]["b"][0] = 3;
+    EXPECT_EQ(json.to_string(), R"({"a":{"b":[1,2]},"c":{"d":true}})");
+    EXPECT_EQ(copy.to_string(), R"({"a":{"b":[3,2]},"c":{"d":true}})");
+    EXPECT_FALSE(json.is_shared());
+    EXPECT_FALSE(copy.is_shared());
+    EXPECT_TRUE(json.at("c").is_shared());
+    EXPECT_FALSE(json.at("a").is_shared());
+  }
+  {
+    // builder and delete methods clone the shared value
+    auto json = miniJSON::parse(R"({"a":[1],"b":"x"})");
+    auto copy = json.share();
+    copy.erase("b");
+    copy["a"].push_back(2);
+    copy.insert("c", 3);
+    EXPECT_EQ(json.to_string(), R"({"a":[1],"b":"x"})");
+    EXPECT_EQ(copy.to_string(), R"({"a":[1,2],"c":3})");
+  }
+  {
+    // iterating over a shared array
+    auto json = miniJSON::parse(R"([1,2,3])");
+    auto copy = json.share();
+    for (auto &j : copy) {
+      EXPECT_NE(&j, &json.at(0));
+    }
+    copy.erase(0);
+    EXPECT_EQ(json.to_string(), R"([1,2,3])");
+    EXPECT_EQ(copy.to_string(), R"([2,3])");
+  }
+  {
+    // assigning to a shared copy leaves the original intact
+    auto json = miniJSON::parse(R"({"a":"str"})");
+    auto copy = json.share();
+    copy = nullptr;
+    EXPECT_FALSE(json.is_shared());
+    EXPECT_EQ(json.to_string(), R"({"a":"str"})");
+  }
+}
+
+TEST(ShareTest, At) {
+  {
+    auto json = miniJSON::parse(R"({"a":[1,{"b":2}]})");
+    EXPECT_EQ(json.at("a").at(1).at("b").get_integer(), 2);
+    EXPECT_THROW({ json.at("b"); }, std::out_of_range);
+    EXPECT_THROW({ json.at("a").at(2); }, std::out_of_range);
+    EXPECT_THROW({ json.at(0); }, miniJSON::json_type_error);
+    EXPECT_EQ(json.to_string(), R"({"a":[1,{"b":2}]})");
+  }
+}
+
+TEST(ShareTest, ConstAccess) {
+  {
+    // reading through a const node does not clone the shared value
+    auto json = miniJSON::parse(R"({"a":[1,{"b":2}]})");
+    auto copy = json.share();
+    const miniJSON::json_node &view = copy;
+    EXPECT_EQ(view["a"][1]["b"].get_integer(), 2);
+    EXPECT_EQ(&view["a"], &json.at("a"));
+    EXPECT_TRUE(json.is_shared());
+    EXPECT_TRUE(copy.is_shared());
+    EXPECT_THROW({ view["b"]; }, std::out_of_range);
+    EXPECT_THROW({ view["a"][2]; }, std::out_of_range);
+    EXPECT_THROW({ view[0]; }, miniJSON::json_type_error);
+    EXPECT_EQ(copy.to_string(), R"({"a":[1,{"b":2}]})");
+  }
+}
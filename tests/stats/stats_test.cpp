@@ -0,0 +1,88 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+/*
+  Checks for the instrumentation. This file is compiled with
+  MINIJSON_ENABLE_STATS, so it is built as a separate test program.
+*/
+
+namespace {
+struct recording_hook : miniJSON::stats_hook {
+  void on_parse(const miniJSON::json_stats &stats) override {
+    parses.push_back(stats);
+  }
+  void on_serialize(const miniJSON::json_stats &stats) override {
+    serializations.push_back(stats);
+  }
+  std::vector<miniJSON::json_stats> parses;
+  std::vector<miniJSON::json_stats> serializations;
+};
+}  // namespace
+
+TEST(StatsTest, Parse) {
+  using miniJSON::json_value_type;
+  miniJSON::reset_thread_stats();
+  std::string s = R"({"a":[1,2.5,"x",true,null],"b":{"c":"d"}})";
+  auto json = miniJSON::parse(s);
+  const miniJSON::json_stats &stats = miniJSON::thread_stats();
+  EXPECT_EQ(stats.bytes_parsed, s.size());
+  EXPECT_EQ(stats.node_count(json_value_type::object), 2);
+  EXPECT_EQ(stats.node_count(json_value_type::array), 1);
+  EXPECT_EQ(stats.node_count(json_value_type::string), 2);
+  EXPECT_EQ(stats.node_count(json_value_type::number_int), 1);
+  EXPECT_EQ(stats.node_count(json_value_type::number_double), 1);
+  EXPECT_EQ(stats.node_count(json_value_type::boolean), 1);
+  EXPECT_EQ(stats.node_count(json_value_type::null), 1);
+  EXPECT_EQ(stats.max_depth, 2);
+  // 8 child nodes, 2 objects, 1 array and 2 strings
+  EXPECT_EQ(stats.allocations, 13);
+  EXPECT_GT(stats.bytes_allocated, 13 * sizeof(miniJSON::json_node));
+  EXPECT_GT(stats.string_parse_ns, 0);
+  EXPECT_GT(stats.number_parse_ns, 0);
+  EXPECT_EQ(stats.serialize_ns, 0);
+
+  // statistics accumulate until they are reset
+  miniJSON::parse("[[[[1]]]]");
+  EXPECT_EQ(stats.bytes_parsed, s.size() + 9);
+  EXPECT_EQ(stats.node_count(json_value_type::array), 5);
+  EXPECT_EQ(stats.max_depth, 4);
+  miniJSON::reset_thread_stats();
+  EXPECT_EQ(stats.bytes_parsed, 0);
+  EXPECT_EQ(stats.allocations, 0);
+}
+
+TEST(StatsTest, Hook) {
+  recording_hook hook;
+  miniJSON::set_stats_hook(&hook);
+  miniJSON::reset_thread_stats();
+  auto json = miniJSON::parse(R"({"a":[1,2]})");
+  miniJSON::json_node invalid;
+  miniJSON::parse("[1,", &invalid);
+  std::string s = json.to_string();
+  miniJSON::set_stats_hook(nullptr);
+  miniJSON::parse("[]");
+
+  // every operation is reported on its own
+  ASSERT_EQ(hook.parses.size(), 2);
+  EXPECT_EQ(hook.parses[0].bytes_parsed, 11);
+  EXPECT_EQ(hook.parses[0].node_count(miniJSON::json_value_type::number_int),
+            2);
+  EXPECT_EQ(hook.parses[0].max_depth, 2);
+  EXPECT_EQ(hook.parses[1].bytes_parsed, 3);
+  EXPECT_EQ(hook.parses[1].max_depth, 1);
+  ASSERT_EQ(hook.serializations.size(), 1);
+  EXPECT_EQ(hook.serializations[0].bytes_serialized, s.size());
+  EXPECT_GT(hook.serializations[0].serialize_ns, 0);
+  EXPECT_EQ(hook.serializations[0].bytes_parsed, 0);
+
+  // while the thread statistics hold the sum of all of them
+  const miniJSON::json_stats &stats = miniJSON::thread_stats();
+  EXPECT_EQ(stats.bytes_parsed, 16);
+  EXPECT_EQ(stats.bytes_serialized, s.size());
+  EXPECT_EQ(stats.max_depth, 2);
+}
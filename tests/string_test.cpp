@@ -0,0 +1,85 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+TEST(StringTest, Escapes) {
+  {
+    // escape sequences are decoded
+    auto json = miniJSON::parse(R"(["a\"b","a\\b","a\/b","\b\f\n\r\t"])");
+    EXPECT_EQ(json[0].get_string(), "a\"b");
+    EXPECT_EQ(json[1].get_string(), "a\\b");
+    EXPECT_EQ(json[2].get_string(), "a/b");
+    EXPECT_EQ(json[3].get_string(), "\b\f\n\r\t");
+    EXPECT_EQ(json.to_string(), R"(["a\"b","a\\b","a/b","\b\f\n\r\t"])");
+  }
+  {
+    // unicode escapes are decoded into UTF-8
+    auto json = miniJSON::parse(
+        R"(["\u0041\u00e9\u4E2D","\ud83d\ude00","\u0000x","\u001f"])");
+    EXPECT_EQ(json[0].get_string(), "A\xc3\xa9\xe4\xb8\xad");
+    EXPECT_EQ(json[1].get_string(), "\xf0\x9f\x98\x80");
+    EXPECT_EQ(json[2].get_string(), std::string("\0x", 2));
+    EXPECT_EQ(json.to_string(),
+              "[\"A\xc3\xa9\xe4\xb8\xad\",\"\xf0\x9f\x98\x80\","
+              R"("\u0000x","\u001f"])");
+  }
+  {
+    // object keys are decoded and escaped as well
+    auto json = miniJSON::parse(R"({"a\nb":1,"c":2})");
+    EXPECT_EQ(json["a\nb"].get_integer(), 1);
+    EXPECT_EQ(json["c"].get_integer(), 2);
+    EXPECT_EQ(json.to_string(), R"({"a\nb":1,"c":2})");
+  }
+  {
+    // long strings spanning several SIMD blocks
+    for (size_t n : {15, 16, 17, 31, 32, 33, 100}) {
+      std::string text(n, 'x');
+      auto json = miniJSON::parse('"' + text + R"(\n)" + text + '"');
+      EXPECT_EQ(json.get_string(), text + '\n' + text);
+    }
+  }
+}
+
+TEST(StringTest, Errors) {
+  using code = miniJSON::parse_error_code;
+  struct error_case {
+    std::string json;
+    miniJSON::parse_error_code code;
+    size_t offset;
+  };
+  std::vector<error_case> cases = {
+      {R"("\u12")", code::invalid_escape, 2},
+      {R"("\u12g4")", code::invalid_escape, 2},
+      {R"("ab\uD83D")", code::invalid_escape, 4},
+      {R"("ab\uD83Dx")", code::invalid_escape, 4},
+      {R"("ab\uD83DA")", code::invalid_escape, 4},
+      {R"("ab\uDE00")", code::invalid_escape, 4},
+      {"\"ab\ncd\"", code::control_character, 3},
+      {std::string(40, ' ') + "\"" + std::string(20, 'a') + "\t\"",
+       code::control_character, 61},
+      {"\"ab\xff\"", code::invalid_utf8, 3},
+      {"\"ab\xc3\"", code::invalid_utf8, 3},
+      {"\"\xc0\xaf\"", code::invalid_utf8, 1},
+      {"\"\xe0\x80\xaf\"", code::invalid_utf8, 1},
+      {"\"\xed\xa0\x80\"", code::invalid_utf8, 1},
+      {"\"\xf4\x90\x80\x80\"", code::invalid_utf8, 1},
+      {"\"" + std::string(20, 'a') + "\xe4\xb8\"", code::invalid_utf8, 21},
+  };
+  for (auto &c : cases) {
+    miniJSON::json_node json;
+    auto res = miniJSON::parse(c.json, &json);
+    EXPECT_EQ(res.code, c.code) << c.json << ": " << res.message();
+    EXPECT_EQ(res.offset, c.offset) << c.json;
+  }
+  {
+    // well-formed multi-byte sequences
+    auto json = miniJSON::parse(
+        "[\"\xc2\x80\",\"\xed\x9f\xbf\",\"\xf0\x90\x80\x80\","
+        "\"\xf4\x8f\xbf\xbf\"]");
+    EXPECT_EQ(json[3].get_string(), "\xf4\x8f\xbf\xbf");
+  }
+}
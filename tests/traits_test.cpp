@@ -0,0 +1,237 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "miniJSON/miniJSON.h"
+
+namespace {
+size_t live_allocations = 0;
+
+/*
+  Allocator counting the allocations that have not been freed yet
+*/
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+  counting_allocator() = default;
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &) {}
+  T *allocate(size_t n) {
+    live_allocations++;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T *p, size_t n) {
+    live_allocations--;
+    std::allocator<T>().deallocate(p, n);
+  }
+};
+template <typename T, typename U>
+bool operator==(const counting_allocator<T> &, const counting_allocator<U> &) {
+  return true;
+}
+template <typename T, typename U>
+bool operator!=(const counting_allocator<T> &, const counting_allocator<U> &) {
+  return false;
+}
+
+struct compact_traits : miniJSON::default_json_traits {
+  using integer_type = int32_t;
+  using float_type = float;
+  template <typename Value>
+  using array_type = std::vector<Value, counting_allocator<Value>>;
+  template <typename T>
+  using allocator_type = counting_allocator<T>;
+};
+
+using compact_json = miniJSON::basic_json_node<compact_traits>;
+
+/*
+  Memory an arena_allocator draws from, counting the allocations that have
+  not been freed yet
+*/
+struct arena {
+  size_t live_allocations = 0;
+};
+
+/*
+  Stateful allocator: allocators of different arenas are unequal, and a
+  default constructed one draws from no arena
+*/
+template <typename T>
+struct arena_allocator {
+  using value_type = T;
+  arena_allocator() = default;
+  explicit arena_allocator(arena *a) : source(a) {}
+  template <typename U>
+  arena_allocator(const arena_allocator<U> &other) : source(other.source) {}
+  T *allocate(size_t n) {
+    if (source != nullptr) {
+      source->live_allocations++;
+    }
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T *p, size_t n) {
+    if (source != nullptr) {
+      source->live_allocations--;
+    }
+    std::allocator<T>().deallocate(p, n);
+  }
+  arena *source = nullptr;
+};
+template <typename T, typename U>
+bool operator==(const arena_allocator<T> &a, const arena_allocator<U> &b) {
+  return a.source == b.source;
+}
+template <typename T, typename U>
+bool operator!=(const arena_allocator<T> &a, const arena_allocator<U> &b) {
+  return a.source != b.source;
+}
+
+struct arena_traits : miniJSON::default_json_traits {
+  using string_type =
+      std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+  template <typename Key, typename Value>
+  using object_type =
+      ordered_map<Key, Value, arena_allocator<std::pair<const Key, Value>>>;
+  template <typename Value>
+  using array_type = std::vector<Value, arena_allocator<Value>>;
+  template <typename T>
+  using allocator_type = arena_allocator<T>;
+};
+
+using arena_json = miniJSON::basic_json_node<arena_traits>;
+}  // namespace
+
+TEST(TraitsTest, Types) {
+  static_assert(
+      std::is_same<miniJSON::json_node,
+                   miniJSON::basic_json_node<
+                       miniJSON::default_json_traits>>::value,
+      "json_node uses the default traits");
+  static_assert(std::is_same<compact_json::json_int_t, int32_t>::value,
+                "integer type of the traits");
+  static_assert(std::is_same<compact_json::json_double_t, float>::value,
+                "float type of the traits");
+  {
+    auto json = miniJSON::parse<compact_json>(
+        R"({"a":[1,2.5,"x"],"b":{"c":true},"d":-7})");
+    EXPECT_EQ(json.at("a").at(0).get_integer(), 1);
+    EXPECT_EQ(json.at("a").at(1).get_double(), 2.5f);
+    EXPECT_EQ(json.at("d").get_integer(), -7);
+    EXPECT_EQ(json.to_string(), R"({"a":[1,2.5,"x"],"b":{"c":true},"d":-7})");
+  }
+  {
+    // integers beyond the integer type are stored as floating point numbers
+    auto json = miniJSON::parse<compact_json>("[2147483647,2147483648]");
+    EXPECT_EQ(json.at(0).get_type(), miniJSON::json_value_type::number_int);
+    EXPECT_EQ(json.at(1).get_type(), miniJSON::json_value_type::number_double);
+    EXPECT_EQ(json.at(1).get_double(), 2147483648.0f);
+    EXPECT_TRUE(json.at(1) > json.at(0));
+    EXPECT_TRUE(compact_json(2147483647) < compact_json(2147483648.0));
+  }
+  {
+    // int and double literals are accepted
+    compact_json json;
+    json.emplace_back(1);
+    json.emplace_back(1.5);
+    json.emplace_back("s");
+    EXPECT_EQ(json.to_string(), R"([1,1.5,"s"])");
+    EXPECT_TRUE(compact_json(1) == compact_json(1.0));
+  }
+}
+
+TEST(TraitsTest, Allocator) {
+  ASSERT_EQ(live_allocations, 0);
+  {
+    auto json = miniJSON::parse<compact_json>(
+        R"({"a":[1,[2,[3]]],"b":{"c":"str"}})");
+    // nodes, the arrays with their storage, the objects and the string
+    EXPECT_GT(live_allocations, 10);
+    size_t allocations = live_allocations;
+    {
+      auto copy = json.share();
+      EXPECT_EQ(live_allocations, allocations);
+      copy["b"]["c"] = "changed";
+      EXPECT_GT(live_allocations, allocations);
+      EXPECT_EQ(json.at("b").at("c").get_string(), "str");
+    }
+    EXPECT_EQ(live_allocations, allocations);
+    json.erase("a");
+    EXPECT_LT(live_allocations, allocations);
+  }
+  EXPECT_EQ(live_allocations, 0);
+  {
+    // diff and patch work with nodes of any traits
+    auto source = miniJSON::parse<compact_json>(R"({"a":1,"b":[1,2]})");
+    auto target = miniJSON::parse<compact_json>(R"({"a":2,"b":[1],"c":1.5})");
+    auto patch = miniJSON::diff(source, target);
+    source.apply_patch(patch);
+    EXPECT_EQ(source, target);
+    source.apply_merge_patch(R"({"c":null})");
+    EXPECT_EQ(source.to_string(), R"({"a":2,"b":[1]})");
+
+    std::unordered_set<compact_json> set;
+    set.insert(source);
+    EXPECT_EQ(set.count(miniJSON::parse<compact_json>(R"({"b":[1],"a":2})")),
+              1);
+    EXPECT_EQ(source.freeze().root().at("a").get_integer(), 2);
+  }
+  EXPECT_EQ(live_allocations, 0);
+}
+
+TEST(TraitsTest, StatefulAllocator) {
+  arena a;
+  arena b;
+  arena_allocator<arena_json> in_a(&a);
+  arena_allocator<arena_json> in_b(&b);
+  {
+    // the parser builds the document with the allocator of the result
+    arena_json json(in_a);
+    miniJSON::basic_parser<arena_json> parser;
+    ASSERT_TRUE(parser.parse(R"({"name": "longer than the inline buffer",)"
+                             R"("list": [1, {"a key longer than that": 2}]})",
+                             &json));
+    size_t allocations = a.live_allocations;
+    EXPECT_GT(allocations, 10);
+    EXPECT_EQ(b.live_allocations, 0);
+    EXPECT_TRUE(json.at("list").at(1).get_allocator() == in_a);
+
+    // added nodes and values take the allocator of their parent
+    json["extra"] = "also longer than the inline buffer";
+    json["list"].push_back(arena_json("pushed and longer than the buffer"));
+    EXPECT_GT(a.live_allocations, allocations);
+    EXPECT_EQ(b.live_allocations, 0);
+
+    // a copy assigned to a node keeps the allocator of the node
+    arena_json copy(in_b);
+    copy = json;
+    EXPECT_EQ(copy, json);
+    EXPECT_GT(b.live_allocations, 10);
+    allocations = a.live_allocations;
+    copy["name"] = "changed in the copy, which is in the other arena";
+    EXPECT_EQ(a.live_allocations, allocations);
+    EXPECT_TRUE(arena_json(copy).get_allocator() == in_b);
+
+    // values moved between arenas are copied
+    copy.splice("moved", json, "list");
+    EXPECT_LT(a.live_allocations, allocations);
+    EXPECT_TRUE(copy.at("moved").at(1).get_allocator() == in_b);
+    EXPECT_EQ(copy.at("moved").at(2).get_string(),
+              "pushed and longer than the buffer");
+    arena_json moved(in_b);
+    moved = std::move(json);
+    EXPECT_EQ(json.get_type(), miniJSON::json_value_type::null);
+    EXPECT_EQ(moved.at("extra").get_string(),
+              "also longer than the inline buffer");
+    EXPECT_EQ(a.live_allocations, 0);
+  }
+  EXPECT_EQ(a.live_allocations, 0);
+  EXPECT_EQ(b.live_allocations, 0);
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 Zhichen (Joshua) Wen
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "./alloc-utils.h"
+#include "miniJSON/miniJSON.h"
+
+TEST(ValidateTest, SameAsParse) {
+  std::vector<std::string> inputs = {
+      "",
+      "  ",
+      "null",
+      " [1, -2.5e3, \"a\", true, false, null, {}, []] ",
+      R"({"a":{"b":[{"c":"é😀\n"}]},"d":""})",
+      "[",
+      "[1,",
+      "[1,]",
+      "[1 2]",
+      R"({"a":1)",
+      R"({"a":1,})",
+      R"({a:1})",
+      R"({"a" 1})",
+      "tru",
+      "[1, nul]",
+      "1.",
+      "-",
+      "1e",
+      R"("abc)",
+      "\"a\tb\"",
+      R"("\x")",
+      R"("\ud800")",
+      "\"\xff\"",
+      "[1] 2",
+      "]",
+  };
+  for (auto &input : inputs) {
+    miniJSON::json_node json;
+    auto expected = miniJSON::parse(input, &json);
+    auto res = miniJSON::validate(input);
+    EXPECT_EQ(res.code, expected.code) << input;
+    EXPECT_EQ(res.offset, expected.offset) << input;
+  }
+
+  std::vector<std::string> filenames = {
+      "../tests/data/random-parse-data-1.json",
+      "../tests/data/random-parse-data-2.json"};
+  for (auto &filename : filenames) {
+    std::ifstream in_file(filename);
+    std::stringstream ss;
+    ss << in_file.rdbuf();
+    std::string s = ss.str();
+    EXPECT_TRUE(miniJSON::validate(s.data(), s.size()));
+    // a truncated document is invalid
+    auto res = miniJSON::validate(s.data(), s.size() - 1);
+    EXPECT_EQ(res.code, miniJSON::parse_error_code::unexpected_end);
+  }
+}
+
+TEST(ValidateTest, Depth) {
+  std::string deep(2000, '[');
+  deep += std::string(2000, ']');
+  auto res = miniJSON::validate(deep);
+  EXPECT_EQ(res.code, miniJSON::parse_error_code::depth_exceeded);
+  EXPECT_EQ(res.offset, 512);
+
+  miniJSON::parse_options options;
+  options.max_depth = 2000;
+  EXPECT_TRUE(miniJSON::validate(deep, options));
+  options.max_depth = 1999;
+  EXPECT_FALSE(miniJSON::validate(deep, options));
+}
+
+TEST(ValidateTest, Allocations) {
+  std::string s = "[";
+  for (int i = 0; i < 100; i++) {
+    s += i == 0 ? "" : ",";
+    s += R"({"name":"a string long enough to be allocated","v":[1,2.5,3e2]})";
+  }
+  s += "]";
+  std::string deep = std::string(500, '[') + std::string(500, ']');
+  std::string invalid = R"([1, 2, {"a": tru}])";
+  allocation_counter counter;
+  EXPECT_TRUE(miniJSON::validate(s));
+  EXPECT_TRUE(miniJSON::validate(deep));
+  EXPECT_FALSE(miniJSON::validate(invalid));
+  EXPECT_EQ(counter.allocations(), 0);
+}